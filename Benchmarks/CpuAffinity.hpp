@@ -0,0 +1,7 @@
+#ifndef CPUAFFINITY_HPP
+#define CPUAFFINITY_HPP
+
+// Pin the calling thread to one core so a run isn't migrated between cores or caches
+bool pinToCore(int core);
+
+#endif
@@ -0,0 +1,251 @@
+#include "../Order_Book/Book.hpp"
+#include "../Process_Orders/Command.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+#include "CpuAffinity.hpp"
+#include "PerfCounters.hpp"
+#include "Report.hpp"
+#include "Stats.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// End to end benchmark: builds the initial book, replays the start of a command file
+// through OrderPipeline as a warmup and then times every remaining command, reporting
+// throughput and latency percentiles per directive as JSON. Command files are loaded into
+// memory up front in either format so parsing isn't part of the measurement.
+// With --counters the hardware counters are read around every command as well and their
+// mean per command is reported next to the latencies. The counter reads are outside the
+// timed window, the counters themselves include the two clock reads.
+//
+//   MacroBenchmark --commands orders.bin [--initial initialOrders.txt] [--warmup 100000]
+//                  [--core 2] [--counters] [--output run.json]
+//   MacroBenchmark --compare base.json candidate.json
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Parameters
+    {
+        std::string commandFile;
+        std::string initialFile;
+        long long warmup = 100000;
+        int core = -1;
+        bool counters = false;
+        std::string outputFile;
+    };
+
+    // Median cost of the two clock reads around every sample
+    double measureTimerOverhead()
+    {
+        std::vector<std::uint32_t> samples(100000);
+        for (std::uint32_t& sample : samples)
+        {
+            auto start = Clock::now();
+            auto stop = Clock::now();
+            sample = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        }
+        return percentile(samples, 0.5);
+    }
+
+    bool runBenchmark(const Parameters& parameters, Report& report)
+    {
+        std::vector<Command> initialCommands;
+        std::vector<Command> commands;
+        if (!parameters.initialFile.empty() && !readCommandFile(parameters.initialFile, initialCommands))
+        {
+            std::cerr << "Error reading initial orders: " << parameters.initialFile << std::endl;
+            return false;
+        }
+        if (!readCommandFile(parameters.commandFile, commands))
+        {
+            std::cerr << "Error reading commands: " << parameters.commandFile << std::endl;
+            return false;
+        }
+
+        if (parameters.core >= 0 && !pinToCore(parameters.core))
+        {
+            std::cerr << "Could not pin to core " << parameters.core << ", running unpinned" << std::endl;
+        }
+
+        Book* book = new Book();
+        OrderPipeline pipeline(book);
+        for (const Command& command : initialCommands)
+        {
+            pipeline.processCommand(command);
+        }
+
+        std::size_t warmup = static_cast<std::size_t>(std::min<long long>(std::max(parameters.warmup, 0LL), static_cast<long long>(commands.size())));
+        for (std::size_t i = 0; i < warmup; i++)
+        {
+            pipeline.processCommand(commands[i]);
+        }
+
+        // Reserve every sample up front so the timed loop never allocates
+        std::array<std::vector<std::uint32_t>, commandTypeCount> samples;
+        std::array<std::size_t, commandTypeCount> counts = {};
+        for (std::size_t i = warmup; i < commands.size(); i++)
+        {
+            counts[static_cast<std::size_t>(commands[i].type)]++;
+        }
+        for (std::size_t type = 0; type < commandTypeCount; type++)
+        {
+            samples[type].reserve(counts[type]);
+        }
+
+        PerfCounters perfCounters;
+        if (parameters.counters && !perfCounters.open())
+        {
+            std::cerr << "Could not open hardware counters, perf events may not be permitted" << std::endl;
+            return false;
+        }
+        std::array<PerfCounters::Values, commandTypeCount> counterTotals = {};
+        PerfCounters::Values before, after;
+
+        auto runStart = Clock::now();
+        for (std::size_t i = warmup; i < commands.size(); i++)
+        {
+            const Command& command = commands[i];
+            std::size_t type = static_cast<std::size_t>(command.type);
+            if (parameters.counters)
+            {
+                perfCounters.read(before);
+            }
+            auto start = Clock::now();
+            pipeline.processCommand(command);
+            auto stop = Clock::now();
+            if (parameters.counters)
+            {
+                perfCounters.read(after);
+                for (int counter = 0; counter < PerfCounters::counterCount; counter++)
+                {
+                    counterTotals[type][counter] += after[counter] - before[counter];
+                }
+            }
+            long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+            samples[type].push_back(static_cast<std::uint32_t>(std::min<long long>(nanoseconds, UINT32_MAX)));
+        }
+        auto runStop = Clock::now();
+        delete book;
+
+        report.commandFile = parameters.commandFile;
+        report.initialFile = parameters.initialFile;
+        report.core = parameters.core;
+        report.warmupCommands = static_cast<long long>(warmup);
+        report.measuredCommands = static_cast<long long>(commands.size() - warmup);
+        report.seconds = std::chrono::duration<double>(runStop - runStart).count();
+        report.throughput = report.seconds > 0 ? report.measuredCommands / report.seconds : 0;
+        report.timerOverhead = measureTimerOverhead();
+
+        std::vector<std::uint32_t> allSamples;
+        allSamples.reserve(commands.size() - warmup);
+        PerfCounters::Values allTotals = {};
+        for (std::size_t type = 0; type < commandTypeCount; type++)
+        {
+            if (samples[type].empty())
+            {
+                continue;
+            }
+            allSamples.insert(allSamples.end(), samples[type].begin(), samples[type].end());
+            LatencySummary& summary = report.directives[commandName(static_cast<CommandType>(type))];
+            summary = LatencySummary::fromSamples(samples[type]);
+            for (int counter = 0; counter < PerfCounters::counterCount; counter++)
+            {
+                allTotals[counter] += counterTotals[type][counter];
+                if (perfCounters.available(static_cast<PerfCounters::Counter>(counter)))
+                {
+                    summary.counters[PerfCounters::name(static_cast<PerfCounters::Counter>(counter))] = static_cast<double>(counterTotals[type][counter]) / summary.count;
+                }
+            }
+        }
+        LatencySummary& all = report.directives["All"];
+        all = LatencySummary::fromSamples(allSamples);
+        for (int counter = 0; counter < PerfCounters::counterCount; counter++)
+        {
+            if (perfCounters.available(static_cast<PerfCounters::Counter>(counter)) && all.count > 0)
+            {
+                all.counters[PerfCounters::name(static_cast<PerfCounters::Counter>(counter))] = static_cast<double>(allTotals[counter]) / all.count;
+            }
+        }
+        return true;
+    }
+
+    void printUsage()
+    {
+        std::cerr << "Usage: MacroBenchmark --commands <file> [--initial <file>] [--warmup <commands>] [--core <core>] [--counters] [--output <json>]\n"
+            << "       MacroBenchmark --compare <base json> <candidate json>" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Parameters parameters;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--compare" && i + 2 < argc)
+        {
+            Report base, candidate;
+            if (!readReport(argv[i + 1], base) || !readReport(argv[i + 2], candidate))
+            {
+                return 1;
+            }
+            compareReports(base, candidate, std::cout);
+            return 0;
+        }
+        if (argument == "--counters")
+        {
+            parameters.counters = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (argument == "--commands") parameters.commandFile = value;
+        else if (argument == "--initial") parameters.initialFile = value;
+        else if (argument == "--warmup") parameters.warmup = std::atoll(value.c_str());
+        else if (argument == "--core") parameters.core = std::atoi(value.c_str());
+        else if (argument == "--output") parameters.outputFile = value;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (parameters.commandFile.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    Report report;
+    if (!runBenchmark(parameters, report))
+    {
+        return 1;
+    }
+
+    if (parameters.outputFile.empty())
+    {
+        writeReport(report, std::cout);
+        return 0;
+    }
+    std::ofstream output(parameters.outputFile, std::ios::trunc);
+    if (!output.is_open())
+    {
+        std::cerr << "Error opening file for writing: " << parameters.outputFile << std::endl;
+        return 1;
+    }
+    writeReport(report, output);
+    std::cout << report.measuredCommands << " commands at " << static_cast<long long>(report.throughput)
+        << " commands per second, report written to " << parameters.outputFile << std::endl;
+    return 0;
+}
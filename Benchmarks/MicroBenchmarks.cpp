@@ -0,0 +1,277 @@
+#include "../Order_Book/Book.hpp"
+#include "../Order_Book/Limit.hpp"
+#include "../Order_Book/Order.hpp"
+#include "Stats.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Per operation microbenchmarks of the book engines.
+// Every round builds a fresh book with depth levels on each side and ordersPerLevel orders
+// on each level, then times a batch of one kind of operation against it. The time of a
+// round divided by its batch is one sample, the median and minimum over rounds are reported.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int centrePrice = 5000;
+    constexpr int restingShares = 100;
+    constexpr int addBatch = 1000;
+
+    struct Parameters
+    {
+        std::vector<int> depths = { 10, 100, 1000 };
+        std::vector<int> ordersPerLevel = { 1, 10, 100 };
+        std::vector<int> sweepLevels = { 1, 10 };
+        int rounds = 30;
+        std::string engine;       // Empty for every engine
+        std::string operation;    // Empty for every operation
+    };
+
+    // A book with bids at centrePrice - 1 down to centrePrice - depth and asks at
+    // centrePrice + 1 up to centrePrice + depth. Order ids are kept per level, head first.
+    template <typename BookT>
+    struct Fixture
+    {
+        std::unique_ptr<BookT> book = std::make_unique<BookT>();
+        std::vector<std::vector<int>> bidIds;
+        std::vector<std::vector<int>> askIds;
+        int nextId = 1;
+
+        Fixture(int depth, int ordersPerLevel) : bidIds(depth), askIds(depth)
+        {
+            for (int level = 0; level < depth; level++)
+            {
+                for (int i = 0; i < ordersPerLevel; i++)
+                {
+                    bidIds[level].push_back(nextId);
+                    book->addLimitOrder(nextId++, true, restingShares, centrePrice - 1 - level);
+                    askIds[level].push_back(nextId);
+                    book->addLimitOrder(nextId++, false, restingShares, centrePrice + 1 + level);
+                }
+            }
+        }
+    };
+
+    // Operation timed against a fixture, returns the number of operations it ran
+    template <typename BookT>
+    using Operation = std::function<int(Fixture<BookT>&)>;
+
+    // Untimed preparation of a fixture before the operation
+    template <typename BookT>
+    using Setup = std::function<void(Fixture<BookT>&)>;
+
+    template <typename BookT>
+    void run(const char* engine, const std::string& name, int depth, int ordersPerLevel, int rounds,
+        const Setup<BookT>& setup, const Operation<BookT>& operation)
+    {
+        std::vector<double> samples;
+        int batch = 0;
+        for (int round = 0; round < rounds; round++)
+        {
+            Fixture<BookT> fixture(depth, ordersPerLevel);
+            if (setup)
+            {
+                setup(fixture);
+            }
+            auto start = Clock::now();
+            batch = operation(fixture);
+            auto stop = Clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / batch);
+        }
+        double minimum = percentile(samples, 0.0);
+        double median = percentile(samples, 0.5);
+        std::printf("%-14s %-22s %7d %9d %7d %12.1f %12.1f\n", engine, name.c_str(), depth, ordersPerLevel, batch, median, minimum);
+    }
+
+    template <typename BookT>
+    void runEngine(const char* engine, const Parameters& parameters)
+    {
+        if (!parameters.engine.empty() && parameters.engine != engine)
+        {
+            return;
+        }
+        auto selected = [&parameters](const std::string& name) {
+            return parameters.operation.empty() || name.rfind(parameters.operation, 0) == 0;
+        };
+
+        for (int depth : parameters.depths)
+        {
+            for (int ordersPerLevel : parameters.ordersPerLevel)
+            {
+                auto bench = [&](const std::string& name, const Operation<BookT>& operation, const Setup<BookT>& setup = nullptr) {
+                    if (selected(name))
+                    {
+                        run<BookT>(engine, name, depth, ordersPerLevel, parameters.rounds, setup, operation);
+                    }
+                };
+
+                // Buy orders below the deepest bid, each creating a level
+                bench("add_new_level", [depth](Fixture<BookT>& fixture) {
+                    int count = std::min(addBatch, centrePrice - depth - 1);
+                    for (int i = 0; i < count; i++)
+                    {
+                        fixture.book->addLimitOrder(fixture.nextId++, true, restingShares, centrePrice - depth - 1 - i);
+                    }
+                    return count;
+                });
+
+                // Buy orders joining the queue of a random existing bid level
+                std::vector<int> levels(addBatch);
+                std::mt19937 gen(1);
+                std::uniform_int_distribution<> levelDist(0, depth - 1);
+                for (int& level : levels)
+                {
+                    level = levelDist(gen);
+                }
+                bench("add_existing_level", [&levels](Fixture<BookT>& fixture) {
+                    for (int level : levels)
+                    {
+                        fixture.book->addLimitOrder(fixture.nextId++, true, restingShares, centrePrice - 1 - level);
+                    }
+                    return static_cast<int>(levels.size());
+                });
+
+                // One cancel on every level of both sides at the given queue position
+                auto cancelAt = [depth](std::size_t position) {
+                    return [depth, position](Fixture<BookT>& fixture) {
+                        for (int level = 0; level < depth; level++)
+                        {
+                            fixture.book->cancelLimitOrder(fixture.bidIds[level][position]);
+                            fixture.book->cancelLimitOrder(fixture.askIds[level][position]);
+                        }
+                        return 2 * depth;
+                    };
+                };
+                bench("cancel_head", cancelAt(0));
+                bench("cancel_middle", cancelAt(ordersPerLevel / 2));
+                bench("cancel_tail", cancelAt(ordersPerLevel - 1));
+
+                // The middle order of every level moves to the next level further from the touch
+                bench("modify", [depth, ordersPerLevel](Fixture<BookT>& fixture) {
+                    for (int level = 0; level < depth; level++)
+                    {
+                        int newLevel = (level + 1) % depth;
+                        fixture.book->modifyLimitOrder(fixture.bidIds[level][ordersPerLevel / 2], restingShares, centrePrice - 1 - newLevel);
+                        fixture.book->modifyLimitOrder(fixture.askIds[level][ordersPerLevel / 2], restingShares, centrePrice + 1 + newLevel);
+                    }
+                    return 2 * depth;
+                });
+
+                // A market buy taking every order of the first levels of the asks
+                for (int sweepLevels : parameters.sweepLevels)
+                {
+                    if (sweepLevels > depth)
+                    {
+                        continue;
+                    }
+                    bench("sweep_" + std::to_string(sweepLevels), [sweepLevels, ordersPerLevel](Fixture<BookT>& fixture) {
+                        fixture.book->marketOrder(fixture.nextId++, true, static_cast<typename BookT::Quantity>(sweepLevels) * ordersPerLevel * restingShares);
+                        return 1;
+                    });
+                }
+
+                // ordersPerLevel stop buys behind the best ask, triggered by a market buy clearing the best ask.
+                // The time covers the market order and every stop it triggers.
+                if (depth >= 2)
+                {
+                    bench("stop_trigger", [ordersPerLevel](Fixture<BookT>& fixture) {
+                        fixture.book->marketOrder(fixture.nextId++, true, static_cast<typename BookT::Quantity>(ordersPerLevel) * restingShares);
+                        return 1;
+                    }, [ordersPerLevel](Fixture<BookT>& fixture) {
+                        for (int i = 0; i < ordersPerLevel; i++)
+                        {
+                            fixture.book->addStopOrder(fixture.nextId++, true, 1, centrePrice + 2);
+                        }
+                    });
+                }
+            }
+        }
+    }
+
+    bool parseList(const std::string& text, std::vector<int>& values)
+    {
+        values.clear();
+        std::istringstream iss(text);
+        std::string item;
+        while (std::getline(iss, item, ','))
+        {
+            try
+            {
+                values.push_back(std::stoi(item));
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+            if (values.back() <= 0)
+            {
+                return false;
+            }
+        }
+        return !values.empty();
+    }
+
+    void printUsage()
+    {
+        std::cerr << "Usage: MicroBenchmarks [--depth 10,100,1000] [--orders-per-level 1,10,100] [--sweep 1,10]\n"
+            << "                       [--rounds 30] [--engine avl_map|avl_flat|ladder_flat|ladder_dense|ladder_heap|ladder_pool] [--op name]\n"
+            << "Operations: add_new_level, add_existing_level, cancel_head, cancel_middle, cancel_tail, modify,\n"
+            << "            sweep_<levels>, stop_trigger. --op selects every operation starting with the name." << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Parameters parameters;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        bool ok = true;
+        if (argument == "--depth") ok = parseList(value, parameters.depths);
+        else if (argument == "--orders-per-level") ok = parseList(value, parameters.ordersPerLevel);
+        else if (argument == "--sweep") ok = parseList(value, parameters.sweepLevels);
+        else if (argument == "--rounds") ok = (parameters.rounds = std::atoi(value.c_str())) > 0;
+        else if (argument == "--engine") parameters.engine = value;
+        else if (argument == "--op") parameters.operation = value;
+        else ok = false;
+
+        if (!ok)
+        {
+            std::cerr << "Invalid argument " << argument << " " << value << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+    for (int depth : parameters.depths)
+    {
+        if (depth >= centrePrice - 1)
+        {
+            std::cerr << "Depth " << depth << " doesn't fit in the book" << std::endl;
+            return 1;
+        }
+    }
+
+    std::printf("%-14s %-22s %7s %9s %7s %12s %12s\n", "engine", "operation", "depth", "per_level", "batch", "median_ns", "min_ns");
+    runEngine<Book>("avl_map", parameters);
+    runEngine<PolicyBook<AVLPriceIndex, FlatHashOrderStore, IndexPoolAllocator, NullEventSink>>("avl_flat", parameters);
+    runEngine<PolicyBook<LadderPriceIndex, FlatHashOrderStore, IndexPoolAllocator, NullEventSink>>("ladder_flat", parameters);
+    runEngine<PolicyBook<LadderPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, NullEventSink>>("ladder_dense", parameters);
+    runEngine<PolicyBook<LadderPriceIndex, FlatHashOrderStore, HeapAllocator, NullEventSink>>("ladder_heap", parameters);
+    runEngine<PolicyBook<LadderPriceIndex, FlatHashOrderStore, PoolAllocator, NullEventSink>>("ladder_pool", parameters);
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "PerfCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace {
+    const char* const counterNames[PerfCounters::counterCount] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+    };
+}
+
+const char* PerfCounters::name(Counter counter)
+{
+    return counterNames[counter];
+}
+
+#ifdef __linux__
+
+namespace {
+    struct EventType
+    {
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+    const EventType eventTypes[PerfCounters::counterCount] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+    };
+
+    int openEvent(const EventType& eventType, int groupFd)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = eventType.type;
+        attr.config = eventType.config;
+        attr.disabled = groupFd < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            close(descriptor);
+        }
+    }
+}
+
+bool PerfCounters::open()
+{
+    int leader = -1;
+    for (int counter = 0; counter < counterCount; counter++)
+    {
+        int descriptor = openEvent(eventTypes[counter], leader);
+        if (descriptor < 0)
+        {
+            continue;
+        }
+        if (leader < 0)
+        {
+            leader = descriptor;
+        }
+        descriptors[counter] = descriptor;
+        positions[counter] = groupSize++;
+    }
+    if (leader < 0)
+    {
+        return false;
+    }
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::read(Values& values) const
+{
+    // Group read format: the number of counters followed by their values
+    std::uint64_t buffer[1 + counterCount] = {};
+    int leader = -1;
+    for (int descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            leader = descriptor;
+            break;
+        }
+    }
+    if (leader < 0 || ::read(leader, buffer, sizeof(buffer)) < 0)
+    {
+        values.fill(0);
+        return;
+    }
+    for (int counter = 0; counter < counterCount; counter++)
+    {
+        values[counter] = positions[counter] >= 0 ? buffer[1 + positions[counter]] : 0;
+    }
+}
+
+#else
+
+PerfCounters::~PerfCounters() {}
+
+bool PerfCounters::open()
+{
+    return false;
+}
+
+void PerfCounters::read(Values& values) const
+{
+    values.fill(0);
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef PERFCOUNTERS_HPP
+#define PERFCOUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Hardware counters of the calling thread, user space only, read together through one
+// perf_event_open group. Linux only, open fails elsewhere or when perf events aren't
+// permitted (see /proc/sys/kernel/perf_event_paranoid). Counters the CPU or hypervisor
+// doesn't support are left out and read as 0.
+class PerfCounters {
+public:
+	enum Counter {
+		Cycles,
+		Instructions,
+		L1DMisses,
+		LLCMisses,
+		BranchMisses,
+		counterCount
+	};
+	using Values = std::array<std::uint64_t, counterCount>;
+
+	static const char* name(Counter counter);
+
+	PerfCounters() = default;
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	~PerfCounters();
+
+	// True if at least one counter could be opened
+	bool open();
+	bool available(Counter counter) const { return descriptors[counter] >= 0; }
+	void read(Values& values) const;
+
+private:
+	std::array<int, counterCount> descriptors = { -1, -1, -1, -1, -1 };
+	// Position of each open counter in a group read
+	std::array<int, counterCount> positions = { -1, -1, -1, -1, -1 };
+	int groupSize = 0;
+};
+
+#endif
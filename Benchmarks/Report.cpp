@@ -0,0 +1,310 @@
+#include "Report.hpp"
+#include "Stats.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+
+namespace {
+    // Just enough JSON for reading reports back: objects, strings and numbers
+    struct JsonValue
+    {
+        double number = 0;
+        std::string text;
+        std::map<std::string, JsonValue> members;
+
+        const JsonValue* member(const std::string& name) const
+        {
+            auto it = members.find(name);
+            return it == members.end() ? nullptr : &it->second;
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string& _input) : input(_input) {}
+
+        bool parse(JsonValue& value)
+        {
+            return parseValue(value) && (skipSpace(), position == input.size());
+        }
+
+    private:
+        const std::string& input;
+        std::size_t position = 0;
+
+        void skipSpace()
+        {
+            while (position < input.size() && std::isspace(static_cast<unsigned char>(input[position])))
+            {
+                position++;
+            }
+        }
+
+        bool consume(char expected)
+        {
+            skipSpace();
+            if (position < input.size() && input[position] == expected)
+            {
+                position++;
+                return true;
+            }
+            return false;
+        }
+
+        bool parseString(std::string& text)
+        {
+            if (!consume('"'))
+            {
+                return false;
+            }
+            text.clear();
+            while (position < input.size() && input[position] != '"')
+            {
+                char c = input[position++];
+                if (c == '\\' && position < input.size())
+                {
+                    c = input[position++];
+                    c = c == 'n' ? '\n' : c == 't' ? '\t' : c;
+                }
+                text += c;
+            }
+            return consume('"');
+        }
+
+        bool parseValue(JsonValue& value)
+        {
+            skipSpace();
+            if (position >= input.size())
+            {
+                return false;
+            }
+            if (input[position] == '"')
+            {
+                return parseString(value.text);
+            }
+            if (input[position] != '{')
+            {
+                std::size_t end = position;
+                while (end < input.size() && (std::isdigit(static_cast<unsigned char>(input[end])) || std::strchr("+-.eE", input[end]) != nullptr))
+                {
+                    end++;
+                }
+                if (end == position)
+                {
+                    return false;
+                }
+                value.number = std::strtod(input.substr(position, end - position).c_str(), nullptr);
+                position = end;
+                return true;
+            }
+
+            position++;
+            if (consume('}'))
+            {
+                return true;
+            }
+            do
+            {
+                std::string name;
+                if (!parseString(name) || !consume(':') || !parseValue(value.members[name]))
+                {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+    };
+
+    void writeString(std::ostream& out, const std::string& text)
+    {
+        out << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+
+    double number(const JsonValue& object, const char* name)
+    {
+        const JsonValue* value = object.member(name);
+        return value == nullptr ? 0 : value->number;
+    }
+
+    void compareRow(std::ostream& out, const std::string& directive, const char* metric, double base, double candidate)
+    {
+        char row[160];
+        double change = base != 0 ? (candidate - base) / base * 100 : 0;
+        std::snprintf(row, sizeof(row), "%-18s %-12s %14.1f %14.1f %+9.1f%%\n", directive.c_str(), metric, base, candidate, change);
+        out << row;
+    }
+}
+
+LatencySummary LatencySummary::fromSamples(std::vector<std::uint32_t>& samples)
+{
+    LatencySummary summary;
+    summary.count = static_cast<long long>(samples.size());
+    if (samples.empty())
+    {
+        return summary;
+    }
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    summary.p50 = percentile(samples, 0.5);
+    summary.p90 = percentile(samples, 0.9);
+    summary.p99 = percentile(samples, 0.99);
+    summary.p999 = percentile(samples, 0.999);
+    summary.max = samples.back();
+    return summary;
+}
+
+void writeReport(const Report& report, std::ostream& out)
+{
+    std::streamsize precision = out.precision(12);
+    out << "{\n  \"commands_file\": ";
+    writeString(out, report.commandFile);
+    out << ",\n  \"initial_file\": ";
+    writeString(out, report.initialFile);
+    out << ",\n  \"core\": " << report.core
+        << ",\n  \"warmup_commands\": " << report.warmupCommands
+        << ",\n  \"measured_commands\": " << report.measuredCommands
+        << ",\n  \"seconds\": " << report.seconds
+        << ",\n  \"throughput_per_second\": " << report.throughput
+        << ",\n  \"timer_overhead_ns\": " << report.timerOverhead
+        << ",\n  \"directives\": {";
+
+    const char* separator = "\n";
+    for (const auto& [name, summary] : report.directives)
+    {
+        out << separator << "    ";
+        writeString(out, name);
+        out << ": {\"count\": " << summary.count << ", \"mean_ns\": " << summary.mean
+            << ", \"p50_ns\": " << summary.p50 << ", \"p90_ns\": " << summary.p90 << ", \"p99_ns\": " << summary.p99
+            << ", \"p999_ns\": " << summary.p999 << ", \"max_ns\": " << summary.max;
+        if (!summary.counters.empty())
+        {
+            const char* counterSeparator = "";
+            out << ", \"counters\": {";
+            for (const auto& [counter, mean] : summary.counters)
+            {
+                out << counterSeparator;
+                writeString(out, counter);
+                out << ": " << mean;
+                counterSeparator = ", ";
+            }
+            out << "}";
+        }
+        out << "}";
+        separator = ",\n";
+    }
+    out << "\n  }\n}\n";
+    out.precision(precision);
+}
+
+bool readReport(const std::string& filePath, Report& report)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening report: " << filePath << std::endl;
+        return false;
+    }
+    std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    JsonValue root;
+    if (!JsonParser(input).parse(root))
+    {
+        std::cerr << "Invalid report: " << filePath << std::endl;
+        return false;
+    }
+
+    report = Report();
+    if (const JsonValue* value = root.member("commands_file"))
+    {
+        report.commandFile = value->text;
+    }
+    if (const JsonValue* value = root.member("initial_file"))
+    {
+        report.initialFile = value->text;
+    }
+    report.core = static_cast<int>(number(root, "core"));
+    report.warmupCommands = static_cast<long long>(number(root, "warmup_commands"));
+    report.measuredCommands = static_cast<long long>(number(root, "measured_commands"));
+    report.seconds = number(root, "seconds");
+    report.throughput = number(root, "throughput_per_second");
+    report.timerOverhead = number(root, "timer_overhead_ns");
+
+    if (const JsonValue* directives = root.member("directives"))
+    {
+        for (const auto& [name, value] : directives->members)
+        {
+            LatencySummary& summary = report.directives[name];
+            summary.count = static_cast<long long>(number(value, "count"));
+            summary.mean = number(value, "mean_ns");
+            summary.p50 = number(value, "p50_ns");
+            summary.p90 = number(value, "p90_ns");
+            summary.p99 = number(value, "p99_ns");
+            summary.p999 = number(value, "p999_ns");
+            summary.max = number(value, "max_ns");
+            if (const JsonValue* counters = value.member("counters"))
+            {
+                for (const auto& [counter, mean] : counters->members)
+                {
+                    summary.counters[counter] = mean.number;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void compareReports(const Report& base, const Report& candidate, std::ostream& out)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-18s %-12s %14s %14s %10s\n", "directive", "metric", "base", "candidate", "change");
+    out << line;
+    compareRow(out, "All", "throughput", base.throughput, candidate.throughput);
+
+    for (const auto& [name, baseSummary] : base.directives)
+    {
+        auto it = candidate.directives.find(name);
+        if (it == candidate.directives.end())
+        {
+            out << name << " is missing from the candidate run\n";
+            continue;
+        }
+        const LatencySummary& candidateSummary = it->second;
+        compareRow(out, name, "count", static_cast<double>(baseSummary.count), static_cast<double>(candidateSummary.count));
+        compareRow(out, name, "mean_ns", baseSummary.mean, candidateSummary.mean);
+        compareRow(out, name, "p50_ns", baseSummary.p50, candidateSummary.p50);
+        compareRow(out, name, "p90_ns", baseSummary.p90, candidateSummary.p90);
+        compareRow(out, name, "p99_ns", baseSummary.p99, candidateSummary.p99);
+        compareRow(out, name, "p999_ns", baseSummary.p999, candidateSummary.p999);
+        compareRow(out, name, "max_ns", baseSummary.max, candidateSummary.max);
+        for (const auto& [counter, mean] : baseSummary.counters)
+        {
+            auto candidateCounter = candidateSummary.counters.find(counter);
+            if (candidateCounter != candidateSummary.counters.end())
+            {
+                compareRow(out, name, counter.c_str(), mean, candidateCounter->second);
+            }
+        }
+    }
+    for (const auto& [name, candidateSummary] : candidate.directives)
+    {
+        if (base.directives.find(name) == base.directives.end())
+        {
+            out << name << " is missing from the base run\n";
+        }
+    }
+}
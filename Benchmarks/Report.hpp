@@ -0,0 +1,45 @@
+#ifndef REPORT_HPP
+#define REPORT_HPP
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Latency distribution of one directive, in nanoseconds
+struct LatencySummary {
+	long long count = 0;
+	double mean = 0;
+	double p50 = 0;
+	double p90 = 0;
+	double p99 = 0;
+	double p999 = 0;
+	double max = 0;
+	// Mean hardware counter deltas per command by counter name, empty unless counters were read
+	std::map<std::string, double> counters;
+
+	// Sorts the samples
+	static LatencySummary fromSamples(std::vector<std::uint32_t>& samples);
+};
+
+// Result of one macro benchmark run, written and read as JSON
+struct Report {
+	std::string commandFile;
+	std::string initialFile;
+	int core = -1;
+	long long warmupCommands = 0;
+	long long measuredCommands = 0;
+	double seconds = 0;
+	double throughput = 0;       // Commands per second over the measured commands
+	double timerOverhead = 0;    // Nanoseconds a pair of clock reads adds to every sample
+	std::map<std::string, LatencySummary> directives;   // By command name, "All" covers every command
+};
+
+void writeReport(const Report& report, std::ostream& out);
+bool readReport(const std::string& filePath, Report& report);
+
+// Side by side table of two runs with the change of the candidate relative to the base
+void compareReports(const Report& base, const Report& candidate, std::ostream& out);
+
+#endif
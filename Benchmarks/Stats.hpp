@@ -0,0 +1,19 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Nearest rank percentile, fraction in [0, 1]. Sorts the samples in place.
+template <typename T>
+T percentile(std::vector<T>& samples, double fraction) {
+	if (samples.empty()) {
+		return T();
+	}
+	std::sort(samples.begin(), samples.end());
+	std::size_t rank = static_cast<std::size_t>(fraction * (samples.size() - 1) + 0.5);
+	return samples[std::min(rank, samples.size() - 1)];
+}
+
+#endif
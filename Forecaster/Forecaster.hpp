@@ -1,11 +1,45 @@
 #pragma once
+#include <algorithm>
 #include <string>
 #include <chrono>
+#include <cmath>
 #include <memory>
-#include <random>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <vector>
 #include <omp.h>
+#include "History.hpp"
+#include "Philox.hpp"
+#include "Sobol.hpp"
+#include "VectorMath.hpp"
+
+// Estimators of the mean path, each reports its standard error
+enum class VarianceReduction {
+    None,             // Independent pseudo-random paths
+    Antithetic,       // Pairs of paths driven by Z and -Z, the mean of a pair is one sample
+    ControlVariate,   // The log price, whose GBM expectation is known, as control variate
+    Sobol             // Randomised Sobol points with a Brownian bridge construction
+};
+
+// One symbol of a batch forecast, dataPath is its price history in the format of data.csv
+struct ForecastInput {
+    std::string symbol;
+    float spotPrice;
+    std::string dataPath;
+};
+
+// Forecast of one symbol, the vectors hold one entry per time step
+struct SymbolForecast {
+    std::string symbol;
+    float spotPrice = 0.0f;
+    float volatility = 0.0f;
+    int64_t paths = 0;
+    bool converged = false;             // Stopped early at the tolerance
+    std::vector<float> mean;
+    std::vector<float> standardErrors;
+    std::vector<float> bands;           // Prices of the bandQuantiles, laid out [step][band]
+};
 
 class Forecaster {
 public:
@@ -17,27 +51,81 @@ public:
         m_spotPrice = price;
     }
 
+    // Forecasts with the same seed are identical, whatever the thread count
+    void setSeed(uint64_t seed) {
+        m_seed = seed;
+    }
+
+    void setVarianceReduction(VarianceReduction mode) {
+        m_varianceReduction = mode;
+    }
+
+    // Paths per forecast are inLoops * outLoops, simulated in blocks of inLoops
+    void setLoops(int32_t inLoops, int32_t outLoops) {
+        m_inLoops = inLoops;
+        m_outLoops = outLoops;
+    }
+
+    void setTimeSteps(int32_t timeSteps) {
+        m_timeSteps = timeSteps;
+    }
+
+    // Volatility from the log returns of the last returns of the history, 0 for all of it
+    void setVolatilityWindow(int32_t returns) {
+        m_volatilityWindow = returns;
+    }
+
+    // Exponentially weighted volatility with the given decay per bar, e.g. 0.94, in place of
+    // the window. 0 turns it off.
+    void setEwmaDecay(float decay) {
+        m_ewmaDecay = decay;
+    }
+
+    // Stops a forecast once the standard error of every step is at most standardError,
+    // checked every toleranceBatch outer loops. 0 always simulates all the paths.
+    void setTolerance(float standardError) {
+        m_tolerance = standardError;
+    }
+
+    // File forecast and reforecast write to, see writeForecast. Empty writes nothing, the
+    // forecast is then only read through means, standardErrors and quantileBands.
+    void setOutputPath(const std::string& path) {
+        m_outputPath = path;
+    }
+
+    // Mean forecast price per time step, filled by forecast and reforecast
+    const std::vector<float>& means() const {
+        return m_forecast.mean;
+    }
+
+    // Standard error of the forecast price per time step
+    const std::vector<float>& standardErrors() const {
+        return m_forecast.standardErrors;
+    }
+
+    // Prices of the bandQuantiles per time step, laid out [step][band]
+    const std::vector<float>& quantileBands() const {
+        return m_forecast.bands;
+    }
+
     ~Forecaster() = default;
 
+    // Simulates only when the volatility or the settings differ from the last simulation,
+    // otherwise its price factors are rescaled to the spot price
     bool forecast(const std::string& dataPath) {
         const auto beginTime = std::chrono::system_clock::now();
 
-        // Allocate memory for stock price matrices
-        float** stock = new float* [inLoops];
-        for (int32_t i = 0; i < inLoops; i++) {
-            stock[i] = new float[timeSteps];
+        if (!validSize()) {
+            return false;
         }
-
-        float** avgStock = new float* [outLoops];
-        for (int32_t i = 0; i < outLoops; i++) {
-            avgStock[i] = new float[timeSteps];
+        if (!(m_spotPrice > 0.0f)) {
+            std::cerr << "Invalid spot price! Exiting..\n";
+            return false;
         }
 
         // Calculate volatility first
-        const float volatility = calculateVolatility(m_spotPrice, timeSteps, dataPath);
+        const float volatility = calculateVolatility(m_timeSteps, dataPath);
         if (volatility < 0) {
-            // Clean up and return on error
-            cleanup(stock, avgStock, nullptr);
             return false;
         }
 
@@ -47,55 +135,148 @@ public:
         std::cout << "==============================================\n\n";
         std::cout << "Using market volatility: " << volatility << "\n";
         std::cout << "Using spot price: " << m_spotPrice << "\n";
+        std::cout << "Using seed: " << m_seed << "\n";
+        std::cout << "Using variance reduction: " << varianceReductionName(m_varianceReduction) << "\n";
         std::cout << "Using " << m_numThreads << " thread(s)\n\n";
-        std::cout << "Computing forecasts... ";
 
-        static constexpr float riskRate = 0.001f;
+        if (cached(volatility, m_spotPrice)) {
+            std::cout << "Rescaling cached forecasts... ";
+        }
+        else {
+            std::cout << "Computing forecasts... ";
+
+            const Simulation simulation = prepareSimulation();
+            const PathConstants constants = pathConstants(volatility);
+            SharedSums shared(simulation, m_numThreads, m_timeSteps);
+            m_cache.factors = {};
+            m_cache.factors.spotPrice = 1.0f;
+            m_cache.factors.volatility = volatility;
+
+            // Main computation loop, the only parallel region of a forecast
+            #pragma omp parallel num_threads(m_numThreads)
+            {
+                ThreadBuffers buffers(simulation, m_sobolDirections.get(), m_brownianBridge.get());
+                runSymbol(simulation, constants, m_tolerance / m_spotPrice, m_cache.factors, shared, buffers);
+            }
+            storeCacheKey(m_tolerance / m_spotPrice);
+        }
+
+        if (!writeRescaled(m_spotPrice)) {
+            return false;
+        }
+
+        std::cout << "done!\nSimulated " << m_forecast.paths << " paths" << (m_forecast.converged ? ", within tolerance" : "") << "\n";
+        std::cout << "Standard error at the last step: " << m_forecast.standardErrors[m_timeSteps - 1] << "\n";
+        std::cout << "Time taken: " <<
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now() - beginTime).count() << "ms\n";
+
+        return true;
+    }
 
-        // Main computation loop
-        #pragma omp parallel
+    // Forecast for a new spot price at the volatility of the last forecast, without reading
+    // the history again. Prices are the spot price times factors that don't depend on it, so
+    // this rescales the cached factors in O(timeSteps) and writes them out like forecast.
+    // The paths are those of the last forecast, the tolerance isn't checked again.
+    bool reforecast(float spotPrice) {
+        if (!cachedSettings()) {
+            std::cerr << "No forecast with the current settings to rescale! Exiting..\n";
+            return false;
+        }
+        if (!(spotPrice > 0.0f)) {
+            std::cerr << "Invalid spot price! Exiting..\n";
+            return false;
+        }
+        m_spotPrice = spotPrice;
+        return writeRescaled(m_spotPrice);
+    }
+
+    // Forecasts every input in one parallel region with the settings of this forecaster,
+    // sharing the threads and their buffers. Symbols with few paths are packed side by side
+    // so the SIMD lanes of a block run several symbols; a symbol's forecast is the same as
+    // forecasting it alone. Results are in the order of the inputs and nothing is written
+    // to disk, see writeForecast.
+    bool forecastBatch(const std::vector<ForecastInput>& inputs, std::vector<SymbolForecast>& results) {
+        const auto beginTime = std::chrono::system_clock::now();
+
+        if (!validSize()) {
+            return false;
+        }
+
+        results.assign(inputs.size(), {});
+        std::vector<PathConstants> constants(inputs.size());
+        std::vector<float> tolerances(inputs.size());
+        for (size_t s = 0; s < inputs.size(); s++) {
+            if (!(inputs[s].spotPrice > 0.0f)) {
+                std::cerr << "Invalid spot price for " << inputs[s].symbol << "! Exiting..\n";
+                return false;
+            }
+            const float volatility = calculateVolatility(m_timeSteps, inputs[s].dataPath);
+            if (volatility < 0) {
+                return false;
+            }
+            results[s].symbol = inputs[s].symbol;
+            results[s].spotPrice = 1.0f;
+            results[s].volatility = volatility;
+            constants[s] = pathConstants(volatility);
+            tolerances[s] = m_tolerance / inputs[s].spotPrice;
+        }
+
+        std::cout << "Forecasting " << inputs.size() << " symbol(s) with " << m_numThreads << " thread(s)... ";
+
+        const Simulation simulation = prepareSimulation();
+        const bool packed = static_cast<int64_t>(m_outLoops) * simulation.samplesPerLoop < packedSymbolSamples;
+        const int32_t symbolCount = static_cast<int32_t>(inputs.size());
+        const int32_t groupCount = (symbolCount + packedGroupSymbols - 1) / packedGroupSymbols;
+        SharedSums shared(simulation, packed ? 0 : m_numThreads, m_timeSteps);
+
+        #pragma omp parallel num_threads(m_numThreads)
         {
-            #pragma omp for schedule(dynamic)
-            for (int32_t i = 0; i < outLoops; i++) {
-                for (int32_t j = 0; j < inLoops; j++) {
-                    float* prices = runBlackScholesModel(m_spotPrice, timeSteps, riskRate, volatility);
-                    for (int32_t k = 0; k < timeSteps; k++) {
-                        stock[j][k] = prices[k];
-                    }
-                    delete[] prices;
+            ThreadBuffers buffers(simulation, m_sobolDirections.get(), m_brownianBridge.get());
+            if (packed) {
+                // Every group of symbols is simulated by a single thread
+                #pragma omp for schedule(dynamic)
+                for (int32_t group = 0; group < groupCount; group++) {
+                    const int32_t first = group * packedGroupSymbols;
+                    runPacked(simulation, constants.data() + first, tolerances.data() + first, results.data() + first,
+                        std::min(packedGroupSymbols, symbolCount - first), buffers);
                 }
-                float* meanPrices = find2dMean(stock, inLoops, timeSteps);
-                for (int32_t k = 0; k < timeSteps; k++) {
-                    avgStock[i][k] = meanPrices[k];
+            }
+            else {
+                // All threads work on one symbol after the other
+                for (int32_t s = 0; s < symbolCount; s++) {
+                    runSymbol(simulation, constants[s], tolerances[s], results[s], shared, buffers);
                 }
-                delete[] meanPrices;
             }
         }
+        for (size_t s = 0; s < inputs.size(); s++) {
+            rescale(results[s], inputs[s].spotPrice);
+        }
+
+        std::cout << "done!\nTime taken: " <<
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now() - beginTime).count() << "ms\n";
 
-        // Calculate final average
-        float* optStock = find2dMean(avgStock, outLoops, timeSteps);
+        return true;
+    }
 
-        // Write results to file
+    // The mean, then the bandQuantiles, one line per time step
+    static bool writeForecast(const std::string& path, const SymbolForecast& result) {
         std::ofstream filePtr;
-        filePtr.open("D:/low-latency-trading-system/Forecaster/forecast.csv", std::ofstream::out);
+        filePtr.open(path, std::ofstream::out);
         if (!filePtr.is_open()) {
-            std::cerr << "Couldn't open forecast.csv! Exiting..\n";
-            cleanup(stock, avgStock, optStock);
+            std::cerr << "Couldn't open " << path << "! Exiting..\n";
             return false;
         }
 
-        for (int32_t i = 0; i < timeSteps; i++) {
-            filePtr << optStock[i] << "\n";
+        for (size_t i = 0; i < result.mean.size(); i++) {
+            filePtr << result.mean[i];
+            for (int32_t band = 0; band < bandCount; band++) {
+                filePtr << "," << result.bands[i * bandCount + band];
+            }
+            filePtr << "\n";
         }
         filePtr.close();
-
-        // Clean up allocated memory
-        cleanup(stock, avgStock, optStock);
-
-        std::cout << "done!\nTime taken: " <<
-            std::chrono::duration_cast<std::chrono::seconds>(
-                std::chrono::system_clock::now() - beginTime).count() << "s\n";
-
         return true;
     }
 
@@ -105,112 +286,700 @@ public:
     }
 
 private:
-    float calculateVolatility(float spotPrice, int32_t timeSteps, const std::string& dataPath) {
-        std::ifstream filePtr;
-        filePtr.open(dataPath, std::ifstream::in);
-        if (!filePtr.is_open()) {
-            std::cerr << "Cannot open " << dataPath << "! Exiting..\n";
+    // Volatility of the log price over the forecast horizon from the per bar volatility of
+    // the history, whose bars are the time steps
+    float calculateVolatility(int32_t timeSteps, const std::string& dataPath) {
+        if (m_ewmaDecay < 0.0f || m_ewmaDecay >= 1.0f) {
+            std::cerr << "Invalid EWMA decay! Exiting..\n";
             return -1.0f;
         }
-
-        std::string line;
-        if (!std::getline(filePtr, line)) {
-            std::cerr << "Cannot read from " << dataPath << "! Exiting..\n";
-            filePtr.close();
+        if (!history::loadPrices(dataPath, m_prices)) {
+            return -1.0f;
+        }
+        if (m_prices.size() < 2) {
+            std::cerr << "Not enough prices in " << dataPath << "! Exiting..\n";
             return -1.0f;
         }
-        filePtr.close();
-
-        int32_t i = 0, len = timeSteps - 1;
-        std::unique_ptr<float[]> priceArr = std::make_unique<float[]>(timeSteps - 1);
-        std::istringstream iss(line);
-        std::string token;
 
-        while (std::getline(iss, token, ',')) {
-            priceArr[i++] = std::stof(token);
+        float barVolatility;
+        if (m_ewmaDecay > 0.0f) {
+            barVolatility = history::ewmaVolatility(m_prices.data(), m_prices.size(), m_ewmaDecay);
+        }
+        else {
+            history::windowVolatilities(m_prices.data(), m_prices.size(), &m_volatilityWindow, 1, &barVolatility);
         }
+        return barVolatility * std::sqrt(static_cast<float>(timeSteps));
+    }
 
-        float sum = spotPrice;
-        for (i = 0; i < len; i++) {
-            sum += priceArr[i];
+    bool validSize() const {
+        // The control variate estimate fits two terms, its error needs a third sample
+        const int32_t samplesPerLoop = m_varianceReduction == VarianceReduction::Antithetic ? m_inLoops / 2 : m_inLoops;
+        if (m_inLoops < 2 || m_outLoops < 1 || m_timeSteps < 2 || static_cast<int64_t>(m_outLoops) * samplesPerLoop < 3) {
+            std::cerr << "Invalid simulation size! Exiting..\n";
+            return false;
         }
-        float meanPrice = sum / (len + 1);
+        if (m_varianceReduction == VarianceReduction::Sobol && m_timeSteps - 1 > sobol::maxDimensions) {
+            std::cerr << "Too many time steps for the Sobol directions! Exiting..\n";
+            return false;
+        }
+        // Every outer loop is a replicate of its own up to sobolReplicates, the error is their spread
+        if (m_varianceReduction == VarianceReduction::Sobol && m_outLoops < 2) {
+            std::cerr << "Sobol needs at least 2 outer loops! Exiting..\n";
+            return false;
+        }
+        return true;
+    }
 
-        sum = std::powf((spotPrice - meanPrice), 2.0f);
-        for (i = 0; i < len; i++) {
-            sum += std::powf((priceArr[i] - meanPrice), 2.0f);
+    // Rows of running sums per thread. Samples are the deviations z of S / S0 from its
+    // expectation exp(r * t), the control is the log price less its expectation. Both are
+    // in units of the standard deviation of the log price at the step, so the squares and
+    // their sums stay around 1 and keep the resolution of the fixed point whatever the
+    // volatility, and no variance is the difference of two large sums.
+    enum SumRow {
+        DeviationRow,
+        DeviationSquareRow,
+        ControlRow,
+        ControlSquareRow,
+        CrossRow,
+        ReplicateRow,       // Sum of d per Sobol replicate, one row for each of the 16
+        rowCount = ReplicateRow + 16
+    };
+
+    static const char* varianceReductionName(VarianceReduction mode) {
+        switch (mode) {
+        case VarianceReduction::Antithetic:
+            return "antithetic variates";
+        case VarianceReduction::ControlVariate:
+            return "control variate";
+        case VarianceReduction::Sobol:
+            return "Sobol with Brownian bridge";
+        default:
+            return "none";
         }
+    }
+
+    // Loop invariant terms of the discretised geometric Brownian motion of one symbol
+    struct PathConstants {
+        float drift;        // (r - sigma^2 / 2) * dt
+        float diffusion;    // sigma * sqrt(dt)
+    };
 
-        float stdDev = std::sqrtf(sum);
-        return stdDev / 100.0f;
+    PathConstants pathConstants(float volatility) const {
+        const float deltaT = 1.0f / m_timeSteps;
+        return { (riskRate - volatility * volatility / 2.0f) * deltaT, volatility * std::sqrt(deltaT) };
     }
 
-    float* find2dMean(float** matrix, int32_t numLoops, int32_t timeSteps) {
-        float* avg = new float[timeSteps];
+    // Sizes of a forecast that are the same for every symbol
+    struct Simulation {
+        int32_t samplesPerLoop;
+        int32_t blockCount;             // Blocks of simdLanes samples per outer loop
+        int32_t dimensions;             // Normal draws a path uses
+        int32_t normalSteps;            // Draws per path, rounded up to whole Philox counters
+        int32_t sumStride;              // Running sums of a row, whole 64 byte lines
+        int32_t batchLoops;
+        bool sobol;                     // Paths come from the Sobol points, not from Philox
+        std::vector<uint32_t> sobolShifts;
+        std::vector<float> expectedDeviations;  // expectedDeviation of every step
+        std::vector<float> stepRoots;           // sqrt(k), logDeviation is the diffusion times it
+    };
+
+    Simulation prepareSimulation() {
+        Simulation simulation;
+        // Antithetic pairs count as one sample, so an outer loop still simulates inLoops paths
+        simulation.samplesPerLoop = m_varianceReduction == VarianceReduction::Antithetic ? m_inLoops / 2 : m_inLoops;
+        simulation.blockCount = (simulation.samplesPerLoop + simdLanes - 1) / simdLanes;
+        simulation.dimensions = m_timeSteps - 1;
+        simulation.normalSteps = (simulation.dimensions + 3) / 4 * 4;
+        simulation.sumStride = (m_timeSteps + 7) / 8 * 8;
+        simulation.expectedDeviations.resize(m_timeSteps);
+        simulation.stepRoots.resize(m_timeSteps);
+        for (int32_t k = 0; k < m_timeSteps; k++) {
+            simulation.expectedDeviations[k] = expectedDeviation(k);
+            simulation.stepRoots[k] = std::sqrt(static_cast<float>(k));
+        }
+
+        // With a tolerance the outer loops run in batches, the sums only ever grow so the
+        // result of a given number of batches doesn't depend on where the run stopped
+        simulation.batchLoops = m_tolerance > 0.0f ? std::min(toleranceBatch, m_outLoops) : m_outLoops;
+
+        // Sobol points are split into replicates by outer loop, each randomised by a digital
+        // shift of its own. The directions outlive a Sobol forecast, so only the mode says
+        // which generator the paths come from.
+        simulation.sobol = m_varianceReduction == VarianceReduction::Sobol;
+        if (simulation.sobol) {
+            const int32_t dimensions = simulation.dimensions;
+            if (!m_sobolDirections || m_sobolDirections->dimensions() != dimensions) {
+                m_sobolDirections = std::make_unique<sobol::Directions>(dimensions);
+                m_brownianBridge = std::make_unique<sobol::BrownianBridge>(dimensions);
+            }
+            simulation.sobolShifts.resize(static_cast<size_t>(sobolReplicates) * dimensions);
+            for (int32_t replicate = 0; replicate < sobolReplicates; replicate++) {
+                for (int32_t dimension = 0; dimension < dimensions; dimension++) {
+                    simulation.sobolShifts[static_cast<size_t>(replicate) * dimensions + dimension] = philox::generate(
+                        { static_cast<uint32_t>(dimension), static_cast<uint32_t>(replicate), 0, shiftStream }, m_seed).word[0];
+                }
+            }
+        }
+        return simulation;
+    }
 
-        for (int32_t i = 0; i < timeSteps; i++) {
-            float sum = 0.0f;
-            #pragma omp parallel for reduction(+:sum)
-            for (int32_t j = 0; j < numLoops; j++) {
-                sum += matrix[j][i];
+    // Where the samples of a run of lanes go: one symbol and, for Sobol, one replicate
+    struct LaneTarget {
+        int32_t begin;
+        int32_t end;
+        int64_t* sums;              // rowCount rows of sumStride
+        int64_t* replicateSums;     // Row of the lanes' replicate, nullptr unless Sobol
+        uint32_t* histogram;        // [step][bin]
+        PathConstants constants;
+    };
+
+    // Inputs of one block of simdLanes samples
+    struct LaneBlock {
+        alignas(64) float drift[simdLanes];
+        alignas(64) float diffusion[simdLanes];
+        uint64_t sources[simdLanes];            // Philox path or Sobol point of each lane
+        const uint32_t* shifts[simdLanes];      // Sobol shift of each lane
+        LaneTarget targets[simdLanes];
+        int32_t targetCount;
+    };
+
+    // Buffers of each thread, allocated once per forecast and shared by all its symbols
+    struct ThreadBuffers {
+        ThreadBuffers(const Simulation& simulation, const sobol::Directions* directions, const sobol::BrownianBridge* bridge)
+            : normRand(static_cast<size_t>(simulation.normalSteps) * simdLanes) {
+            if (simulation.sobol) {
+                sobolPaths = std::make_unique<sobol::PathGenerator>(*directions, *bridge);
             }
-            avg[i] = sum / numLoops;
         }
 
-        return avg;
+        std::vector<float> normRand;            // Normal draws of one block, [step][lane]
+        std::unique_ptr<sobol::PathGenerator> sobolPaths;
+        LaneBlock lanes;
+        std::vector<int64_t> groupSums;         // Sums and histograms of a packed group
+        std::vector<uint32_t> groupHistograms;
+    };
+
+    // Running sums and histograms of the threads working on one symbol together
+    struct SharedSums {
+        SharedSums(const Simulation& simulation, int32_t threads, int32_t timeSteps)
+            : threadSums(static_cast<size_t>(threads) * rowCount * simulation.sumStride),
+            totals(static_cast<size_t>(rowCount) * timeSteps),
+            histograms(static_cast<size_t>(threads) * timeSteps * histogramBins) {
+        }
+
+        std::vector<int64_t> threadSums;        // rowCount rows per thread, padded to whole lines
+        std::vector<int64_t> totals;
+        std::vector<uint32_t> histograms;       // One per thread, [step][bin]
+        int32_t loopsDone = 0;
+        bool converged = false;
+    };
+
+    // Factors of the last simulation: its forecast for a spot price of 1, valid for the
+    // volatility and settings it was simulated with
+    struct ForecastCache {
+        bool valid = false;
+        SymbolForecast factors;
+        uint64_t seed;
+        VarianceReduction mode;
+        int32_t inLoops;
+        int32_t outLoops;
+        int32_t timeSteps;
+        float tolerance;        // Relative to the spot price
+    };
+
+    void storeCacheKey(float tolerance) {
+        m_cache.valid = true;
+        m_cache.seed = m_seed;
+        m_cache.mode = m_varianceReduction;
+        m_cache.inLoops = m_inLoops;
+        m_cache.outLoops = m_outLoops;
+        m_cache.timeSteps = m_timeSteps;
+        m_cache.tolerance = tolerance;
+    }
+
+    // Whether the cached factors were simulated with the current settings
+    bool cachedSettings() const {
+        return m_cache.valid && m_cache.seed == m_seed && m_cache.mode == m_varianceReduction &&
+            m_cache.inLoops == m_inLoops && m_cache.outLoops == m_outLoops && m_cache.timeSteps == m_timeSteps;
+    }
+
+    // Whether the cached factors are the ones a simulation at this volatility and spot price
+    // would give. A run that stopped at a tolerance also serves any looser one, a run of all
+    // the paths serves every tolerance; the slack absorbs the rounding of a tolerance that
+    // is set in proportion to the spot price.
+    bool cached(float volatility, float spotPrice) const {
+        return cachedSettings() && m_cache.factors.volatility == volatility &&
+            (!m_cache.factors.converged || m_cache.tolerance <= m_tolerance / spotPrice * (1.0f + toleranceSlack));
+    }
+
+    // Prices of a forecast for a spot price of 1 at the given spot price
+    static void rescale(SymbolForecast& forecast, float spotPrice) {
+        for (float& price : forecast.mean) {
+            price *= spotPrice;
+        }
+        for (float& error : forecast.standardErrors) {
+            error *= spotPrice;
+        }
+        for (float& price : forecast.bands) {
+            price *= spotPrice;
+        }
+        forecast.spotPrice = spotPrice;
+    }
+
+    bool writeRescaled(float spotPrice) {
+        m_forecast = m_cache.factors;
+        rescale(m_forecast, spotPrice);
+        return m_outputPath.empty() || writeForecast(m_outputPath, m_forecast);
     }
 
-    float genRand(float mean, float stdDev) {
-        static thread_local std::random_device rd;
-        static thread_local std::mt19937 generator(rd());
-        std::normal_distribution<float> distribution(mean, stdDev);
-        return distribution(generator);
+    // Philox path, Sobol point and replicate of sample j of a symbol, the same wherever the
+    // sample is simulated: within outer loop i, block b and lane l it is path
+    // (i * blockCount + b) * simdLanes + l, so padding lanes get path indices of their own
+    // and no path is drawn twice. Sobol points are numbered within the replicate.
+    struct SampleSource {
+        uint64_t path;
+        uint64_t point;
+        int32_t replicate;
+    };
+
+    static SampleSource sampleSource(const Simulation& simulation, int64_t j) {
+        const int64_t i = j / simulation.samplesPerLoop;
+        const int64_t r = j % simulation.samplesPerLoop;
+        return { static_cast<uint64_t>((i * simulation.blockCount + r / simdLanes) * simdLanes + r % simdLanes),
+            static_cast<uint64_t>((i / sobolReplicates) * simulation.samplesPerLoop + r),
+            static_cast<int32_t>(i % sobolReplicates) };
     }
 
-    float* runBlackScholesModel(float spotPrice, int32_t timeSteps, float riskRate, float volatility) {
-        static constexpr float mean = 0.0f, stdDev = 1.0f;
-        float deltaT = 1.0f / timeSteps;
-        std::unique_ptr<float[]> normRand = std::make_unique<float[]>(timeSteps - 1);
-        float* stockPrice = new float[timeSteps];
-        stockPrice[0] = spotPrice;
+    void fillNormals(const Simulation& simulation, ThreadBuffers& buffers) const {
+        if (buffers.sobolPaths) {
+            buffers.sobolPaths->fillNormals(buffers.lanes.shifts, buffers.lanes.sources, buffers.normRand.data());
+        }
+        else {
+            philox::fillNormals(m_seed, buffers.lanes.sources, pathStream, simulation.normalSteps, buffers.normRand.data());
+        }
+    }
 
-        for (int32_t i = 0; i < timeSteps - 1; i++) {
-            normRand[i] = genRand(mean, stdDev);
+    // Simulates one symbol with every thread of the enclosing parallel region, which must
+    // all call it. The tolerance is in the units of the result, whose spot price scales it.
+    void runSymbol(const Simulation& simulation, const PathConstants& constants, float tolerance, SymbolForecast& result, SharedSums& shared,
+        ThreadBuffers& buffers) const {
+        const int32_t sumStride = simulation.sumStride;
+        const size_t histogramSize = static_cast<size_t>(m_timeSteps) * histogramBins;
+        int64_t* sums = shared.threadSums.data() + static_cast<size_t>(omp_get_thread_num()) * rowCount * sumStride;
+        uint32_t* histogram = shared.histograms.data() + static_cast<size_t>(omp_get_thread_num()) * histogramSize;
+        std::fill(sums, sums + static_cast<size_t>(rowCount) * sumStride, 0);
+        std::fill(histogram, histogram + histogramSize, 0);
+
+        LaneBlock& lanes = buffers.lanes;
+        std::fill(lanes.drift, lanes.drift + simdLanes, constants.drift);
+        std::fill(lanes.diffusion, lanes.diffusion + simdLanes, constants.diffusion);
+        lanes.targetCount = 1;
+        lanes.targets[0] = { 0, 0, sums, nullptr, histogram, constants };
+
+        #pragma omp single
+        {
+            shared.loopsDone = 0;
+            shared.converged = false;
+            result.bands.assign(static_cast<size_t>(m_timeSteps) * bandCount, result.spotPrice);
         }
 
-        for (int32_t i = 0; i < timeSteps - 1; i++) {
-            stockPrice[i + 1] = stockPrice[i] * exp(
-                ((riskRate - (std::powf(volatility, 2.0f) / 2.0f)) * deltaT) +
-                (volatility * normRand[i] * std::sqrtf(deltaT))
-            );
+        // Every thread sees the same loopsDone and converged after the barrier of the
+        // single block, so they all leave the loop together
+        while (shared.loopsDone < m_outLoops && !shared.converged) {
+            const int32_t batchEnd = std::min(shared.loopsDone + simulation.batchLoops, m_outLoops);
+
+            #pragma omp for schedule(dynamic)
+            for (int32_t i = shared.loopsDone; i < batchEnd; i++) {
+                for (int32_t block = 0; block < simulation.blockCount; block++) {
+                    // The sources of sampleSource, padding lanes simply continue the numbering
+                    const int32_t replicate = i % sobolReplicates;
+                    const uint64_t firstSource = buffers.sobolPaths ?
+                        static_cast<uint64_t>(i / sobolReplicates) * simulation.samplesPerLoop + block * simdLanes :
+                        (static_cast<uint64_t>(i) * simulation.blockCount + block) * simdLanes;
+                    for (int32_t lane = 0; lane < simdLanes; lane++) {
+                        lanes.sources[lane] = firstSource + lane;
+                        lanes.shifts[lane] = buffers.sobolPaths ? simulation.sobolShifts.data() + static_cast<size_t>(replicate) * simulation.dimensions : nullptr;
+                    }
+                    lanes.targets[0].end = std::min(simdLanes, simulation.samplesPerLoop - block * simdLanes);
+                    lanes.targets[0].replicateSums = buffers.sobolPaths ? sums + static_cast<size_t>(ReplicateRow + replicate) * sumStride : nullptr;
+                    fillNormals(simulation, buffers);
+                    simulateBlock(lanes, buffers.normRand.data(), simulation);
+                }
+            }
+
+            // After the barrier of the loop above every thread reduces a block of columns
+            // over the rows of all threads, reading the rows sequentially
+            #pragma omp for schedule(static)
+            for (int32_t first = 0; first < m_timeSteps; first += columnBlock) {
+                const int32_t last = std::min(first + columnBlock, m_timeSteps);
+                for (int32_t row = 0; row < rowCount; row++) {
+                    int64_t columnSums[columnBlock] = {};
+                    for (int32_t j = 0; j < m_numThreads; j++) {
+                        const int64_t* sumRow = shared.threadSums.data() + (static_cast<size_t>(j) * rowCount + row) * sumStride;
+                        for (int32_t k = first; k < last; k++) {
+                            columnSums[k - first] += sumRow[k];
+                        }
+                    }
+                    std::copy(columnSums, columnSums + (last - first), shared.totals.data() + static_cast<size_t>(row) * m_timeSteps + first);
+                }
+            }
+
+            // Calculate the average so far and check it against the tolerance
+            #pragma omp single
+            {
+                shared.loopsDone = batchEnd;
+                estimate(shared.totals.data(), m_timeSteps, simulation, constants, shared.loopsDone, result);
+                shared.converged = withinTolerance(simulation, shared.loopsDone, tolerance, result);
+                result.converged = shared.converged;
+            }
         }
 
-        return stockPrice;
+        // Quantile bands once the paths are done, the histograms of a step are merged into
+        // the first thread's
+        #pragma omp for schedule(static)
+        for (int32_t k = 1; k < m_timeSteps; k++) {
+            uint32_t* merged = shared.histograms.data() + static_cast<size_t>(k) * histogramBins;
+            for (int32_t j = 1; j < m_numThreads; j++) {
+                const uint32_t* counts = shared.histograms.data() + j * histogramSize + static_cast<size_t>(k) * histogramBins;
+                for (int32_t bin = 0; bin < histogramBins; bin++) {
+                    merged[bin] += counts[bin];
+                }
+            }
+            quantiles(constants, k, merged, result.spotPrice, result.bands.data() + static_cast<size_t>(k) * bandCount);
+        }
     }
 
-    void cleanup(float** stock, float** avgStock, float* optStock) {
-        if (stock) {
-            for (int32_t i = 0; i < inLoops; i++) {
-                delete[] stock[i];
+    // Simulates count symbols with few paths on the calling thread, their samples one after
+    // the other across the lanes so a block can hold the last samples of one symbol and the
+    // first of the next. The outer loops run in the same batches as runSymbol, after each
+    // one the symbols within their tolerance drop out and the rest are packed again.
+    void runPacked(const Simulation& simulation, const PathConstants* constants, const float* tolerances, SymbolForecast* results,
+        int32_t count, ThreadBuffers& buffers) const {
+        const int32_t sumStride = simulation.sumStride;
+        const size_t sumsSize = static_cast<size_t>(rowCount) * sumStride;
+        const size_t histogramSize = static_cast<size_t>(m_timeSteps) * histogramBins;
+        buffers.groupSums.assign(count * sumsSize, 0);
+        buffers.groupHistograms.assign(count * histogramSize, 0);
+
+        std::vector<int32_t> running(count);
+        for (int32_t s = 0; s < count; s++) {
+            running[s] = s;
+        }
+        std::vector<int64_t> totals(static_cast<size_t>(rowCount) * m_timeSteps);
+
+        LaneBlock& lanes = buffers.lanes;
+        int32_t loopsDone = 0;
+        while (!running.empty()) {
+            const int32_t batchEnd = std::min(loopsDone + simulation.batchLoops, m_outLoops);
+            const int64_t firstSample = static_cast<int64_t>(loopsDone) * simulation.samplesPerLoop;
+            const int64_t endSample = static_cast<int64_t>(batchEnd) * simulation.samplesPerLoop;
+            size_t next = 0;
+            int64_t sample = firstSample;
+            while (next < running.size()) {
+                lanes.targetCount = 0;
+                for (int32_t lane = 0; lane < simdLanes; lane++) {
+                    if (next == running.size()) {
+                        // Padding after the last symbol, simulated but not counted
+                        lanes.drift[lane] = 0.0f;
+                        lanes.diffusion[lane] = 0.0f;
+                        lanes.sources[lane] = 0;
+                        lanes.shifts[lane] = lanes.shifts[0];
+                        continue;
+                    }
+
+                    const int32_t symbol = running[next];
+                    const SampleSource source = sampleSource(simulation, sample);
+                    int64_t* sums = buffers.groupSums.data() + symbol * sumsSize;
+                    int64_t* replicateSums = buffers.sobolPaths ? sums + static_cast<size_t>(ReplicateRow + source.replicate) * sumStride : nullptr;
+                    lanes.drift[lane] = constants[symbol].drift;
+                    lanes.diffusion[lane] = constants[symbol].diffusion;
+                    lanes.sources[lane] = buffers.sobolPaths ? source.point : source.path;
+                    lanes.shifts[lane] = buffers.sobolPaths ? simulation.sobolShifts.data() + static_cast<size_t>(source.replicate) * simulation.dimensions : nullptr;
+
+                    LaneTarget* target = lanes.targetCount ? &lanes.targets[lanes.targetCount - 1] : nullptr;
+                    if (target && target->sums == sums && target->replicateSums == replicateSums) {
+                        target->end = lane + 1;
+                    }
+                    else {
+                        lanes.targets[lanes.targetCount++] = { lane, lane + 1, sums, replicateSums,
+                            buffers.groupHistograms.data() + symbol * histogramSize, constants[symbol] };
+                    }
+
+                    if (++sample == endSample) {
+                        next++;
+                        sample = firstSample;
+                    }
+                }
+                fillNormals(simulation, buffers);
+                simulateBlock(lanes, buffers.normRand.data(), simulation);
+            }
+            loopsDone = batchEnd;
+
+            // Calculate the average so far of every running symbol and check it against its tolerance
+            size_t kept = 0;
+            for (const int32_t s : running) {
+                const int64_t* sums = buffers.groupSums.data() + s * sumsSize;
+                for (int32_t row = 0; row < rowCount; row++) {
+                    std::copy(sums + static_cast<size_t>(row) * sumStride, sums + static_cast<size_t>(row) * sumStride + m_timeSteps,
+                        totals.data() + static_cast<size_t>(row) * m_timeSteps);
+                }
+                estimate(totals.data(), m_timeSteps, simulation, constants[s], loopsDone, results[s]);
+                results[s].converged = withinTolerance(simulation, loopsDone, tolerances[s], results[s]);
+                if (!results[s].converged && loopsDone < m_outLoops) {
+                    running[kept++] = s;
+                }
             }
-            delete[] stock;
+            running.resize(kept);
         }
 
-        if (avgStock) {
-            for (int32_t i = 0; i < outLoops; i++) {
-                delete[] avgStock[i];
+        for (int32_t s = 0; s < count; s++) {
+            results[s].bands.assign(static_cast<size_t>(m_timeSteps) * bandCount, results[s].spotPrice);
+            for (int32_t k = 1; k < m_timeSteps; k++) {
+                quantiles(constants[s], k, buffers.groupHistograms.data() + s * histogramSize + static_cast<size_t>(k) * histogramBins,
+                    results[s].spotPrice, results[s].bands.data() + static_cast<size_t>(k) * bandCount);
             }
-            delete[] avgStock;
         }
+    }
+
+    // Mean price and its standard error per time step from the totals of the sum rows,
+    // laid out [row][step]
+    void estimate(const int64_t* totals, int32_t stride, const Simulation& simulation, const PathConstants& constants, int32_t loopsDone,
+        SymbolForecast& result) const {
+        const int32_t samplesPerLoop = simulation.samplesPerLoop;
+        const double samples = static_cast<double>(loopsDone) * samplesPerLoop;
+        const int32_t pathsPerLoop = m_varianceReduction == VarianceReduction::Antithetic ? 2 * samplesPerLoop : samplesPerLoop;
+        result.paths = static_cast<int64_t>(loopsDone) * pathsPerLoop;
+        result.mean.assign(m_timeSteps, result.spotPrice);
+        result.standardErrors.assign(m_timeSteps, 0.0f);
+
+        for (int32_t k = 0; k < m_timeSteps; k++) {
+            const auto total = [&](int32_t row) {
+                return static_cast<double>(totals[static_cast<size_t>(row) * stride + k]) / fixedScale;
+            };
+            // Mean and error of z, scaled back to a deviation of the price at the end
+            double mean = total(DeviationRow) / samples;
+            double variance = std::max(0.0, total(DeviationSquareRow) / samples - mean * mean);
+            double error = std::sqrt(variance / (samples - 1.0));
+
+            if (m_varianceReduction == VarianceReduction::ControlVariate) {
+                // Regression estimator with the variance minimising coefficient
+                const double controlMean = total(ControlRow) / samples;
+                const double controlVariance = total(ControlSquareRow) / samples - controlMean * controlMean;
+                const double covariance = total(CrossRow) / samples - controlMean * mean;
+                const double beta = controlVariance > 0.0 ? covariance / controlVariance : 0.0;
+                mean -= beta * controlMean;
+                error = std::sqrt(std::max(0.0, variance - beta * covariance) / (samples - 2.0));
+            }
+            else if (m_varianceReduction == VarianceReduction::Sobol) {
+                // Replicates are independent, the spread of their means gives the error. A
+                // replicate gets every sobolReplicates-th outer loop, so early on some may be empty.
+                double replicateMeans[sobolReplicates];
+                double meanOfMeans = 0.0;
+                int32_t replicates = 0;
+                for (int32_t replicate = 0; replicate < sobolReplicates && replicate < loopsDone; replicate++) {
+                    const double loops = (loopsDone - replicate + sobolReplicates - 1) / sobolReplicates;
+                    replicateMeans[replicates] = total(ReplicateRow + replicate) / (loops * samplesPerLoop);
+                    meanOfMeans += replicateMeans[replicates++];
+                }
+                meanOfMeans /= replicates;
+                double spread = 0.0;
+                for (int32_t replicate = 0; replicate < replicates; replicate++) {
+                    spread += (replicateMeans[replicate] - meanOfMeans) * (replicateMeans[replicate] - meanOfMeans);
+                }
+                // A single replicate has no spread to tell its error by
+                error = replicates > 1 ? std::sqrt(spread / (replicates * (replicates - 1.0))) : std::numeric_limits<double>::infinity();
+            }
+
+            const double unit = logDeviation(constants, k);
+            result.mean[k] = static_cast<float>(result.spotPrice * (1.0 + expectedDeviation(k) + unit * mean));
+            result.standardErrors[k] = static_cast<float>(result.spotPrice * unit * error);
+        }
+    }
+
+    // Whether a run may stop at its tolerance. The Sobol error is only trusted once every
+    // replicate has paths, before that it comes from a few replicates' means.
+    static bool withinTolerance(const Simulation& simulation, int32_t loopsDone, float tolerance, const SymbolForecast& result) {
+        return tolerance > 0.0f && (!simulation.sobol || loopsDone >= sobolReplicates) &&
+            *std::max_element(result.standardErrors.begin(), result.standardErrors.end()) <= tolerance;
+    }
 
-        if (optStock) {
-            delete[] optStock;
+    // Expected deviation exp(r * t) - 1 of S / S0 at step k, the same for every symbol
+    float expectedDeviation(int32_t k) const {
+        return std::expm1(riskRate * k / m_timeSteps);
+    }
+
+    // Standard deviation of the log price at step k, the unit of the summed deviations
+    static float logDeviation(const PathConstants& constants, int32_t k) {
+        return constants.diffusion * std::sqrt(static_cast<float>(k));
+    }
+
+    // Histogram bin of a log price at step k: bins of 1 / binsPerStdDev standard deviations
+    // of the log price around its expectation, the outermost ones take everything beyond
+    static float binScale(const PathConstants& constants, int32_t k) {
+        return constants.diffusion > 0.0f ? binsPerStdDev / (constants.diffusion * std::sqrt(static_cast<float>(k))) : 0.0f;
+    }
+
+    VECMATH_INLINE static int32_t binOf(float logRatio, float expectedLogRatio, float scale) {
+        const float bin = (logRatio - expectedLogRatio) * scale + histogramBins / 2;
+        return static_cast<int32_t>(std::clamp(bin, 0.0f, histogramBins - 1.0f));
+    }
+
+    // Prices of the bandQuantiles at step k from its histogram, interpolating linearly
+    // within the bin a quantile falls in
+    static void quantiles(const PathConstants& constants, int32_t k, const uint32_t* counts, float spotPrice, float* bands) {
+        uint64_t paths = 0;
+        for (int32_t bin = 0; bin < histogramBins; bin++) {
+            paths += counts[bin];
+        }
+        const float scale = binScale(constants, k);
+
+        uint64_t below = 0;
+        int32_t bin = 0;
+        for (int32_t band = 0; band < bandCount; band++) {
+            const double rank = bandQuantiles[band] * paths;
+            while (bin < histogramBins - 1 && below + counts[bin] < rank) {
+                below += counts[bin++];
+            }
+            const double position = bin + (counts[bin] ? (rank - below) / counts[bin] : 0.5);
+            const double logRatio = constants.drift * k + (scale > 0.0f ? (position - histogramBins / 2) / scale : 0.0);
+            bands[band] = static_cast<float>(spotPrice * std::exp(logRatio));
+        }
+    }
+
+    // Fixed point value of a sum term, truncating biases a sum by less than one unit per term
+    VECMATH_INLINE static int64_t toFixed(float value) {
+        return static_cast<int64_t>(value * fixedScale);
+    }
+
+    // Black-Scholes paths of simdLanes lanes side by side, each lane with the drift and
+    // diffusion of its symbol. The normal draws are laid out [step][lane]. The log of S / S0
+    // is accumulated so every step costs one multiply-add and one vector exp per register,
+    // and the samples of each target's lanes are added to the running sums of their step.
+    // The sums are fixed point integers so they come out the same whatever order the
+    // threads add their samples in. Every loop over lanes runs the whole register, lanes
+    // outside a target are masked to 0, which adds nothing to a sum.
+    void simulateBlock(const LaneBlock& lanes, const float* normRand, const Simulation& simulation) const {
+        const VarianceReduction mode = m_varianceReduction;
+        const int32_t sumStride = simulation.sumStride;
+        alignas(64) float logRatio[simdLanes] = {};
+        alignas(64) float mirrorLogRatio[simdLanes] = {};
+        alignas(64) float deviation[simdLanes];
+        alignas(64) float mirrorDeviation[simdLanes];
+        alignas(64) int32_t bins[simdLanes];
+
+        // Step 0 is the spot price itself, its sums stay 0
+        for (int32_t k = 1; k < m_timeSteps; k++) {
+            const float* draws = normRand + static_cast<size_t>(k - 1) * simdLanes;
+            #pragma omp simd
+            for (int32_t lane = 0; lane < simdLanes; lane++) {
+                logRatio[lane] += lanes.drift[lane] + lanes.diffusion[lane] * draws[lane];
+                mirrorLogRatio[lane] += lanes.drift[lane] - lanes.diffusion[lane] * draws[lane];
+            }
+
+            vecmath::expLanes(logRatio, deviation);
+            if (mode == VarianceReduction::Antithetic) {
+                vecmath::expLanes(mirrorLogRatio, mirrorDeviation);
+                #pragma omp simd
+                for (int32_t lane = 0; lane < simdLanes; lane++) {
+                    deviation[lane] = 0.5f * (deviation[lane] + mirrorDeviation[lane]);
+                }
+            }
+            // Centred on the expectation, and clamped so a single runaway path can't overflow the sums
+            const float expected = simulation.expectedDeviations[k];
+            #pragma omp simd
+            for (int32_t lane = 0; lane < simdLanes; lane++) {
+                deviation[lane] = std::min(deviation[lane] - 1.0f, maxDeviation) - expected;
+            }
+
+            for (int32_t t = 0; t < lanes.targetCount; t++) {
+                const LaneTarget& target = lanes.targets[t];
+                const int32_t begin = target.begin, end = target.end;
+                const float expectedLogRatio = target.constants.drift * k;
+                // logDeviation and binScale from the step roots of the simulation
+                const float unit = target.constants.diffusion * simulation.stepRoots[k];
+                const float perUnit = unit > 0.0f ? 1.0f / unit : 0.0f;
+                const float scale = target.constants.diffusion > 0.0f ? binsPerStdDev / unit : 0.0f;
+
+                // Every path counts in the histograms, both of an antithetic pair. The bins
+                // are found for the whole register, only the counting is per lane.
+                uint32_t* counts = target.histogram + static_cast<size_t>(k) * histogramBins;
+                #pragma omp simd
+                for (int32_t lane = 0; lane < simdLanes; lane++) {
+                    bins[lane] = binOf(logRatio[lane], expectedLogRatio, scale);
+                }
+                for (int32_t lane = begin; lane < end; lane++) {
+                    counts[bins[lane]]++;
+                }
+                if (mode == VarianceReduction::Antithetic) {
+                    #pragma omp simd
+                    for (int32_t lane = 0; lane < simdLanes; lane++) {
+                        bins[lane] = binOf(mirrorLogRatio[lane], expectedLogRatio, scale);
+                    }
+                    for (int32_t lane = begin; lane < end; lane++) {
+                        counts[bins[lane]]++;
+                    }
+                }
+
+                int64_t* sums = target.sums;
+                int64_t sum = 0, square = 0;
+                #pragma omp simd reduction(+ : sum, square)
+                for (int32_t lane = 0; lane < simdLanes; lane++) {
+                    const float z = lane >= begin && lane < end ? deviation[lane] * perUnit : 0.0f;
+                    sum += toFixed(z);
+                    square += toFixed(z * z);
+                }
+                sums[DeviationRow * sumStride + k] += sum;
+                sums[DeviationSquareRow * sumStride + k] += square;
+
+                if (mode == VarianceReduction::ControlVariate) {
+                    int64_t control = 0, controlSquare = 0, cross = 0;
+                    #pragma omp simd reduction(+ : control, controlSquare, cross)
+                    for (int32_t lane = 0; lane < simdLanes; lane++) {
+                        const float x = lane >= begin && lane < end ? (logRatio[lane] - expectedLogRatio) * perUnit : 0.0f;
+                        control += toFixed(x);
+                        controlSquare += toFixed(x * x);
+                        cross += toFixed(x * deviation[lane] * perUnit);
+                    }
+                    sums[ControlRow * sumStride + k] += control;
+                    sums[ControlSquareRow * sumStride + k] += controlSquare;
+                    sums[CrossRow * sumStride + k] += cross;
+                }
+                if (target.replicateSums) {
+                    target.replicateSums[k] += sum;
+                }
+            }
         }
     }
 
     int m_numThreads;
     float m_spotPrice;
-    static constexpr int32_t inLoops = 100;     // Inner loop iterations
-    static constexpr int32_t outLoops = 10000;  // Outer loop iterations
-    static constexpr int32_t timeSteps = 180;   // Stock market time-intervals (min)
-};
\ No newline at end of file
+    uint64_t m_seed = 0x5EEDF0CA57ull;
+    VarianceReduction m_varianceReduction = VarianceReduction::None;
+    SymbolForecast m_forecast;     // Last forecast at m_spotPrice
+    ForecastCache m_cache;
+    std::unique_ptr<sobol::Directions> m_sobolDirections;      // Built by the first Sobol forecast of a size
+    std::unique_ptr<sobol::BrownianBridge> m_brownianBridge;
+    int32_t m_inLoops = 100;       // Inner loop iterations
+    int32_t m_outLoops = 10000;    // Outer loop iterations
+    int32_t m_timeSteps = 180;     // Stock market time-intervals (min)
+    float m_tolerance = 0.0f;      // Standard error to stop at, 0 for none
+    std::string m_outputPath = "D:/low-latency-trading-system/Forecaster/forecast.csv";
+    int32_t m_volatilityWindow = 0;
+    float m_ewmaDecay = 0.0f;
+    std::vector<float> m_prices;   // History being read, kept to reuse its memory
+    static constexpr float riskRate = 0.001f;
+    static constexpr int32_t toleranceBatch = 512;                                 // Outer loops between checks, a multiple of sobolReplicates
+    static constexpr int32_t columnBlock = 16;                                     // Time steps each thread reduces at a time
+    static constexpr int32_t sobolReplicates = rowCount - ReplicateRow;            // Digitally shifted copies of the Sobol points
+    static constexpr uint32_t pathStream = 0;                                      // Philox streams of the normal draws
+    static constexpr uint32_t shiftStream = 1;                                     // and of the Sobol shifts
+    static constexpr float fixedScale = 4294967296.0f;                             // 2^32 units per unit of a sum term
+    static constexpr float maxDeviation = 1024.0f;
+    static constexpr float toleranceSlack = 1e-5f;                                 // Relative, for comparing cached tolerances
+    static constexpr int32_t histogramBins = 1024;                                 // Per step and thread, 4 KB
+    static constexpr float binsPerStdDev = 64.0f;                                  // Bins cover 8 standard deviations each side
+    static constexpr int32_t bandCount = 5;
+    static constexpr double bandQuantiles[bandCount] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+    static constexpr int64_t packedSymbolSamples = 4096;                           // Symbols with fewer samples are packed
+    static constexpr int32_t packedGroupSymbols = 16;                              // Symbols a packed group holds, each with its own sums
+};
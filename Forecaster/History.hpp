@@ -0,0 +1,247 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "VectorMath.hpp"
+
+// Price histories for the volatility estimate. A history is a file of prices in chronological
+// order, separated by commas or line breaks, so one row like data.csv and years of minute bars
+// one per line are read the same way. The file is mapped into memory and parsed in place.
+namespace history {
+    // Read only mapping of a whole file, unmapped when destroyed
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() {
+            close();
+        }
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size)) {
+                close();
+                return false;
+            }
+            m_size = static_cast<size_t>(size.QuadPart);
+            if (m_size == 0) {
+                return true;    // Empty files can't be mapped, there is nothing to read either
+            }
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_mapping) {
+                close();
+                return false;
+            }
+            m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+            m_file = ::open(path.c_str(), O_RDONLY);
+            if (m_file < 0) {
+                return false;
+            }
+            struct stat status;
+            if (fstat(m_file, &status) != 0) {
+                close();
+                return false;
+            }
+            m_size = static_cast<size_t>(status.st_size);
+            if (m_size == 0) {
+                return true;
+            }
+            void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+            if (data == MAP_FAILED) {
+                close();
+                return false;
+            }
+            m_data = static_cast<const char*>(data);
+            madvise(data, m_size, MADV_SEQUENTIAL);
+#endif
+            if (!m_data) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (m_data) {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping) {
+                CloseHandle(m_mapping);
+            }
+            if (m_file != INVALID_HANDLE_VALUE) {
+                CloseHandle(m_file);
+            }
+            m_mapping = nullptr;
+            m_file = INVALID_HANDLE_VALUE;
+#else
+            if (m_data) {
+                munmap(const_cast<char*>(m_data), m_size);
+            }
+            if (m_file >= 0) {
+                ::close(m_file);
+            }
+            m_file = -1;
+#endif
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        const char* data() const {
+            return m_data;
+        }
+
+        size_t size() const {
+            return m_size;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+        const char* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    inline bool isSeparator(char c) {
+        return c == ',' || c == '\n' || c == '\r' || c == ' ' || c == '\t';
+    }
+
+    // Appends the prices of a history file to prices, which is cleared first. Every price
+    // must be a positive number.
+    inline bool loadPrices(const std::string& path, std::vector<float>& prices) {
+        MappedFile file;
+        if (!file.open(path)) {
+            std::cerr << "Cannot open " << path << "! Exiting..\n";
+            return false;
+        }
+
+        prices.clear();
+        const char* position = file.data();
+        const char* const end = position + file.size();
+        // Minute bars take around ten characters each, reserving for that avoids most regrowth
+        prices.reserve(file.size() / 10);
+        while (position < end) {
+            if (isSeparator(*position)) {
+                position++;
+                continue;
+            }
+            float price;
+            const std::from_chars_result parsed = std::from_chars(position, end, price);
+            if (parsed.ec != std::errc() || !(price > 0.0f) || (parsed.ptr < end && !isSeparator(*parsed.ptr))) {
+                std::cerr << "Invalid price at byte " << position - file.data() << " of " << path << "! Exiting..\n";
+                return false;
+            }
+            prices.push_back(price);
+            position = parsed.ptr;
+        }
+        return true;
+    }
+
+    // Sums of the log returns of prices[first, last + 1)
+    struct ReturnSums {
+        double sum = 0.0;
+        double square = 0.0;
+        size_t count = 0;
+    };
+
+    inline void addReturns(const float* prices, size_t first, size_t last, ReturnSums& sums) {
+        double sum = 0.0, square = 0.0;
+        #pragma omp simd reduction(+:sum, square)
+        for (size_t i = first; i < last; i++) {
+            const float logReturn = vecmath::log(prices[i + 1] / prices[i]);
+            sum += logReturn;
+            square += logReturn * logReturn;
+        }
+        sums.sum += sum;
+        sums.square += square;
+        sums.count += last - first;
+    }
+
+    // Sample standard deviation of the log returns per bar over the trailing windows of the
+    // given numbers of returns, 0 or more than the history has for all of it. The windows
+    // nest, so they are summed newest first in one pass, each return read once.
+    inline void windowVolatilities(const float* prices, size_t count, const int32_t* windows, int32_t windowCount, float* volatilities) {
+        const size_t returns = count > 1 ? count - 1 : 0;
+        std::vector<int32_t> order(windowCount);
+        for (int32_t w = 0; w < windowCount; w++) {
+            order[w] = w;
+        }
+        const auto length = [&](int32_t w) {
+            return windows[w] > 0 ? std::min(static_cast<size_t>(windows[w]), returns) : returns;
+        };
+        std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) { return length(a) < length(b); });
+
+        ReturnSums sums;
+        for (const int32_t w : order) {
+            addReturns(prices, returns - length(w), returns - sums.count, sums);
+            const double n = static_cast<double>(sums.count);
+            const double variance = n > 1.0 ? (sums.square - sums.sum * sums.sum / n) / (n - 1.0) : 0.0;
+            volatilities[w] = static_cast<float>(std::sqrt(std::max(0.0, variance)));
+        }
+    }
+
+    // Weight below which older returns no longer change an exponentially weighted estimate
+    inline constexpr float ewmaCutoff = 1e-7f;
+
+    // Exponentially weighted standard deviation of the log returns per bar, the newest with
+    // weight 1 and each older one decay times the next, around a mean of zero as in
+    // RiskMetrics. Weights are normalised by their sum so short histories aren't biased low,
+    // and returns whose weight falls below ewmaCutoff are never read.
+    inline float ewmaVolatility(const float* prices, size_t count, float decay) {
+        alignas(64) float laneWeights[simdLanes];
+        float weight = 1.0f;
+        for (int32_t lane = 0; lane < simdLanes; lane++) {
+            laneWeights[lane] = weight;
+            weight *= decay;
+        }
+        const float blockDecay = weight;
+
+        double weighted = 0.0, weights = 0.0;
+        float blockWeight = 1.0f;
+        for (size_t end = count > 1 ? count - 1 : 0; end > 0 && blockWeight >= ewmaCutoff; blockWeight *= blockDecay) {
+            const size_t begin = end > static_cast<size_t>(simdLanes) ? end - simdLanes : 0;
+            const int32_t lanes = static_cast<int32_t>(end - begin);
+            #pragma omp simd reduction(+:weighted, weights)
+            for (int32_t lane = 0; lane < lanes; lane++) {
+                const size_t i = end - 1 - lane;
+                const float logReturn = vecmath::log(prices[i + 1] / prices[i]);
+                const float returnWeight = blockWeight * laneWeights[lane];
+                weighted += returnWeight * logReturn * logReturn;
+                weights += returnWeight;
+            }
+            end = begin;
+        }
+        return weights > 0.0 ? static_cast<float>(std::sqrt(weighted / weights)) : 0.0f;
+    }
+}
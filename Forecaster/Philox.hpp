@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include "VectorMath.hpp"
+
+// Philox4x32-10 counter based generator (Salmon et al., "Parallel random numbers: as easy
+// as 1, 2, 3"). Every 128 bit counter is hashed into four independent 32 bit words under a
+// 64 bit key, so a draw is a pure function of (seed, path, step) and any thread can compute
+// any part of the stream without sharing state. Forecasts are therefore identical whatever
+// the thread count or scheduling.
+namespace philox {
+    constexpr uint32_t multiplier0 = 0xD2511F53u;
+    constexpr uint32_t multiplier1 = 0xCD9E8D57u;
+    constexpr uint32_t weyl0 = 0x9E3779B9u;
+    constexpr uint32_t weyl1 = 0xBB67AE85u;
+
+    // Counter words, the path index takes two so streams never wrap
+    struct Counter {
+        uint32_t stepGroup;   // Four consecutive steps share one counter
+        uint32_t pathLow;
+        uint32_t pathHigh;
+        uint32_t stream;      // Independent streams of the same path, e.g. for a second estimator
+    };
+
+    struct Output {
+        uint32_t word[4];
+    };
+
+    VECMATH_INLINE void round(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1) {
+        const uint64_t product0 = static_cast<uint64_t>(multiplier0) * c0;
+        const uint64_t product1 = static_cast<uint64_t>(multiplier1) * c2;
+        const uint32_t next0 = static_cast<uint32_t>(product1 >> 32) ^ c1 ^ k0;
+        const uint32_t next2 = static_cast<uint32_t>(product0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(product1);
+        c3 = static_cast<uint32_t>(product0);
+        c0 = next0;
+        c2 = next2;
+    }
+
+    // The ten rounds are spelled out, a loop here keeps compilers from vectorizing over lanes
+    VECMATH_INLINE Output generate(Counter counter, uint64_t seed) {
+        uint32_t c0 = counter.stepGroup, c1 = counter.pathLow, c2 = counter.pathHigh, c3 = counter.stream;
+        const uint32_t k0 = static_cast<uint32_t>(seed), k1 = static_cast<uint32_t>(seed >> 32);
+        round(c0, c1, c2, c3, k0, k1);
+        round(c0, c1, c2, c3, k0 + weyl0, k1 + weyl1);
+        round(c0, c1, c2, c3, k0 + 2 * weyl0, k1 + 2 * weyl1);
+        round(c0, c1, c2, c3, k0 + 3 * weyl0, k1 + 3 * weyl1);
+        round(c0, c1, c2, c3, k0 + 4 * weyl0, k1 + 4 * weyl1);
+        round(c0, c1, c2, c3, k0 + 5 * weyl0, k1 + 5 * weyl1);
+        round(c0, c1, c2, c3, k0 + 6 * weyl0, k1 + 6 * weyl1);
+        round(c0, c1, c2, c3, k0 + 7 * weyl0, k1 + 7 * weyl1);
+        round(c0, c1, c2, c3, k0 + 8 * weyl0, k1 + 8 * weyl1);
+        round(c0, c1, c2, c3, k0 + 9 * weyl0, k1 + 9 * weyl1);
+        return { { c0, c1, c2, c3 } };
+    }
+
+    // Uniform in (0, 1), never 0 so its log is finite and never 1 so the inverse normal
+    // distribution is. 23 bits, with 24 the largest value would round up to 1.
+    VECMATH_INLINE float toOpenUniform(uint32_t word) {
+        return static_cast<float>(word >> 9) * (1.0f / 8388608.0f) + (0.5f / 8388608.0f);
+    }
+
+    // Uniform in [0, 1)
+    VECMATH_INLINE float toUniform(uint32_t word) {
+        return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Box-Muller transform of two words into two standard normal draws
+    VECMATH_INLINE void boxMuller(uint32_t radiusWord, uint32_t angleWord, float& first, float& second) {
+        const float radius = vecmath::sqrt(-2.0f * vecmath::log(toOpenUniform(radiusWord)));
+        float sine, cosine;
+        vecmath::sincos2pi(toUniform(angleWord), sine, cosine);
+        first = radius * cosine;
+        second = radius * sine;
+    }
+
+    // Standard normal draws of simdLanes paths, lane i drawing for path paths[i], for the
+    // steps [0, steps) laid out [step][lane]. steps must be a multiple of 4, one counter
+    // gives four steps of one path. Lanes are independent so the loops vectorize.
+    inline void fillNormals(uint64_t seed, const uint64_t* paths, uint32_t stream, int32_t steps, float* normals) {
+        for (int32_t group = 0; group < steps / 4; group++) {
+            float* draws = normals + static_cast<size_t>(group) * 4 * simdLanes;
+            #pragma omp simd
+            for (int32_t lane = 0; lane < simdLanes; lane++) {
+                const uint64_t path = paths[lane];
+                const Output output = generate({ static_cast<uint32_t>(group), static_cast<uint32_t>(path), static_cast<uint32_t>(path >> 32), stream }, seed);
+                boxMuller(output.word[0], output.word[1], draws[lane], draws[simdLanes + lane]);
+                boxMuller(output.word[2], output.word[3], draws[2 * simdLanes + lane], draws[3 * simdLanes + lane]);
+            }
+        }
+    }
+}
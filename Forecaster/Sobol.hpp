@@ -0,0 +1,268 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Philox.hpp"
+#include "SobolTable.hpp"
+
+// Sobol low discrepancy sequence (Bratley and Fox, algorithm 659) with a Brownian bridge
+// construction of the path increments, for quasi-Monte Carlo forecasts. Points are randomised
+// by a digital shift per replicate so the spread of the replicate means gives an error bound.
+namespace sobol {
+    constexpr int32_t bits = 32;    // Direction numbers per dimension, enough for 2^32 points
+
+    // Direction numbers of the first dimensions, laid out [bit][dimension] so a point is an
+    // XOR of whole rows. The first dimension is the van der Corput sequence; the following
+    // ones use the primitive polynomials over GF(2) in order of degree with the initial
+    // direction numbers of Joe and Kuo, see SobolTable.hpp. At most maxDimensions dimensions.
+    class Directions {
+    public:
+        explicit Directions(int32_t dimensions) : m_dimensions(dimensions), m_numbers(static_cast<size_t>(bits) * dimensions) {
+            uint32_t numbers[bits];
+            for (int32_t k = 0; k < bits; k++) {
+                numbers[k] = 1u << (bits - 1 - k);
+            }
+            store(0, numbers);
+
+            uint32_t polynomial = 1;
+            const uint16_t* initialNumbers = joeKuoNumbers;
+            for (int32_t dimension = 1; dimension < m_dimensions; dimension++) {
+                polynomial = nextPrimitive(polynomial);
+                initialise(polynomial, initialNumbers, numbers);
+                initialNumbers += degreeOf(polynomial);
+                store(dimension, numbers);
+            }
+        }
+
+        int32_t dimensions() const {
+            return m_dimensions;
+        }
+
+        uint32_t direction(int32_t bit, int32_t dimension) const {
+            return m_numbers[static_cast<size_t>(bit) * m_dimensions + dimension];
+        }
+
+        const uint32_t* row(int32_t bit) const {
+            return m_numbers.data() + static_cast<size_t>(bit) * m_dimensions;
+        }
+
+    private:
+        // Direction numbers of a dimension from its polynomial and its initial numbers m_k,
+        // odd and below 2^(k+1) for the first degree bits
+        static void initialise(uint32_t polynomial, const uint16_t* initialNumbers, uint32_t* numbers) {
+            const int32_t degree = degreeOf(polynomial);
+            const uint32_t coefficients = (polynomial >> 1) & ((1u << (degree - 1)) - 1);
+            for (int32_t k = 0; k < bits; k++) {
+                if (k < degree) {
+                    numbers[k] = static_cast<uint32_t>(initialNumbers[k]) << (bits - 1 - k);
+                    continue;
+                }
+                numbers[k] = numbers[k - degree] ^ (numbers[k - degree] >> degree);
+                for (int32_t j = 1; j < degree; j++) {
+                    if ((coefficients >> (degree - 1 - j)) & 1u) {
+                        numbers[k] ^= numbers[k - j];
+                    }
+                }
+            }
+        }
+
+        void store(int32_t dimension, const uint32_t* numbers) {
+            for (int32_t k = 0; k < bits; k++) {
+                m_numbers[static_cast<size_t>(k) * m_dimensions + dimension] = numbers[k];
+            }
+        }
+
+        static int32_t degreeOf(uint32_t polynomial) {
+            int32_t degree = 0;
+            while (polynomial >> (degree + 1)) {
+                degree++;
+            }
+            return degree;
+        }
+
+        // A polynomial of degree s with a constant term is primitive if x has order 2^s - 1
+        // modulo it
+        static bool isPrimitive(uint32_t polynomial) {
+            const int32_t degree = degreeOf(polynomial);
+            const uint32_t period = (1u << degree) - 1;
+            uint32_t power = 1;
+            for (uint32_t order = 1; order <= period; order++) {
+                power <<= 1;
+                if (power >> degree) {
+                    power ^= polynomial;
+                }
+                if (power == 1) {
+                    return order == period;
+                }
+            }
+            return false;
+        }
+
+        // The next primitive polynomial after the given one, coefficients as bits
+        static uint32_t nextPrimitive(uint32_t polynomial) {
+            do {
+                polynomial += 2;   // Odd polynomials only, the constant term must be 1
+            } while (!isPrimitive(polynomial));
+            return polynomial;
+        }
+
+        int32_t m_dimensions;
+        std::vector<uint32_t> m_numbers;
+    };
+
+    // Inverse of the standard normal distribution function for p in (0, 1), Wichura's PPND7
+    // (algorithm AS 241), the rational approximations made for single precision, within 2e-6
+    // of the exact value for every toOpenUniform output. All three regions are computed and
+    // one is selected, without branches so loops vectorize.
+    VECMATH_INLINE float inverseNormal(float p) {
+        const float q = p - 0.5f;
+        const float r = 0.180625f - q * q;
+        const float central = q * (((5.9109374720e+01f * r + 1.5929113202e+02f) * r + 5.0434271938e+01f) * r + 3.3871327179e+00f) /
+            (((6.7187563600e+01f * r + 7.8757757664e+01f) * r + 1.7895169469e+01f) * r + 1.0f);
+
+        // Uniforms are multiples of 2^-23 plus half of that, 1 - p is exact
+        const float t = vecmath::sqrt(-vecmath::log(q < 0.0f ? p : 1.0f - p));
+        const float s = t - 1.6f;
+        const float middle = (((1.7023821103e-01f * s + 1.3067284816e+00f) * s + 2.7568153900e+00f) * s + 1.4234372777e+00f) /
+            ((1.2021132975e-01f * s + 7.3700164250e-01f) * s + 1.0f);
+        const float u = t - 5.0f;
+        const float far = (((1.7337203997e-02f * u + 4.2848877769e-01f) * u + 3.0812263860e+00f) * u + 6.6579051150e+00f) /
+            ((1.2258202635e-02f * u + 2.4197894225e-01f) * u + 1.0f);
+        const float tail = t <= 5.0f ? middle : far;
+        return q * q <= 0.180625f ? central : (q < 0.0f ? -tail : tail);
+    }
+
+    // Builds a Brownian motion over steps unit time steps from as many standard normals,
+    // the first normal sets the end point and the following ones bisect the known intervals
+    // coarsest first. The large scale shape of a path then depends on the first, best
+    // distributed dimensions of the sequence.
+    class BrownianBridge {
+    public:
+        explicit BrownianBridge(int32_t steps) : m_steps(steps) {
+            struct Interval {
+                int32_t left;
+                int32_t right;
+            };
+            std::vector<Interval> intervals{ { 0, steps } };
+
+            for (size_t next = 0; next < intervals.size(); next++) {
+                const Interval interval = intervals[next];
+                if (interval.right - interval.left < 2) {
+                    continue;
+                }
+                const int32_t middle = (interval.left + interval.right) / 2;
+                const double width = interval.right - interval.left;
+                m_points.push_back({ middle, interval.left, interval.right,
+                    static_cast<float>((interval.right - middle) / width),
+                    static_cast<float>((middle - interval.left) / width),
+                    static_cast<float>(std::sqrt((middle - interval.left) * (interval.right - middle) / width)) });
+                intervals.push_back({ interval.left, middle });
+                intervals.push_back({ middle, interval.right });
+            }
+        }
+
+        int32_t steps() const {
+            return m_steps;
+        }
+
+        // Increments of the motion from the normals, motion needs steps + 1 floats of scratch
+        void build(const float* normals, float* motion, float* increments, int32_t stride) const {
+            motion[0] = 0.0f;
+            motion[m_steps] = std::sqrt(static_cast<float>(m_steps)) * normals[0];
+            for (size_t i = 0; i < m_points.size(); i++) {
+                const Point& point = m_points[i];
+                motion[point.index] = point.leftWeight * motion[point.left] + point.rightWeight * motion[point.right] +
+                    point.stdDev * normals[i + 1];
+            }
+            for (int32_t k = 0; k < m_steps; k++) {
+                increments[static_cast<size_t>(k) * stride] = motion[k + 1] - motion[k];
+            }
+        }
+
+    private:
+        struct Point {
+            int32_t index;
+            int32_t left;
+            int32_t right;
+            float leftWeight;
+            float rightWeight;
+            float stdDev;
+        };
+
+        int32_t m_steps;
+        std::vector<Point> m_points;
+    };
+
+    // Normal increments of simdLanes Sobol points, laid out [step][lane] like
+    // philox::fillNormals. Each thread owns one, the directions and the bridge are shared.
+    class PathGenerator {
+    public:
+        PathGenerator(const Directions& directions, const BrownianBridge& bridge)
+            : m_directions(directions), m_bridge(bridge), m_point(directions.dimensions(), 0u), m_index(0),
+            m_words(static_cast<size_t>(simdLanes) * directions.dimensions()), m_normals(m_words.size()),
+            m_motion(static_cast<size_t>(bridge.steps()) + 1) {
+        }
+
+        // Lane i gets point points[i] XORed with the digital shift shifts[i], one word per
+        // dimension
+        void fillNormals(const uint32_t* const* shifts, const uint64_t* points, float* normals) {
+            const int32_t dimensions = m_directions.dimensions();
+            for (int32_t lane = 0; lane < simdLanes; lane++) {
+                moveTo(points[lane]);
+                const uint32_t* shift = shifts[lane];
+                uint32_t* words = m_words.data() + static_cast<size_t>(lane) * dimensions;
+                for (int32_t dimension = 0; dimension < dimensions; dimension++) {
+                    words[dimension] = m_point[dimension] ^ shift[dimension];
+                }
+            }
+
+            // One loop over the words of every lane, laid out [lane][dimension]
+            const uint32_t* words = m_words.data();
+            float* laneNormals = m_normals.data();
+            const size_t count = m_words.size();
+            #pragma omp simd
+            for (size_t i = 0; i < count; i++) {
+                laneNormals[i] = inverseNormal(philox::toOpenUniform(words[i]));
+            }
+            for (int32_t lane = 0; lane < simdLanes; lane++) {
+                m_bridge.build(laneNormals + static_cast<size_t>(lane) * dimensions, m_motion.data(), normals + lane, simdLanes);
+            }
+        }
+
+    private:
+        // Moves the unshifted point to point index. Point n is the XOR of the direction numbers
+        // of the set bits of its Gray code, and the Gray codes of n - 1 and n differ only in
+        // bit ctz(n), so the lanes of a block and consecutive blocks step with one row each.
+        void moveTo(uint64_t index) {
+            const int32_t dimensions = m_directions.dimensions();
+            if (index == m_index + 1 && std::countr_zero(index) < bits) {
+                const uint32_t* row = m_directions.row(std::countr_zero(index));
+                for (int32_t dimension = 0; dimension < dimensions; dimension++) {
+                    m_point[dimension] ^= row[dimension];
+                }
+            } else if (index != m_index) {
+                const uint32_t gray = static_cast<uint32_t>(index ^ (index >> 1));
+                std::fill(m_point.begin(), m_point.end(), 0u);
+                for (int32_t bit = 0; bit < bits; bit++) {
+                    if ((gray >> bit) & 1u) {
+                        const uint32_t* row = m_directions.row(bit);
+                        for (int32_t dimension = 0; dimension < dimensions; dimension++) {
+                            m_point[dimension] ^= row[dimension];
+                        }
+                    }
+                }
+            }
+            m_index = index;
+        }
+
+        const Directions& m_directions;
+        const BrownianBridge& m_bridge;
+        std::vector<uint32_t> m_point;      // Unshifted point m_index, point 0 is all zeros
+        uint64_t m_index;
+        std::vector<uint32_t> m_words;
+        std::vector<float> m_normals;
+        std::vector<float> m_motion;
+    };
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Number of paths the Monte Carlo kernel simulates side by side, one register of floats.
+// Builds without AVX2 (/arch:AVX2, -mavx2 -mfma) use the portable loops below, which the
+// compiler is still free to vectorize.
+#if defined(__AVX512F__)
+inline constexpr int simdLanes = 16;
+#else
+inline constexpr int simdLanes = 8;
+#endif
+
+// Scalar helpers called per lane are forced inline, a call left in a loop over lanes keeps
+// it from vectorizing and the inliner doesn't always take them at -O2
+#if defined(_MSC_VER)
+#define VECMATH_INLINE __forceinline
+#else
+#define VECMATH_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace vecmath {
+    // Cephes style expf: split x into n*ln2 + r with |r| <= ln2/2, approximate exp(r) with a
+    // degree 5 polynomial and scale by 2^n through the exponent bits. Relative error ~2 ulp,
+    // inputs are clamped to the range where the result is a normal float.
+    constexpr float expHigh = 88.3762626647949f;
+    constexpr float expLow = -87.3365447504019f;
+    constexpr float log2e = 1.44269504088896341f;
+    constexpr float ln2High = 0.693359375f;
+    constexpr float ln2Low = -2.12194440e-4f;
+    constexpr float expP0 = 1.9875691500e-4f;
+    constexpr float expP1 = 1.3981999507e-3f;
+    constexpr float expP2 = 8.3334519073e-3f;
+    constexpr float expP3 = 4.1665795894e-2f;
+    constexpr float expP4 = 1.6666665459e-1f;
+    constexpr float expP5 = 5.0000001201e-1f;
+
+    VECMATH_INLINE float exp(float x) {
+        x = x < expHigh ? x : expHigh;
+        x = x > expLow ? x : expLow;
+        float n = static_cast<float>(static_cast<int32_t>(x * log2e + (x < 0.0f ? -0.5f : 0.5f)));
+        float r = x - n * ln2High - n * ln2Low;
+        float p = expP0;
+        p = p * r + expP1;
+        p = p * r + expP2;
+        p = p * r + expP3;
+        p = p * r + expP4;
+        p = p * r + expP5;
+        float y = p * r * r + r + 1.0f;
+        int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return y * scale;
+    }
+
+    // Cephes style logf for positive normal x: x = m * 2^e with m in [sqrt(1/2), sqrt(2)),
+    // log(m) from a degree 9 polynomial in m - 1. Written without branches so loops over
+    // lanes vectorize.
+    VECMATH_INLINE float log(float x) {
+        int32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        float e = static_cast<float>((bits >> 23) - 126);
+        bits = (bits & 0x007fffff) | 0x3f000000;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+        // 1 for m below sqrt(1/2), computed from the bits as a select here ends up as a branch
+        const float small = static_cast<float>(static_cast<uint32_t>(bits - 0x3f3504f3) >> 31);
+        e -= small;
+        m = m + m * small - 1.0f;
+        float z = m * m;
+        float y = 7.0376836292e-2f;
+        y = y * m - 1.1514610310e-1f;
+        y = y * m + 1.1676998740e-1f;
+        y = y * m - 1.2420140846e-1f;
+        y = y * m + 1.4249322787e-1f;
+        y = y * m - 1.6668057665e-1f;
+        y = y * m + 2.0000714765e-1f;
+        y = y * m - 2.4999993993e-1f;
+        y = y * m + 3.3333331174e-1f;
+        y = y * m * z;
+        y += ln2Low * e;
+        y -= 0.5f * z;
+        return m + y + ln2High * e;
+    }
+
+    // Square root of positive normal x from an initial reciprocal square root estimate and
+    // three Newton steps. std::sqrt may set errno, which keeps compilers from vectorizing
+    // the loops it is called in unless built with -fno-math-errno.
+    VECMATH_INLINE float sqrt(float x) {
+        int32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        bits = 0x5f375a86 - (bits >> 1);
+        float y;
+        std::memcpy(&y, &bits, sizeof(y));
+        const float halfX = 0.5f * x;
+        y = y * (1.5f - halfX * y * y);
+        y = y * (1.5f - halfX * y * y);
+        y = y * (1.5f - halfX * y * y);
+        return x * y;
+    }
+
+    // Sine and cosine of 2 * pi * u for u in [0, 1]: u is split into quarter turns q and a
+    // remainder t in [-pi/4, pi/4], the Cephes polynomials for t are rotated by q
+    VECMATH_INLINE void sincos2pi(float u, float& sine, float& cosine) {
+        float q = static_cast<float>(static_cast<int32_t>(u * 4.0f + 0.5f));
+        float t = (u * 4.0f - q) * 1.57079632679489662f;
+        float z = t * t;
+        float s = t + t * z * ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f);
+        float c = 1.0f - 0.5f * z + z * z * ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f);
+        int32_t quadrant = static_cast<int32_t>(q) & 3;
+        float rotatedSine = (quadrant & 1) ? c : s;
+        float rotatedCosine = (quadrant & 1) ? s : c;
+        sine = (quadrant & 2) ? -rotatedSine : rotatedSine;
+        cosine = ((quadrant + 1) & 2) ? -rotatedCosine : rotatedCosine;
+    }
+
+#if defined(__AVX512F__)
+    inline __m512 exp(__m512 x) {
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(expLow)), _mm512_set1_ps(expHigh));
+        __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2High), x);
+        r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2Low), r);
+        __m512 p = _mm512_set1_ps(expP0);
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP1));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP2));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP3));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP4));
+        p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP5));
+        __m512 y = _mm512_add_ps(_mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r), _mm512_set1_ps(1.0f));
+        __m512i bits = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+        return _mm512_mul_ps(y, _mm512_castsi512_ps(bits));
+    }
+#elif defined(__AVX2__)
+    inline __m256 exp(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(expLow)), _mm256_set1_ps(expHigh));
+        __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2High), x);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2Low), r);
+        __m256 p = _mm256_set1_ps(expP0);
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP1));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP2));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP3));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP4));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP5));
+        __m256 y = _mm256_add_ps(_mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r), _mm256_set1_ps(1.0f));
+        __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(bits));
+    }
+#endif
+
+    // out[i] = exp(in[i]) for one block of simdLanes floats
+    inline void expLanes(const float* in, float* out) {
+#if defined(__AVX512F__)
+        // The lane loops write in with 256-bit stores, one 512-bit load of both halves can't be store forwarded
+        const __m512d halves = _mm512_insertf64x4(_mm512_castpd256_pd512(_mm256_loadu_pd(reinterpret_cast<const double*>(in))),
+            _mm256_loadu_pd(reinterpret_cast<const double*>(in + 8)), 1);
+        const __m512 x = _mm512_castpd_ps(halves);
+        _mm512_storeu_ps(out, exp(x));
+#elif defined(__AVX2__)
+        _mm256_storeu_ps(out, exp(_mm256_loadu_ps(in)));
+#else
+        for (int lane = 0; lane < simdLanes; lane++) {
+            out[lane] = exp(in[lane]);
+        }
+#endif
+    }
+}
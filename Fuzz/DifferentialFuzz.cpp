@@ -0,0 +1,520 @@
+#include "../Order_Book/Book.hpp"
+#include "../Order_Book/Limit.hpp"
+#include "../Order_Book/Order.hpp"
+#include "../Process_Orders/Command.hpp"
+#include "ReferenceBook.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Differential fuzzer of the book engines. Every case is a random command stream over a
+// narrow price window, applied to an engine and to ReferenceBook side by side. Results,
+// trades, cancels, the book edges, every level down to its order queue and every order id
+// are compared after each command. A failing case is shrunk to a short stream which still
+// diverges and printed, and written with --output, in the text command format.
+// Crashes can't be shrunk, run a sanitizer build to turn them into reports instead.
+//
+//   DifferentialFuzz [--seed 1] [--cases 1000] [--length 400] [--width 20]
+//                    [--engine avl_map|avl_flat|avl_dense|ladder_map|ladder_flat|ladder_dense]
+//                    [--output failing.txt]
+
+namespace {
+    constexpr int centrePrice = 5000;
+    constexpr int noPrice = -1;
+
+    const char* const selfTradePreventionNames[] = { "None", "CancelNewest", "CancelOldest", "DecrementBoth" };
+
+    struct Parameters
+    {
+        std::uint64_t seed = 1;
+        long long cases = 1000;
+        int length = 400;
+        int width = 20;
+        std::string engine;       // Empty for every engine
+        std::string outputFile;
+    };
+
+    // Self trade prevention is set per case, the command format can't carry it
+    struct FuzzCase
+    {
+        std::vector<Command> commands;
+        SelfTradePrevention selfTradePrevention = SelfTradePrevention::None;
+    };
+
+    ReferenceBook makeReference(SelfTradePrevention selfTradePrevention)
+    {
+        ReferenceBook reference(DefaultBookConfig::minPrice, DefaultBookConfig::tickSize, DefaultBookConfig::levelCount);
+        reference.setSelfTradePrevention(selfTradePrevention);
+        return reference;
+    }
+
+    // Apply a command as OrderPipeline does, to an engine or the reference
+    template <typename BookT>
+    typename BookT::OrderResult applyCommand(BookT& book, const Command& command)
+    {
+        using Price = typename BookT::Price;
+        using Quantity = typename BookT::Quantity;
+        Quantity shares = static_cast<Quantity>(command.shares);
+        Price price = static_cast<Price>(command.price);
+        switch (command.type)
+        {
+        case CommandType::Market:
+            return book.marketOrder(command.orderId, command.buyOrSell, shares, command.ownerId);
+        case CommandType::AddLimit:
+        case CommandType::AddMarketLimit:
+            return book.addLimitOrder(command.orderId, command.buyOrSell, shares, price, TimeInForce::GoodTillCancel, command.ownerId);
+        case CommandType::AddLimitIOC:
+            return book.addLimitOrder(command.orderId, command.buyOrSell, shares, price, TimeInForce::ImmediateOrCancel, command.ownerId);
+        case CommandType::AddLimitFOK:
+            return book.addLimitOrder(command.orderId, command.buyOrSell, shares, price, TimeInForce::FillOrKill, command.ownerId);
+        case CommandType::AddIceberg:
+            return book.addIcebergOrder(command.orderId, command.buyOrSell, shares, price, static_cast<Quantity>(command.auxiliary), command.ownerId);
+        case CommandType::CancelLimit:
+            return book.cancelLimitOrder(command.orderId);
+        case CommandType::ModifyLimit:
+            return book.modifyLimitOrder(command.orderId, shares, price);
+        case CommandType::AddStop:
+            return book.addStopOrder(command.orderId, command.buyOrSell, shares, price, command.ownerId);
+        case CommandType::CancelStop:
+            return book.cancelStopOrder(command.orderId);
+        case CommandType::ModifyStop:
+            return book.modifyStopOrder(command.orderId, shares, price);
+        case CommandType::AddStopLimit:
+            return book.addStopLimitOrder(command.orderId, command.buyOrSell, shares, price, static_cast<Price>(command.auxiliary), command.ownerId);
+        case CommandType::CancelStopLimit:
+            return book.cancelStopLimitOrder(command.orderId);
+        case CommandType::ModifyStopLimit:
+            return book.modifyStopLimitOrder(command.orderId, shares, price, static_cast<Price>(command.auxiliary));
+        }
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+
+    // Levels of an engine between lowest and highest, walking at most one order past the
+    // size of a level so a broken queue can't loop forever
+    template <typename BookT>
+    BookSnapshot engineSnapshot(const BookT& book, std::int64_t lowest, std::int64_t highest)
+    {
+        using Limit = typename BookT::Limit;
+        using Order = typename BookT::Order;
+        BookSnapshot result;
+        for (std::int64_t price = lowest; price <= highest; price++)
+        {
+            for (int side = 0; side < BookSnapshot::sideCount; side++)
+            {
+                bool buyOrSell = side == BookSnapshot::Buys || side == BookSnapshot::StopBuys;
+                typename BookT::Price bookPrice = static_cast<typename BookT::Price>(price);
+                Limit* limit = side < BookSnapshot::StopBuys ? book.searchLimitMaps(bookPrice, buyOrSell) : book.searchStopMap(bookPrice, buyOrSell);
+                if (limit == nullptr)
+                {
+                    continue;
+                }
+                BookSnapshot::Level& level = result.sides[side].emplace_back();
+                level.price = price;
+                level.volume = limit->getTotalVolume();
+                level.hiddenVolume = limit->getHiddenVolume(book.getPools());
+                level.size = limit->getSize();
+                Order* order = limit->getHeadOrder(book.getPools());
+                for (int i = 0; order != nullptr && i <= limit->getSize(); i++)
+                {
+                    level.orders.push_back({ order->getOrderId(book.getPools()), order->getShares(), order->getHiddenShares(book.getPools()) });
+                    order = order->getNextOrder(book.getPools());
+                }
+            }
+        }
+        return result;
+    }
+
+    template <typename Limit>
+    std::int64_t edgePrice(const Limit* limit)
+    {
+        return limit == nullptr ? noPrice : limit->getLimitPrice();
+    }
+
+    std::int64_t edgePrice(const std::vector<BookSnapshot::Level>& levels, bool highest)
+    {
+        return levels.empty() ? noPrice : (highest ? levels.back().price : levels.front().price);
+    }
+
+    // Compare everything a command can change, false with a description on the first difference
+    template <typename BookT>
+    bool compareStep(BookT& engine, ReferenceBook& reference, const typename BookT::OrderResult& actual,
+        const ReferenceBook::OrderResult& expected, int maxOrderId, int width, std::string& difference)
+    {
+        std::ostringstream out;
+        auto& events = engine.getEventSink();
+        if (actual.status != expected.status || actual.filledShares != expected.filledShares
+            || actual.remainingShares != expected.remainingShares || actual.resting != expected.resting
+            || actual.cancelledShares != expected.cancelledShares)
+        {
+            out << "result expected status " << static_cast<int>(expected.status) << " filled " << expected.filledShares
+                << " remaining " << expected.remainingShares << " resting " << expected.resting << " cancelled " << expected.cancelledShares
+                << ", got status " << static_cast<int>(actual.status) << " filled " << actual.filledShares
+                << " remaining " << actual.remainingShares << " resting " << actual.resting << " cancelled " << actual.cancelledShares;
+        }
+        else if (events.trades.size() != reference.trades.size())
+        {
+            out << "expected " << reference.trades.size() << " trades, got " << events.trades.size();
+        }
+        else if (events.cancels != reference.cancels)
+        {
+            out << "expected cancels of";
+            for (int orderId : reference.cancels)
+            {
+                out << " " << orderId;
+            }
+            out << ", got";
+            for (int orderId : events.cancels)
+            {
+                out << " " << orderId;
+            }
+        }
+        for (std::size_t i = 0; out.tellp() == 0 && i < reference.trades.size(); i++)
+        {
+            const ReferenceBook::Trade& expectedTrade = reference.trades[i];
+            const auto& actualTrade = events.trades[i];
+            if (actualTrade.restingOrderId != expectedTrade.restingOrderId || actualTrade.incomingOrderId != expectedTrade.incomingOrderId
+                || actualTrade.price != expectedTrade.price || actualTrade.shares != expectedTrade.shares)
+            {
+                out << "trade " << i << " expected " << expectedTrade.restingOrderId << "/" << expectedTrade.incomingOrderId
+                    << " " << expectedTrade.shares << "@" << expectedTrade.price << ", got " << actualTrade.restingOrderId
+                    << "/" << actualTrade.incomingOrderId << " " << actualTrade.shares << "@" << actualTrade.price;
+            }
+        }
+        events.clear();
+        reference.trades.clear();
+        reference.cancels.clear();
+        if (out.tellp() != 0)
+        {
+            difference = out.str();
+            return false;
+        }
+
+        BookSnapshot expectedBook = reference.snapshot();
+        const std::int64_t edges[][2] = {
+            { edgePrice(expectedBook.sides[BookSnapshot::Buys], true), edgePrice(engine.getHighestBuy()) },
+            { edgePrice(expectedBook.sides[BookSnapshot::Sells], false), edgePrice(engine.getLowestSell()) },
+            { edgePrice(expectedBook.sides[BookSnapshot::StopBuys], false), edgePrice(engine.getLowestStopBuy()) },
+            { edgePrice(expectedBook.sides[BookSnapshot::StopSells], true), edgePrice(engine.getHighestStopSell()) }
+        };
+        const char* edgeNames[] = { "highest buy", "lowest sell", "lowest stop buy", "highest stop sell" };
+        for (int i = 0; i < 4; i++)
+        {
+            if (edges[i][0] != edges[i][1])
+            {
+                out << edgeNames[i] << " expected " << edges[i][0] << ", got " << edges[i][1];
+                difference = out.str();
+                return false;
+            }
+        }
+
+        BookSnapshot actualBook = engineSnapshot(engine, centrePrice - width, centrePrice + width);
+        if (describeDifference(expectedBook, actualBook, difference))
+        {
+            return false;
+        }
+
+        // Orders which left the book must be gone from the order store as well
+        const std::map<int, ReferenceBook::RestingOrder>& orders = reference.getOrders();
+        for (int orderId = 1; orderId <= maxOrderId; orderId++)
+        {
+            auto expectedOrder = orders.find(orderId);
+            auto* actualOrder = engine.searchOrderMap(orderId);
+            if ((expectedOrder != orders.end()) != (actualOrder != nullptr))
+            {
+                out << "order " << orderId << (actualOrder != nullptr ? " should be gone" : " is missing") << " from the order store";
+                difference = out.str();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Index of the first command after which the engine and the reference differ, -1 if none does
+    template <typename BookT>
+    long firstDivergence(const FuzzCase& fuzzCase, int width, std::string& difference)
+    {
+        auto engine = std::make_unique<BookT>();
+        engine->setSelfTradePrevention(fuzzCase.selfTradePrevention);
+        ReferenceBook reference = makeReference(fuzzCase.selfTradePrevention);
+
+        int maxOrderId = 0;
+        for (std::size_t i = 0; i < fuzzCase.commands.size(); i++)
+        {
+            const Command& command = fuzzCase.commands[i];
+            maxOrderId = std::max(maxOrderId, command.orderId);
+            ReferenceBook::OrderResult expected = applyCommand(reference, command);
+            typename BookT::OrderResult actual = applyCommand(*engine, command);
+            if (!compareStep(*engine, reference, actual, expected, maxOrderId, width, difference))
+            {
+                return static_cast<long>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Random stream of every command type. Cancels and modifies mostly target live orders of
+    // their kind, which are tracked by running the stream through a reference book, and
+    // otherwise any id so missing and wrong kind orders are covered too.
+    FuzzCase generateCase(std::uint64_t seed, int length, int width)
+    {
+        std::mt19937_64 gen(seed);
+        FuzzCase fuzzCase;
+        fuzzCase.selfTradePrevention = static_cast<SelfTradePrevention>(gen() % 4);
+        ReferenceBook reference = makeReference(fuzzCase.selfTradePrevention);
+
+        // Weights in the order of CommandType
+        std::discrete_distribution<int> typeDist({ 6, 30, 0, 4, 4, 6, 12, 8, 5, 3, 3, 5, 3, 3 });
+        std::uniform_int_distribution<int> priceDist(centrePrice - width, centrePrice + width);
+        std::uniform_int_distribution<int> sharesDist(1, 200);
+        std::uniform_int_distribution<int> peakDist(1, 50);
+        std::uniform_int_distribution<int> ownerDist(0, 3);
+        std::uniform_real_distribution<double> unitDist(0.0, 1.0);
+
+        auto price = [&]() -> std::int64_t {
+            // A few prices outside the book exercise the InvalidPrice paths
+            if (unitDist(gen) < 0.02)
+            {
+                return unitDist(gen) < 0.5 ? -1 : static_cast<std::int64_t>(DefaultBookConfig::levelCount);
+            }
+            return priceDist(gen);
+        };
+
+        int nextOrderId = 1;
+        std::vector<int> candidates;
+        auto targetOrder = [&](ReferenceBook::Kind kind) {
+            candidates.clear();
+            for (const auto& [orderId, order] : reference.getOrders())
+            {
+                if (order.kind == kind)
+                {
+                    candidates.push_back(orderId);
+                }
+            }
+            if (candidates.empty() || unitDist(gen) < 0.2)
+            {
+                return std::uniform_int_distribution<int>(1, nextOrderId)(gen);
+            }
+            return candidates[std::uniform_int_distribution<std::size_t>(0, candidates.size() - 1)(gen)];
+        };
+
+        fuzzCase.commands.reserve(length);
+        for (int i = 0; i < length; i++)
+        {
+            Command command = {};
+            command.type = static_cast<CommandType>(typeDist(gen));
+            command.buyOrSell = gen() & 1;
+            command.shares = sharesDist(gen);
+            switch (command.type)
+            {
+            case CommandType::CancelLimit:
+            case CommandType::ModifyLimit:
+                command.orderId = targetOrder(ReferenceBook::LimitKind);
+                break;
+            case CommandType::CancelStop:
+            case CommandType::ModifyStop:
+                command.orderId = targetOrder(ReferenceBook::StopKind);
+                break;
+            case CommandType::CancelStopLimit:
+            case CommandType::ModifyStopLimit:
+                command.orderId = targetOrder(ReferenceBook::StopLimitKind);
+                break;
+            default:
+                // A few adds reuse an id, which is rejected while that order rests
+                command.orderId = unitDist(gen) < 0.02 ? std::uniform_int_distribution<int>(1, nextOrderId)(gen) : nextOrderId++;
+                command.ownerId = ownerDist(gen);
+                break;
+            }
+            switch (command.type)
+            {
+            case CommandType::Market:
+                command.shares *= 2;
+                break;
+            case CommandType::AddIceberg:
+                command.price = price();
+                command.auxiliary = unitDist(gen) < 0.1 ? 0 : peakDist(gen);
+                break;
+            case CommandType::AddStopLimit:
+            case CommandType::ModifyStopLimit:
+                command.price = price();
+                command.auxiliary = price();
+                break;
+            case CommandType::CancelLimit:
+            case CommandType::CancelStop:
+            case CommandType::CancelStopLimit:
+                command.shares = 0;
+                break;
+            default:
+                command.price = price();
+                break;
+            }
+            applyCommand(reference, command);
+            reference.trades.clear();
+            reference.cancels.clear();
+            fuzzCase.commands.push_back(command);
+        }
+        return fuzzCase;
+    }
+
+    // Shrink a failing case: cut it after the failing command, remove ever smaller chunks
+    // of commands while it still fails, then halve the shares of the commands left
+    template <typename BookT>
+    void shrinkCase(FuzzCase& fuzzCase, int width)
+    {
+        std::string difference;
+        auto fails = [&](FuzzCase& candidate) {
+            long failing = firstDivergence<BookT>(candidate, width, difference);
+            if (failing < 0)
+            {
+                return false;
+            }
+            candidate.commands.resize(failing + 1);
+            return true;
+        };
+        fails(fuzzCase);
+
+        std::size_t chunk = fuzzCase.commands.size() / 2;
+        while (chunk > 0)
+        {
+            bool removed = false;
+            for (std::size_t start = 0; start < fuzzCase.commands.size() && fuzzCase.commands.size() > 1;)
+            {
+                FuzzCase candidate = fuzzCase;
+                std::size_t end = std::min(start + chunk, candidate.commands.size());
+                candidate.commands.erase(candidate.commands.begin() + start, candidate.commands.begin() + end);
+                if (!candidate.commands.empty() && fails(candidate))
+                {
+                    fuzzCase = std::move(candidate);
+                    removed = true;
+                }
+                else
+                {
+                    start += chunk;
+                }
+            }
+            if (!removed)
+            {
+                chunk /= 2;
+            }
+        }
+
+        for (std::size_t i = 0; i < fuzzCase.commands.size(); i++)
+        {
+            while (fuzzCase.commands[i].shares > 1)
+            {
+                FuzzCase candidate = fuzzCase;
+                candidate.commands[i].shares /= 2;
+                if (!fails(candidate) || candidate.commands.size() <= i)
+                {
+                    break;
+                }
+                fuzzCase = std::move(candidate);
+            }
+        }
+    }
+
+    void printCase(const FuzzCase& fuzzCase, std::ostream& out)
+    {
+        char line[maxFormattedCommandSize];
+        for (const Command& command : fuzzCase.commands)
+        {
+            out.write(line, formatCommand(command, line) - line);
+        }
+    }
+
+    template <typename BookT>
+    bool fuzzEngine(const char* engine, const Parameters& parameters)
+    {
+        if (!parameters.engine.empty() && parameters.engine != engine)
+        {
+            return true;
+        }
+        for (long long i = 0; i < parameters.cases; i++)
+        {
+            std::uint64_t caseSeed = parameters.seed + static_cast<std::uint64_t>(i);
+            FuzzCase fuzzCase = generateCase(caseSeed, parameters.length, parameters.width);
+            std::string difference;
+            long failing = firstDivergence<BookT>(fuzzCase, parameters.width, difference);
+            if (failing < 0)
+            {
+                continue;
+            }
+
+            std::cout << engine << " diverges from the reference at command " << failing << " of case seed " << caseSeed
+                << " (rerun with --seed " << caseSeed << " --cases 1): " << difference << std::endl;
+            shrinkCase<BookT>(fuzzCase, parameters.width);
+            firstDivergence<BookT>(fuzzCase, parameters.width, difference);
+            std::cout << "Shrunk to " << fuzzCase.commands.size() << " commands with self trade prevention "
+                << selfTradePreventionNames[static_cast<int>(fuzzCase.selfTradePrevention)] << ", after the last: " << difference << std::endl;
+            printCase(fuzzCase, std::cout);
+
+            if (!parameters.outputFile.empty())
+            {
+                CommandWriter writer;
+                if (!writer.open(parameters.outputFile, CommandFormat::Text))
+                {
+                    std::cerr << "Error opening file for writing: " << parameters.outputFile << std::endl;
+                    return false;
+                }
+                for (const Command& command : fuzzCase.commands)
+                {
+                    writer.write(command);
+                }
+                writer.close();
+            }
+            return false;
+        }
+        std::cout << engine << ": " << parameters.cases << " cases of " << parameters.length << " commands match the reference" << std::endl;
+        return true;
+    }
+
+    void printUsage()
+    {
+        std::cerr << "Usage: DifferentialFuzz [--seed <seed>] [--cases <cases>] [--length <commands>] [--width <ticks>]\n"
+            << "                        [--engine avl_map|avl_flat|avl_dense|ladder_map|ladder_flat|ladder_dense|avl_map_heap|avl_map_pool]\n"
+            << "                        [--output <file>]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Parameters parameters;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string argument = argv[i];
+        std::string value = argv[i + 1];
+        if (argument == "--seed") parameters.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (argument == "--cases") parameters.cases = std::atoll(value.c_str());
+        else if (argument == "--length") parameters.length = std::atoi(value.c_str());
+        else if (argument == "--width") parameters.width = std::atoi(value.c_str());
+        else if (argument == "--engine") parameters.engine = value;
+        else if (argument == "--output") parameters.outputFile = value;
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    if (argc % 2 == 0 || parameters.length <= 0 || parameters.width <= 0 || parameters.width >= centrePrice)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Only engines with a recording event sink, the fills are part of the comparison
+    bool matches = fuzzEngine<PolicyBook<AVLPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, RecordingEventSink>>("avl_map", parameters);
+    matches = fuzzEngine<PolicyBook<AVLPriceIndex, FlatHashOrderStore, IndexPoolAllocator, RecordingEventSink>>("avl_flat", parameters) && matches;
+    matches = fuzzEngine<PolicyBook<AVLPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, RecordingEventSink>>("avl_dense", parameters) && matches;
+    matches = fuzzEngine<PolicyBook<LadderPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, RecordingEventSink>>("ladder_map", parameters) && matches;
+    matches = fuzzEngine<PolicyBook<LadderPriceIndex, FlatHashOrderStore, IndexPoolAllocator, RecordingEventSink>>("ladder_flat", parameters) && matches;
+    matches = fuzzEngine<PolicyBook<LadderPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, RecordingEventSink>>("ladder_dense", parameters) && matches;
+    matches = fuzzEngine<PolicyBook<AVLPriceIndex, UnorderedMapOrderStore, HeapAllocator, RecordingEventSink>>("avl_map_heap", parameters) && matches;
+    matches = fuzzEngine<PolicyBook<AVLPriceIndex, UnorderedMapOrderStore, PoolAllocator, RecordingEventSink>>("avl_map_pool", parameters) && matches;
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,539 @@
+#include "ReferenceBook.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+namespace {
+    const char* const sideNames[BookSnapshot::sideCount] = { "buy", "sell", "stop buy", "stop sell" };
+
+    void describeLevel(std::ostringstream& out, const BookSnapshot::Level& level)
+    {
+        out << level.price << " volume " << level.volume << "+" << level.hiddenVolume << " size " << level.size << " orders";
+        for (const BookSnapshot::SnapshotOrder& order : level.orders)
+        {
+            out << " " << order.orderId << ":" << order.shares;
+            if (order.hiddenShares != 0)
+            {
+                out << "+" << order.hiddenShares;
+            }
+        }
+    }
+}
+
+bool describeDifference(const BookSnapshot& expected, const BookSnapshot& actual, std::string& difference)
+{
+    for (int side = 0; side < BookSnapshot::sideCount; side++)
+    {
+        const std::vector<BookSnapshot::Level>& expectedLevels = expected.sides[side];
+        const std::vector<BookSnapshot::Level>& actualLevels = actual.sides[side];
+        std::size_t levelCount = std::max(expectedLevels.size(), actualLevels.size());
+        for (std::size_t i = 0; i < levelCount; i++)
+        {
+            if (i < expectedLevels.size() && i < actualLevels.size() && expectedLevels[i] == actualLevels[i])
+            {
+                continue;
+            }
+            std::ostringstream out;
+            out << sideNames[side] << " level " << i << ", expected ";
+            if (i < expectedLevels.size())
+            {
+                describeLevel(out, expectedLevels[i]);
+            }
+            else
+            {
+                out << "none";
+            }
+            out << ", got ";
+            if (i < actualLevels.size())
+            {
+                describeLevel(out, actualLevels[i]);
+            }
+            else
+            {
+                out << "none";
+            }
+            difference = out.str();
+            return true;
+        }
+    }
+    return false;
+}
+
+ReferenceBook::ReferenceBook(Price _minPrice, Price _tickSize, std::size_t _levelCount)
+    : minPrice(_minPrice), tickSize(_tickSize), levelCount(_levelCount)
+{
+}
+
+SelfTradePrevention ReferenceBook::getSelfTradePrevention() const
+{
+    return selfTradePrevention;
+}
+
+void ReferenceBook::setSelfTradePrevention(SelfTradePrevention mode)
+{
+    selfTradePrevention = mode;
+}
+
+ReferenceBook::OrderResult ReferenceBook::marketOrder(int orderId, bool buyOrSell, Quantity shares, int ownerId)
+{
+    Quantity remainingShares = match(orderId, buyOrSell, shares, buyOrSell ? std::numeric_limits<Price>::max() : std::numeric_limits<Price>::min(), ownerId);
+    Quantity filledShares = matchedShares;
+    executeStopOrders(buyOrSell);
+    return matchResult(shares, filledShares, remainingShares, false);
+}
+
+ReferenceBook::OrderResult ReferenceBook::addLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, TimeInForce timeInForce, int ownerId)
+{
+    if (!isValidPrice(limitPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orders.count(orderId) != 0)
+    {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    if (timeInForce == TimeInForce::FillOrKill && !canFillWithinLimit(buyOrSell, shares, limitPrice, ownerId))
+    {
+        return { OrderStatus::Killed, 0, shares, false };
+    }
+
+    Quantity remainingShares = match(orderId, buyOrSell, shares, limitPrice, ownerId);
+    Quantity filledShares = matchedShares;
+    if (remainingShares != 0 && timeInForce == TimeInForce::GoodTillCancel)
+    {
+        RestingOrder& order = orders[orderId] = { orderId, buyOrSell, remainingShares, 0, 0, limitPrice, limitPrice, ownerId, LimitKind };
+        queue(order, limitSide(buyOrSell));
+        return matchResult(shares, filledShares, remainingShares, true);
+    }
+    executeStopOrders(buyOrSell);
+    return matchResult(shares, filledShares, remainingShares, false);
+}
+
+ReferenceBook::OrderResult ReferenceBook::addIcebergOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Quantity peakShares, int ownerId)
+{
+    if (!isValidPrice(limitPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orders.count(orderId) != 0)
+    {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    if (peakShares <= 0)
+    {
+        return addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::GoodTillCancel, ownerId);
+    }
+
+    Quantity remainingShares = match(orderId, buyOrSell, shares, limitPrice, ownerId);
+    Quantity filledShares = matchedShares;
+    if (remainingShares != 0)
+    {
+        Quantity displayedShares = std::min(remainingShares, peakShares);
+        RestingOrder& order = orders[orderId] = { orderId, buyOrSell, displayedShares, peakShares, remainingShares - displayedShares, limitPrice, limitPrice, ownerId, LimitKind };
+        queue(order, limitSide(buyOrSell));
+        return matchResult(shares, filledShares, remainingShares, true);
+    }
+    executeStopOrders(buyOrSell);
+    return matchResult(shares, filledShares, 0, false);
+}
+
+ReferenceBook::OrderResult ReferenceBook::cancelLimitOrder(int orderId)
+{
+    RestingOrder* order = findOrder(orderId, LimitKind);
+    if (order == nullptr)
+    {
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    unqueue(*order, limitSide(order->buyOrSell));
+    orders.erase(orderId);
+    cancels.push_back(orderId);
+    return { OrderStatus::Ok, 0, 0, false };
+}
+
+ReferenceBook::OrderResult ReferenceBook::modifyLimitOrder(int orderId, Quantity newShares, Price newLimit)
+{
+    RestingOrder* order = findOrder(orderId, LimitKind);
+    if (order == nullptr)
+    {
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    if (!isValidPrice(newLimit))
+    {
+        return { OrderStatus::InvalidPrice, 0, order->shares + order->hiddenShares, true };
+    }
+    // Modified orders lose their time priority and never match, even when they cross the book
+    unqueue(*order, limitSide(order->buyOrSell));
+    resize(*order, newShares, newLimit);
+    order->level = newLimit;
+    queue(*order, limitSide(order->buyOrSell));
+    return { OrderStatus::Ok, 0, newShares, true };
+}
+
+ReferenceBook::OrderResult ReferenceBook::addStopOrder(int orderId, bool buyOrSell, Quantity shares, Price stopPrice, int ownerId)
+{
+    if (!isValidPrice(stopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orders.count(orderId) != 0)
+    {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    if (stopTriggered(buyOrSell, stopPrice))
+    {
+        return marketOrder(orderId, buyOrSell, shares, ownerId);
+    }
+    RestingOrder& order = orders[orderId] = { orderId, buyOrSell, shares, 0, 0, 0, stopPrice, ownerId, StopKind };
+    queue(order, stopSide(buyOrSell));
+    return { OrderStatus::Ok, 0, shares, true };
+}
+
+ReferenceBook::OrderResult ReferenceBook::cancelStopOrder(int orderId)
+{
+    RestingOrder* order = findOrder(orderId, StopKind);
+    if (order == nullptr)
+    {
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    unqueue(*order, stopSide(order->buyOrSell));
+    orders.erase(orderId);
+    cancels.push_back(orderId);
+    return { OrderStatus::Ok, 0, 0, false };
+}
+
+ReferenceBook::OrderResult ReferenceBook::modifyStopOrder(int orderId, Quantity newShares, Price newStopPrice)
+{
+    RestingOrder* order = findOrder(orderId, StopKind);
+    if (order == nullptr)
+    {
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    if (!isValidPrice(newStopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, order->shares, true };
+    }
+    // A modified stop isn't checked against the book until the next order of its side
+    unqueue(*order, stopSide(order->buyOrSell));
+    resize(*order, newShares, 0);
+    order->level = newStopPrice;
+    queue(*order, stopSide(order->buyOrSell));
+    return { OrderStatus::Ok, 0, newShares, true };
+}
+
+ReferenceBook::OrderResult ReferenceBook::addStopLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Price stopPrice, int ownerId)
+{
+    if (!isValidPrice(limitPrice) || !isValidPrice(stopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orders.count(orderId) != 0)
+    {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    if (stopTriggered(buyOrSell, stopPrice))
+    {
+        return addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::GoodTillCancel, ownerId);
+    }
+    RestingOrder& order = orders[orderId] = { orderId, buyOrSell, shares, 0, 0, limitPrice, stopPrice, ownerId, StopLimitKind };
+    queue(order, stopSide(buyOrSell));
+    return { OrderStatus::Ok, 0, shares, true };
+}
+
+ReferenceBook::OrderResult ReferenceBook::cancelStopLimitOrder(int orderId)
+{
+    RestingOrder* order = findOrder(orderId, StopLimitKind);
+    if (order == nullptr)
+    {
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    unqueue(*order, stopSide(order->buyOrSell));
+    orders.erase(orderId);
+    cancels.push_back(orderId);
+    return { OrderStatus::Ok, 0, 0, false };
+}
+
+ReferenceBook::OrderResult ReferenceBook::modifyStopLimitOrder(int orderId, Quantity newShares, Price newLimitPrice, Price newStopPrice)
+{
+    RestingOrder* order = findOrder(orderId, StopLimitKind);
+    if (order == nullptr)
+    {
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    if (!isValidPrice(newLimitPrice) || !isValidPrice(newStopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, order->shares, true };
+    }
+    unqueue(*order, stopSide(order->buyOrSell));
+    resize(*order, newShares, newLimitPrice);
+    order->level = newStopPrice;
+    queue(*order, stopSide(order->buyOrSell));
+    return { OrderStatus::Ok, 0, newShares, true };
+}
+
+const std::map<int, ReferenceBook::RestingOrder>& ReferenceBook::getOrders() const
+{
+    return orders;
+}
+
+BookSnapshot ReferenceBook::snapshot() const
+{
+    BookSnapshot result;
+    const Levels* sides[BookSnapshot::sideCount] = { &buyLimits, &sellLimits, &stopBuys, &stopSells };
+    for (int side = 0; side < BookSnapshot::sideCount; side++)
+    {
+        for (const auto& [price, level] : *sides[side])
+        {
+            BookSnapshot::Level& snapshotLevel = result.sides[side].emplace_back();
+            snapshotLevel.price = price;
+            snapshotLevel.volume = levelVolume(level);
+            snapshotLevel.hiddenVolume = levelReserve(level);
+            snapshotLevel.size = static_cast<int>(level.size());
+            for (int orderId : level)
+            {
+                const RestingOrder& order = orders.at(orderId);
+                snapshotLevel.orders.push_back({ orderId, order.shares, order.hiddenShares });
+            }
+        }
+    }
+    return result;
+}
+
+bool ReferenceBook::isValidPrice(Price price) const
+{
+    return price >= minPrice && (price - minPrice) % tickSize == 0 && static_cast<std::size_t>((price - minPrice) / tickSize) < levelCount;
+}
+
+ReferenceBook::Levels& ReferenceBook::limitSide(bool buyOrSell)
+{
+    return buyOrSell ? buyLimits : sellLimits;
+}
+
+ReferenceBook::Levels& ReferenceBook::stopSide(bool buyOrSell)
+{
+    return buyOrSell ? stopBuys : stopSells;
+}
+
+ReferenceBook::RestingOrder* ReferenceBook::findOrder(int orderId, Kind kind)
+{
+    auto it = orders.find(orderId);
+    return it != orders.end() && it->second.kind == kind ? &it->second : nullptr;
+}
+
+void ReferenceBook::queue(RestingOrder& order, Levels& side)
+{
+    side[order.level].push_back(order.orderId);
+}
+
+void ReferenceBook::unqueue(const RestingOrder& order, Levels& side)
+{
+    auto level = side.find(order.level);
+    level->second.remove(order.orderId);
+    if (level->second.empty())
+    {
+        side.erase(level);
+    }
+}
+
+// Iceberg orders are modified by their total size and split again
+void ReferenceBook::resize(RestingOrder& order, Quantity newShares, Price newLimit)
+{
+    if (order.peakShares != 0)
+    {
+        order.shares = std::min(newShares, order.peakShares);
+        order.hiddenShares = newShares - order.shares;
+    }
+    else
+    {
+        order.shares = newShares;
+    }
+    order.limit = newLimit;
+}
+
+// Refill the displayed shares of the iceberg order at the head of level from its reserve
+// and move it to the back of the level
+void ReferenceBook::replenish(RestingOrder& order, std::list<int>& level)
+{
+    level.pop_front();
+    order.shares = std::min(order.hiddenShares, order.peakShares);
+    order.hiddenShares -= order.shares;
+    level.push_back(order.orderId);
+}
+
+ReferenceBook::Quantity ReferenceBook::match(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, int ownerId)
+{
+    Levels& oppositeSide = limitSide(!buyOrSell);
+    const int selfTradeOwner = (selfTradePrevention == SelfTradePrevention::None || ownerId == noOwner) ? -1 : ownerId;
+    matchedShares = 0;
+
+    while (shares != 0 && !oppositeSide.empty())
+    {
+        auto best = buyOrSell ? oppositeSide.begin() : std::prev(oppositeSide.end());
+        Price price = best->first;
+        if (buyOrSell ? price > limitPrice : price < limitPrice)
+        {
+            break;
+        }
+
+        std::list<int>& level = best->second;
+        while (shares != 0)
+        {
+            RestingOrder& head = orders.at(level.front());
+            if (head.ownerId == selfTradeOwner)
+            {
+                shares = preventSelfTrade(head, level, shares);
+                if (level.empty())
+                {
+                    oppositeSide.erase(best);
+                    break;
+                }
+                continue;
+            }
+            if (head.shares > shares)
+            {
+                trades.push_back({ head.orderId, orderId, price, shares });
+                head.shares -= shares;
+                matchedShares += shares;
+                return 0;
+            }
+            trades.push_back({ head.orderId, orderId, price, head.shares });
+            matchedShares += head.shares;
+            shares -= head.shares;
+            if (head.hiddenShares != 0)
+            {
+                replenish(head, level);
+                continue;
+            }
+            int headOrderId = head.orderId;
+            level.pop_front();
+            orders.erase(headOrderId);
+            if (level.empty())
+            {
+                oppositeSide.erase(best);
+                break;
+            }
+        }
+    }
+    return shares;
+}
+
+// The resting order is always the head of its level under FIFO matching
+ReferenceBook::Quantity ReferenceBook::preventSelfTrade(RestingOrder& restingOrder, std::list<int>& level, Quantity shares)
+{
+    if (selfTradePrevention == SelfTradePrevention::CancelNewest)
+    {
+        return 0;
+    }
+
+    Quantity decrement = restingOrder.shares;
+    if (selfTradePrevention == SelfTradePrevention::DecrementBoth)
+    {
+        if (shares < decrement)
+        {
+            restingOrder.shares -= shares;
+            return 0;
+        }
+        if (restingOrder.hiddenShares != 0)
+        {
+            replenish(restingOrder, level);
+            return shares - decrement;
+        }
+    }
+
+    int restingOrderId = restingOrder.orderId;
+    level.pop_front();
+    orders.erase(restingOrderId);
+    cancels.push_back(restingOrderId);
+    return selfTradePrevention == SelfTradePrevention::DecrementBoth ? shares - decrement : shares;
+}
+
+bool ReferenceBook::stopTriggered(bool buyOrSell, Price stopPrice) const
+{
+    if (buyOrSell)
+    {
+        return !sellLimits.empty() && stopPrice <= sellLimits.begin()->first;
+    }
+    return !buyLimits.empty() && stopPrice >= buyLimits.rbegin()->first;
+}
+
+// Stops of one side are triggered by the edge of the opposite side, or unconditionally
+// once it is empty. Stop orders which can't be filled are forgotten, stop limit orders
+// rest whatever they can't fill as limit orders.
+void ReferenceBook::executeStopOrders(bool buyOrSell)
+{
+    Levels& stops = stopSide(buyOrSell);
+    const Levels& oppositeSide = limitSide(!buyOrSell);
+    while (!stops.empty())
+    {
+        auto stopLevel = buyOrSell ? stops.begin() : std::prev(stops.end());
+        if (!oppositeSide.empty() && (buyOrSell ? stopLevel->first > oppositeSide.begin()->first : stopLevel->first < oppositeSide.rbegin()->first))
+        {
+            break;
+        }
+
+        int orderId = stopLevel->second.front();
+        stopLevel->second.pop_front();
+        if (stopLevel->second.empty())
+        {
+            stops.erase(stopLevel);
+        }
+
+        RestingOrder& order = orders.at(orderId);
+        if (order.limit == 0)
+        {
+            Quantity shares = order.shares;
+            int ownerId = order.ownerId;
+            orders.erase(orderId);
+            match(0, buyOrSell, shares, buyOrSell ? std::numeric_limits<Price>::max() : std::numeric_limits<Price>::min(), ownerId);
+            continue;
+        }
+
+        Quantity shares = match(orderId, buyOrSell, order.shares, order.limit, order.ownerId);
+        if (shares == 0)
+        {
+            orders.erase(orderId);
+            continue;
+        }
+        order.shares = shares;
+        order.level = order.limit;
+        order.kind = LimitKind;
+        queue(order, limitSide(buyOrSell));
+    }
+}
+
+// A fill or kill order fills completely when it does so on a copy of the book
+bool ReferenceBook::canFillWithinLimit(bool buyOrSell, Quantity shares, Price limitPrice, int ownerId) const
+{
+    ReferenceBook trial = *this;
+    trial.match(0, buyOrSell, shares, limitPrice, ownerId);
+    return trial.matchedShares == shares;
+}
+
+// Shares of an order which neither traded nor are left were dropped by self trade prevention
+ReferenceBook::OrderResult ReferenceBook::matchResult(Quantity shares, Quantity filledShares, Quantity remainingShares, bool resting)
+{
+    Quantity cancelledShares = shares - filledShares - remainingShares;
+    return { cancelledShares != 0 ? OrderStatus::SelfTradeCancelled : OrderStatus::Ok, filledShares, remainingShares, resting, cancelledShares };
+}
+
+ReferenceBook::Quantity ReferenceBook::levelVolume(const std::list<int>& level) const
+{
+    Quantity volume = 0;
+    for (int orderId : level)
+    {
+        volume += orders.at(orderId).shares;
+    }
+    return volume;
+}
+
+// Iceberg shares at a level which aren't displayed, they refill the level as it trades
+ReferenceBook::Quantity ReferenceBook::levelReserve(const std::list<int>& level) const
+{
+    Quantity reserve = 0;
+    for (int orderId : level)
+    {
+        reserve += orders.at(orderId).hiddenShares;
+    }
+    return reserve;
+}
@@ -0,0 +1,134 @@
+#ifndef REFERENCEBOOK_HPP
+#define REFERENCEBOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../Order_Book/OrderTypes.hpp"
+
+// Resting orders of a book side by side in ascending price order, the same shape for
+// BasicBook and ReferenceBook so the fuzzer can compare them after every command
+struct BookSnapshot {
+	struct SnapshotOrder {
+		int orderId;
+		std::int64_t shares;
+		std::int64_t hiddenShares;
+
+		bool operator==(const SnapshotOrder&) const = default;
+	};
+
+	struct Level {
+		std::int64_t price;
+		std::int64_t volume;   // Volume the level reports, checked against its orders
+		std::int64_t hiddenVolume;  // Iceberg reserve the level reports
+		int size;
+		std::vector<SnapshotOrder> orders;
+
+		bool operator==(const Level&) const = default;
+	};
+
+	enum Side { Buys, Sells, StopBuys, StopSells, sideCount };
+	std::vector<Level> sides[sideCount];
+};
+
+// Describe the first difference between two snapshots, false if they are equal
+bool describeDifference(const BookSnapshot& expected, const BookSnapshot& actual, std::string& difference);
+
+// Deliberately simple order book with the FIFO matching rules of BasicBook, price levels
+// are std::map entries holding a std::list of order ids. It mirrors the public order API
+// of BasicBook so it can serve as the oracle of the differential fuzzer. Results follow the
+// documented semantics rather than the engine code: duplicate ids are rejected before
+// trading, fill or kill orders are tried on a copy of the book, and shares which neither
+// traded nor are left count as cancelled by self trade prevention.
+class ReferenceBook {
+public:
+	using Price = std::int64_t;
+	using Quantity = std::int64_t;
+	using OrderResult = BasicOrderResult<Quantity>;
+
+	struct Trade {
+		int restingOrderId;
+		int incomingOrderId;
+		Price price;
+		Quantity shares;
+	};
+
+	enum Kind { LimitKind, StopKind, StopLimitKind };
+
+	struct RestingOrder {
+		int orderId;
+		bool buyOrSell;
+		Quantity shares;
+		Quantity peakShares;
+		Quantity hiddenShares;
+		Price limit;     // 0 for stop orders, which is how BasicBook tells them from stop limit orders
+		Price level;     // Price of the level the order is queued at, the stop price for stops
+		int ownerId;
+		Kind kind;
+	};
+
+	// Prices are valid as in BookConfig::isValidPrice
+	ReferenceBook(Price minPrice, Price tickSize, std::size_t levelCount);
+
+	std::vector<Trade> trades;
+	std::vector<int> cancels;
+
+	SelfTradePrevention getSelfTradePrevention() const;
+	void setSelfTradePrevention(SelfTradePrevention mode);
+
+	OrderResult marketOrder(int orderId, bool buyOrSell, Quantity shares, int ownerId = noOwner);
+	OrderResult addLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, TimeInForce timeInForce = TimeInForce::GoodTillCancel, int ownerId = noOwner);
+	OrderResult addIcebergOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Quantity peakShares, int ownerId = noOwner);
+	OrderResult cancelLimitOrder(int orderId);
+	OrderResult modifyLimitOrder(int orderId, Quantity newShares, Price newLimit);
+	OrderResult addStopOrder(int orderId, bool buyOrSell, Quantity shares, Price stopPrice, int ownerId = noOwner);
+	OrderResult cancelStopOrder(int orderId);
+	OrderResult modifyStopOrder(int orderId, Quantity newShares, Price newStopPrice);
+	OrderResult addStopLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Price stopPrice, int ownerId = noOwner);
+	OrderResult cancelStopLimitOrder(int orderId);
+	OrderResult modifyStopLimitOrder(int orderId, Quantity newShares, Price newLimitPrice, Price newStopPrice);
+
+	const std::map<int, RestingOrder>& getOrders() const;
+	BookSnapshot snapshot() const;
+
+private:
+	using Levels = std::map<Price, std::list<int>>;
+
+	Price minPrice;
+	Price tickSize;
+	std::size_t levelCount;
+	SelfTradePrevention selfTradePrevention = SelfTradePrevention::None;
+
+	Levels buyLimits;
+	Levels sellLimits;
+	Levels stopBuys;
+	Levels stopSells;
+	std::map<int, RestingOrder> orders;
+
+	// Shares the incoming order traded in the last call of match
+	Quantity matchedShares = 0;
+
+	bool isValidPrice(Price price) const;
+	Levels& limitSide(bool buyOrSell);
+	Levels& stopSide(bool buyOrSell);
+	RestingOrder* findOrder(int orderId, Kind kind);
+	void queue(RestingOrder& order, Levels& side);
+	void unqueue(const RestingOrder& order, Levels& side);
+	void resize(RestingOrder& order, Quantity newShares, Price newLimit);
+	void replenish(RestingOrder& order, std::list<int>& level);
+
+	Quantity match(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, int ownerId);
+	Quantity preventSelfTrade(RestingOrder& restingOrder, std::list<int>& level, Quantity shares);
+	bool stopTriggered(bool buyOrSell, Price stopPrice) const;
+	void executeStopOrders(bool buyOrSell);
+	bool canFillWithinLimit(bool buyOrSell, Quantity shares, Price limitPrice, int ownerId) const;
+	static OrderResult matchResult(Quantity shares, Quantity filledShares, Quantity remainingShares, bool resting);
+	Quantity levelVolume(const std::list<int>& level) const;
+	Quantity levelReserve(const std::list<int>& level) const;
+};
+
+#endif
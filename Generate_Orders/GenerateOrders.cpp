@@ -64,7 +64,7 @@ void GenerateOrders::cancelLimit()
         addLimit();
         return;
     }
-    int orderId = order->getOrderId();
+    int orderId = order->getOrderId(book->getPools());
     file << "CancelLimit " << orderId << std::endl;
     book->cancelLimitOrder(orderId);
 }
@@ -83,8 +83,8 @@ void GenerateOrders::modifyLimit()
         addLimit();
         return;
     }
-    int orderId = order->getOrderId();
-    bool buyOrSell = order->getBuyOrSell();
+    int orderId = order->getOrderId(book->getPools());
+    bool buyOrSell = order->getBuyOrSell(book->getPools());
     int limitPrice;
     if (buyOrSell)
     {
@@ -161,7 +161,7 @@ void GenerateOrders::cancelStop()
         addStop();
         return;
     }
-    int orderId = order->getOrderId();
+    int orderId = order->getOrderId(book->getPools());
     file << "CancelStop " << orderId << std::endl;
     book->cancelStopOrder(orderId);
 }
@@ -180,8 +180,8 @@ void GenerateOrders::modifyStop()
         addStop();
         return;
     }
-    int orderId = order->getOrderId();
-    bool buyOrSell = order->getBuyOrSell();
+    int orderId = order->getOrderId(book->getPools());
+    bool buyOrSell = order->getBuyOrSell(book->getPools());
     int stopPrice;
     if (buyOrSell)
     {
@@ -239,7 +239,7 @@ void GenerateOrders::cancelStopLimit()
         addStopLimit();
         return;
     }
-    int orderId = order->getOrderId();
+    int orderId = order->getOrderId(book->getPools());
     file << "CancelStopLimit " << orderId << std::endl;
     book->cancelStopLimitOrder(orderId);
 }
@@ -259,8 +259,8 @@ void GenerateOrders::modifyStopLimit()
         addStopLimit();
         return;
     }
-    int orderId = order->getOrderId();
-    bool buyOrSell = order->getBuyOrSell();
+    int orderId = order->getOrderId(book->getPools());
+    bool buyOrSell = order->getBuyOrSell(book->getPools());
     int stopPrice;
     int limitPrice;
     if (buyOrSell)
@@ -4,7 +4,7 @@
 #include <random>
 #include <fstream>
 
-class Book;
+#include "../Order_Book/BookConfig.hpp"
 
 class GenerateOrders {
 private:
@@ -0,0 +1,616 @@
+#include "OfflineGenerator.hpp"
+#include "../Order_Book/OrderTypes.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
+#include <omp.h>
+
+OfflineGenerator::OfflineGenerator(const Scenario& _scenario, int _threadCount)
+    : scenario(_scenario), threadCount(_threadCount > 0 ? _threadCount : omp_get_max_threads())
+{
+    std::array<double, commandTypeCount> weights = scenario.commandWeights(false);
+    commandDist = std::discrete_distribution<int>(weights.begin(), weights.end());
+    weights = scenario.commandWeights(true);
+    flashCrashCommandDist = std::discrete_distribution<int>(weights.begin(), weights.end());
+
+    std::size_t window = static_cast<std::size_t>(std::max(scenario.cancelWindow, 1));
+    zipfCumulative.resize(window);
+    double total = 0;
+    for (std::size_t rank = 0; rank < window; rank++)
+    {
+        total += std::pow(static_cast<double>(rank + 1), -scenario.cancelZipfExponent);
+        zipfCumulative[rank] = total;
+    }
+
+    flashCrashBegin = scenario.flashCrashStart < 0 ? scenario.orderCount
+        : static_cast<long long>(scenario.flashCrashStart * scenario.orderCount);
+    flashCrashCommands = std::max(static_cast<long long>(scenario.flashCrashLength * scenario.orderCount), 1LL);
+
+    // The initial orders are generated once, every chunk starts from the depth they leave
+    Chunk chunk;
+    chunk.bidVolume.assign(Config::levelCount, 0);
+    chunk.askVolume.assign(Config::levelCount, 0);
+    chunk.fairPrice = std::clamp(scenario.startPrice, static_cast<double>(lowestTick()), static_cast<double>(highestTick()));
+    std::seed_seq initialSeed{ static_cast<std::uint32_t>(scenario.seed), static_cast<std::uint32_t>(scenario.seed >> 32), ~0u };
+    chunk.gen.seed(initialSeed);
+
+    std::bernoulli_distribution sideDist(0.5);
+    initialCommands.reserve(static_cast<std::size_t>(std::max(scenario.initialOrders, 0)));
+    for (int i = 0; i < scenario.initialOrders; i++)
+    {
+        Command command = {};
+        command.type = CommandType::AddLimit;
+        command.orderId = scenario.firstOrderId + i;
+        command.buyOrSell = sideDist(chunk.gen);
+        command.shares = sampleShares(chunk);
+        int tick = passiveTick(chunk, command.buyOrSell);
+        command.price = Config::fromTick(tick);
+        command.ownerId = sampleOwner(chunk);
+        addVolume(chunk, command.buyOrSell, tick, command.shares);
+        initialCommands.push_back(command);
+    }
+    initialBidVolume = std::move(chunk.bidVolume);
+    initialAskVolume = std::move(chunk.askVolume);
+}
+
+// Fair price the stream is expected to have reached at a command, the mean of the price process
+double OfflineGenerator::expectedFairPrice(long long index) const
+{
+    double price = scenario.startPrice;
+    if (scenario.midModel == MidModel::Trend)
+    {
+        price += scenario.drift * index;
+    }
+    else if (scenario.midModel == MidModel::MeanReverting)
+    {
+        price = scenario.meanPrice + (scenario.startPrice - scenario.meanPrice) * std::pow(1 - scenario.meanReversion, index);
+    }
+
+    if (index > flashCrashBegin)
+    {
+        long long crashed = std::min(index - flashCrashBegin, flashCrashCommands);
+        double drop = scenario.flashCrashDepth * crashed / flashCrashCommands;
+        if (scenario.midModel == MidModel::MeanReverting && index > flashCrashBegin + flashCrashCommands)
+        {
+            drop *= std::pow(1 - scenario.meanReversion, index - flashCrashBegin - flashCrashCommands);
+        }
+        price -= drop;
+    }
+    return std::clamp(price, static_cast<double>(lowestTick()), static_cast<double>(highestTick()));
+}
+
+// Start a chunk from the initial depth, moved to the fair price expected at its first command
+void OfflineGenerator::resetChunk(Chunk& chunk, long long chunkIndex) const
+{
+    long long firstIndex = chunkIndex * static_cast<long long>(chunkSize);
+    chunk.fairPrice = expectedFairPrice(firstIndex);
+    int shift = static_cast<int>(std::lround(chunk.fairPrice - std::clamp(scenario.startPrice,
+        static_cast<double>(lowestTick()), static_cast<double>(highestTick()))));
+
+    chunk.bidVolume.assign(Config::levelCount, 0);
+    chunk.askVolume.assign(Config::levelCount, 0);
+    chunk.buyVolume = chunk.sellVolume = 0;
+    chunk.bestBid = -1;
+    chunk.bestAsk = static_cast<int>(Config::levelCount);
+    for (int tick = lowestTick(); tick <= highestTick(); tick++)
+    {
+        int shifted = tick + shift;
+        if (shifted < lowestTick() || shifted > highestTick())
+        {
+            continue;
+        }
+        if (initialBidVolume[tick] > 0)
+        {
+            addVolume(chunk, true, shifted, initialBidVolume[tick]);
+        }
+        if (initialAskVolume[tick] > 0)
+        {
+            addVolume(chunk, false, shifted, initialAskVolume[tick]);
+        }
+    }
+
+    chunk.recentOrders.resize(zipfCumulative.size());
+    chunk.recentCount = chunk.recentNext = 0;
+    chunk.stops.clear();
+    chunk.stopLimits.clear();
+
+    std::seed_seq chunkSeed{ static_cast<std::uint32_t>(scenario.seed), static_cast<std::uint32_t>(scenario.seed >> 32),
+        static_cast<std::uint32_t>(chunkIndex), static_cast<std::uint32_t>(chunkIndex >> 32) };
+    chunk.gen.seed(chunkSeed);
+    chunk.commandDist = commandDist;
+    chunk.flashCrashCommandDist = flashCrashCommandDist;
+    chunk.noiseDist = std::normal_distribution<>(0.0, scenario.volatility);
+    chunk.clock = 0;
+    chunk.bursting = false;
+    chunk.commandsUntilSwitch = commandsUntilSwitch(chunk);
+}
+
+// Geometric offset with the given mean conditioned on being at most limit, drawn by
+// inverting its distribution function so it never has to be redrawn
+int OfflineGenerator::truncatedGeometric(double mean, int limit, std::mt19937_64& gen)
+{
+    if (limit <= 0 || mean <= 0)
+    {
+        return 0;
+    }
+    double q = mean / (1 + mean);
+    double mass = 1 - std::pow(q, limit + 1);
+    double u = std::uniform_real_distribution<>(0.0, 1.0)(gen);
+    int offset = static_cast<int>(std::log1p(-u * mass) / std::log(q));
+    return std::min(offset, limit);
+}
+
+void OfflineGenerator::addVolume(Chunk& chunk, bool buyOrSell, int tick, std::int64_t shares) const
+{
+    if (buyOrSell)
+    {
+        chunk.bidVolume[tick] += shares;
+        chunk.buyVolume += shares;
+        chunk.bestBid = std::max(chunk.bestBid, tick);
+    }
+    else
+    {
+        chunk.askVolume[tick] += shares;
+        chunk.sellVolume += shares;
+        chunk.bestAsk = std::min(chunk.bestAsk, tick);
+    }
+}
+
+// Levels only empty out at the touch or behind it, so the touch walks outwards to the next volume
+void OfflineGenerator::removeVolume(Chunk& chunk, bool buyOrSell, int tick, std::int64_t shares) const
+{
+    if (buyOrSell)
+    {
+        shares = std::min(shares, chunk.bidVolume[tick]);
+        chunk.bidVolume[tick] -= shares;
+        chunk.buyVolume -= shares;
+        if (chunk.buyVolume == 0)
+        {
+            chunk.bestBid = -1;
+        }
+        while (chunk.bestBid >= 0 && chunk.bidVolume[chunk.bestBid] == 0)
+        {
+            chunk.bestBid--;
+        }
+    }
+    else
+    {
+        shares = std::min(shares, chunk.askVolume[tick]);
+        chunk.askVolume[tick] -= shares;
+        chunk.sellVolume -= shares;
+        if (chunk.sellVolume == 0)
+        {
+            chunk.bestAsk = static_cast<int>(Config::levelCount);
+        }
+        while (chunk.bestAsk < static_cast<int>(Config::levelCount) && chunk.askVolume[chunk.bestAsk] == 0)
+        {
+            chunk.bestAsk++;
+        }
+    }
+}
+
+// Volume an order on the given side could take up to its limit
+std::int64_t OfflineGenerator::availableVolume(const Chunk& chunk, bool buyOrSell, int limitTick) const
+{
+    std::int64_t volume = 0;
+    if (buyOrSell)
+    {
+        for (int tick = chunk.bestAsk; tick <= limitTick && tick < static_cast<int>(Config::levelCount); tick++)
+        {
+            volume += chunk.askVolume[tick];
+        }
+    }
+    else
+    {
+        for (int tick = chunk.bestBid; tick >= limitTick && tick >= 0; tick--)
+        {
+            volume += chunk.bidVolume[tick];
+        }
+    }
+    return volume;
+}
+
+// Match an incoming order against the opposite side up to its limit and return what's left of it
+std::int64_t OfflineGenerator::takeVolume(Chunk& chunk, bool buyOrSell, int limitTick, std::int64_t shares) const
+{
+    if (buyOrSell)
+    {
+        while (shares > 0 && chunk.sellVolume > 0 && chunk.bestAsk <= limitTick)
+        {
+            std::int64_t taken = std::min(shares, chunk.askVolume[chunk.bestAsk]);
+            shares -= taken;
+            removeVolume(chunk, false, chunk.bestAsk, taken);
+        }
+    }
+    else
+    {
+        while (shares > 0 && chunk.buyVolume > 0 && chunk.bestBid >= limitTick)
+        {
+            std::int64_t taken = std::min(shares, chunk.bidVolume[chunk.bestBid]);
+            shares -= taken;
+            removeVolume(chunk, true, chunk.bestBid, taken);
+        }
+    }
+    return shares;
+}
+
+// Exponential gaps between commands, at the burst rate while a burst lasts. The state switches
+// with a fixed probability per command, so the commands until the next switch are geometric.
+void OfflineGenerator::advanceClock(Chunk& chunk) const
+{
+    while (chunk.commandsUntilSwitch == 0)
+    {
+        chunk.bursting = !chunk.bursting;
+        chunk.commandsUntilSwitch = commandsUntilSwitch(chunk);
+    }
+    chunk.commandsUntilSwitch--;
+    std::exponential_distribution<> gapDist(chunk.bursting ? scenario.burstRate : scenario.arrivalRate);
+    chunk.clock += static_cast<std::int64_t>(gapDist(chunk.gen) * 1e9);
+}
+
+long long OfflineGenerator::commandsUntilSwitch(Chunk& chunk) const
+{
+    double probability = chunk.bursting ? scenario.burstEndProbability : scenario.burstStartProbability;
+    if (probability <= 0)
+    {
+        return LLONG_MAX;
+    }
+    if (probability >= 1)
+    {
+        return 1;
+    }
+    return 1 + std::geometric_distribution<long long>(probability)(chunk.gen);
+}
+
+void OfflineGenerator::advanceFairPrice(Chunk& chunk, bool inFlashCrash) const
+{
+    if (scenario.midModel == MidModel::Trend)
+    {
+        chunk.fairPrice += scenario.drift;
+    }
+    else if (scenario.midModel == MidModel::MeanReverting)
+    {
+        chunk.fairPrice += scenario.meanReversion * (scenario.meanPrice - chunk.fairPrice);
+    }
+    if (scenario.midModel != MidModel::Static)
+    {
+        chunk.fairPrice += chunk.noiseDist(chunk.gen);
+    }
+    if (inFlashCrash)
+    {
+        chunk.fairPrice -= scenario.flashCrashDepth / flashCrashCommands;
+    }
+    chunk.fairPrice = std::clamp(chunk.fairPrice, static_cast<double>(lowestTick()), static_cast<double>(highestTick()));
+}
+
+// Passive orders rest behind the touch, their distance is truncated at the end of the book
+int OfflineGenerator::passiveTick(Chunk& chunk, bool buyOrSell) const
+{
+    int fair = static_cast<int>(std::lround(chunk.fairPrice));
+    if (buyOrSell)
+    {
+        int anchor = std::clamp(std::min(fair - 1, chunk.bestAsk - 1), lowestTick(), highestTick());
+        return anchor - truncatedGeometric(scenario.depthMeanTicks, anchor - lowestTick(), chunk.gen);
+    }
+    int anchor = std::clamp(std::max(fair + 1, chunk.bestBid + 1), lowestTick(), highestTick());
+    return anchor + truncatedGeometric(scenario.depthMeanTicks, highestTick() - anchor, chunk.gen);
+}
+
+// Marketable orders cross the opposite touch by a few ticks
+int OfflineGenerator::marketableTick(Chunk& chunk, bool buyOrSell) const
+{
+    int fair = static_cast<int>(std::lround(chunk.fairPrice));
+    if (buyOrSell)
+    {
+        int touch = std::clamp(chunk.sellVolume > 0 ? chunk.bestAsk : fair, lowestTick(), highestTick());
+        return touch + std::uniform_int_distribution<>(0, std::min(scenario.maxCrossTicks, highestTick() - touch))(chunk.gen);
+    }
+    int touch = std::clamp(chunk.buyVolume > 0 ? chunk.bestBid : fair, lowestTick(), highestTick());
+    return touch - std::uniform_int_distribution<>(0, std::min(scenario.maxCrossTicks, touch - lowestTick()))(chunk.gen);
+}
+
+// Stops sit beyond the opposite touch so they don't trigger on arrival
+int OfflineGenerator::stopTick(Chunk& chunk, bool buyOrSell) const
+{
+    int fair = static_cast<int>(std::lround(chunk.fairPrice));
+    if (buyOrSell)
+    {
+        int anchor = std::clamp((chunk.sellVolume > 0 ? chunk.bestAsk : fair) + 1, lowestTick(), highestTick());
+        return anchor + truncatedGeometric(scenario.depthMeanTicks, highestTick() - anchor, chunk.gen);
+    }
+    int anchor = std::clamp((chunk.buyVolume > 0 ? chunk.bestBid : fair) - 1, lowestTick(), highestTick());
+    return anchor - truncatedGeometric(scenario.depthMeanTicks, anchor - lowestTick(), chunk.gen);
+}
+
+// Limit of a stop limit order, past its stop by up to stopLimitOffsetTicks
+int OfflineGenerator::stopLimitTick(Chunk& chunk, bool buyOrSell, int stop) const
+{
+    int offset = std::uniform_int_distribution<>(1, std::max(scenario.stopLimitOffsetTicks, 1))(chunk.gen);
+    return std::clamp(buyOrSell ? stop + offset : stop - offset, lowestTick(), highestTick());
+}
+
+std::int64_t OfflineGenerator::sampleShares(Chunk& chunk) const
+{
+    return std::uniform_int_distribution<>(scenario.minShares, scenario.maxShares)(chunk.gen);
+}
+
+int OfflineGenerator::sampleOwner(Chunk& chunk) const
+{
+    if (scenario.ownerCount <= 0)
+    {
+        return noOwner;
+    }
+    return std::uniform_int_distribution<>(1, scenario.ownerCount)(chunk.gen);
+}
+
+// Pick a recent limit order, the k-th most recent with probability proportional to k^-exponent
+OfflineGenerator::RecentOrder* OfflineGenerator::pickRecentOrder(Chunk& chunk) const
+{
+    if (chunk.recentCount == 0)
+    {
+        return nullptr;
+    }
+    std::uniform_real_distribution<> weightDist(0.0, zipfCumulative[chunk.recentCount - 1]);
+    std::size_t rank = std::upper_bound(zipfCumulative.begin(), zipfCumulative.begin() + chunk.recentCount,
+        weightDist(chunk.gen)) - zipfCumulative.begin();
+    rank = std::min(rank, chunk.recentCount - 1);
+    std::size_t size = chunk.recentOrders.size();
+    return &chunk.recentOrders[(chunk.recentNext + size - 1 - rank) % size];
+}
+
+void OfflineGenerator::rememberOrder(Chunk& chunk, const RecentOrder& order) const
+{
+    chunk.recentOrders[chunk.recentNext] = order;
+    chunk.recentNext = (chunk.recentNext + 1) % chunk.recentOrders.size();
+    chunk.recentCount = std::min(chunk.recentCount + 1, chunk.recentOrders.size());
+}
+
+Command OfflineGenerator::nextCommand(Chunk& chunk, long long index) const
+{
+    bool inFlashCrash = index >= flashCrashBegin && index < flashCrashBegin + flashCrashCommands;
+    advanceClock(chunk);
+    advanceFairPrice(chunk, inFlashCrash);
+
+    std::bernoulli_distribution sideDist(inFlashCrash ? 1.0 - scenario.flashCrashSellBias : 0.5);
+    std::bernoulli_distribution evenSideDist(0.5);
+
+    Command command = {};
+    command.timestamp = chunk.clock;
+    command.type = static_cast<CommandType>(inFlashCrash ? chunk.flashCrashCommandDist(chunk.gen) : chunk.commandDist(chunk.gen));
+    command.buyOrSell = evenSideDist(chunk.gen);
+    // New orders are numbered by their position in the stream so chunks never share ids
+    command.orderId = static_cast<int>(scenario.firstOrderId + scenario.initialOrders + index);
+
+    int tick;
+    std::int64_t remaining;
+    RecentOrder* recent;
+    std::vector<StopOrder>* stops;
+    switch (command.type)
+    {
+    case CommandType::Market:
+        command.buyOrSell = sideDist(chunk.gen);
+        command.shares = sampleShares(chunk);
+        takeVolume(chunk, command.buyOrSell, command.buyOrSell ? INT_MAX : INT_MIN, command.shares);
+        break;
+    case CommandType::AddLimit:
+        command.shares = sampleShares(chunk);
+        tick = passiveTick(chunk, command.buyOrSell);
+        command.price = Config::fromTick(tick);
+        addVolume(chunk, command.buyOrSell, tick, command.shares);
+        rememberOrder(chunk, { command.orderId, tick, command.shares, command.buyOrSell });
+        break;
+    case CommandType::AddMarketLimit:
+        command.buyOrSell = sideDist(chunk.gen);
+        command.shares = sampleShares(chunk);
+        tick = marketableTick(chunk, command.buyOrSell);
+        command.price = Config::fromTick(tick);
+        remaining = takeVolume(chunk, command.buyOrSell, tick, command.shares);
+        if (remaining > 0)
+        {
+            addVolume(chunk, command.buyOrSell, tick, remaining);
+        }
+        rememberOrder(chunk, { command.orderId, tick, remaining, command.buyOrSell });
+        break;
+    case CommandType::AddLimitIOC:
+    case CommandType::AddLimitFOK:
+        command.buyOrSell = sideDist(chunk.gen);
+        command.shares = sampleShares(chunk);
+        tick = marketableTick(chunk, command.buyOrSell);
+        command.price = Config::fromTick(tick);
+        if (command.type == CommandType::AddLimitIOC || availableVolume(chunk, command.buyOrSell, tick) >= command.shares)
+        {
+            takeVolume(chunk, command.buyOrSell, tick, command.shares);
+        }
+        break;
+    case CommandType::AddIceberg:
+        command.shares = sampleShares(chunk) * 5;
+        tick = passiveTick(chunk, command.buyOrSell);
+        command.price = Config::fromTick(tick);
+        command.auxiliary = std::max<std::int64_t>(1, static_cast<std::int64_t>(command.shares * scenario.icebergPeakFraction));
+        addVolume(chunk, command.buyOrSell, tick, command.shares);
+        rememberOrder(chunk, { command.orderId, tick, command.shares, command.buyOrSell });
+        break;
+    case CommandType::CancelLimit:
+    case CommandType::ModifyLimit:
+        recent = pickRecentOrder(chunk);
+        if (recent == nullptr)
+        {
+            command.type = CommandType::AddLimit;
+            command.shares = sampleShares(chunk);
+            tick = passiveTick(chunk, command.buyOrSell);
+            command.price = Config::fromTick(tick);
+            addVolume(chunk, command.buyOrSell, tick, command.shares);
+            rememberOrder(chunk, { command.orderId, tick, command.shares, command.buyOrSell });
+            break;
+        }
+        command.orderId = recent->orderId;
+        command.buyOrSell = false;
+        removeVolume(chunk, recent->buyOrSell, recent->tick, recent->shares);
+        if (command.type == CommandType::ModifyLimit)
+        {
+            command.shares = sampleShares(chunk);
+            tick = passiveTick(chunk, recent->buyOrSell);
+            command.price = Config::fromTick(tick);
+            // Modifying an order the shadow has already cancelled misses in the book too
+            if (recent->shares > 0)
+            {
+                addVolume(chunk, recent->buyOrSell, tick, command.shares);
+                recent->tick = tick;
+                recent->shares = command.shares;
+            }
+            return command;
+        }
+        recent->shares = 0;
+        return command;
+    case CommandType::AddStop:
+        command.shares = sampleShares(chunk);
+        command.price = Config::fromTick(stopTick(chunk, command.buyOrSell));
+        chunk.stops.push_back({ command.orderId, command.buyOrSell });
+        break;
+    case CommandType::AddStopLimit:
+        command.shares = sampleShares(chunk);
+        tick = stopTick(chunk, command.buyOrSell);
+        command.auxiliary = Config::fromTick(tick);
+        command.price = Config::fromTick(stopLimitTick(chunk, command.buyOrSell, tick));
+        chunk.stopLimits.push_back({ command.orderId, command.buyOrSell });
+        break;
+    case CommandType::CancelStop:
+    case CommandType::ModifyStop:
+    case CommandType::CancelStopLimit:
+    case CommandType::ModifyStopLimit:
+    {
+        bool stopLimit = command.type == CommandType::CancelStopLimit || command.type == CommandType::ModifyStopLimit;
+        stops = stopLimit ? &chunk.stopLimits : &chunk.stops;
+        if (stops->empty())
+        {
+            command.type = stopLimit ? CommandType::AddStopLimit : CommandType::AddStop;
+            command.shares = sampleShares(chunk);
+            tick = stopTick(chunk, command.buyOrSell);
+            command.price = Config::fromTick(tick);
+            if (stopLimit)
+            {
+                command.auxiliary = command.price;
+                command.price = Config::fromTick(stopLimitTick(chunk, command.buyOrSell, tick));
+            }
+            stops->push_back({ command.orderId, command.buyOrSell });
+            break;
+        }
+        std::size_t position = std::uniform_int_distribution<std::size_t>(0, stops->size() - 1)(chunk.gen);
+        StopOrder stop = (*stops)[position];
+        command.orderId = stop.orderId;
+        command.buyOrSell = false;
+        if (command.type == CommandType::CancelStop || command.type == CommandType::CancelStopLimit)
+        {
+            (*stops)[position] = stops->back();
+            stops->pop_back();
+            return command;
+        }
+        command.shares = sampleShares(chunk);
+        tick = stopTick(chunk, stop.buyOrSell);
+        command.price = Config::fromTick(tick);
+        if (stopLimit)
+        {
+            command.auxiliary = command.price;
+            command.price = Config::fromTick(stopLimitTick(chunk, stop.buyOrSell, tick));
+        }
+        return command;
+    }
+    }
+
+    command.ownerId = sampleOwner(chunk);
+    return command;
+}
+
+void OfflineGenerator::generateChunk(Chunk& chunk, long long chunkIndex, long long commandCount, std::vector<Command>& commands) const
+{
+    resetChunk(chunk, chunkIndex);
+    long long firstIndex = chunkIndex * static_cast<long long>(chunkSize);
+    commands.resize(static_cast<std::size_t>(commandCount));
+    for (long long i = 0; i < commandCount; i++)
+    {
+        commands[static_cast<std::size_t>(i)] = nextCommand(chunk, firstIndex + i);
+    }
+}
+
+bool OfflineGenerator::createInitialOrders(const std::string& filePath, CommandFormat format)
+{
+    CommandWriter writer;
+    if (!writer.open(filePath, format))
+    {
+        std::cerr << "Error opening file for writing: " << filePath << std::endl;
+        return false;
+    }
+    for (const Command& command : initialCommands)
+    {
+        writer.write(command);
+    }
+    writer.close();
+    return true;
+}
+
+// Chunks are generated a round at a time, one per thread, and written in stream order
+bool OfflineGenerator::createOrders(const std::string& filePath, CommandFormat format)
+{
+    long long orderCount = std::max(scenario.orderCount, 0);
+    if (static_cast<long long>(scenario.firstOrderId) + scenario.initialOrders + orderCount > INT_MAX)
+    {
+        std::cerr << "Order ids of the scenario don't fit in 32 bits" << std::endl;
+        return false;
+    }
+
+    CommandWriter writer;
+    if (!writer.open(filePath, format))
+    {
+        std::cerr << "Error opening file for writing: " << filePath << std::endl;
+        return false;
+    }
+
+    long long chunkCount = (orderCount + static_cast<long long>(chunkSize) - 1) / static_cast<long long>(chunkSize);
+    std::vector<Chunk> chunks(threadCount);
+    std::vector<std::vector<Command>> commands(threadCount);
+    std::vector<std::vector<char>> text(threadCount);
+    std::int64_t clockOffset = 0;
+
+    for (long long round = 0; round < chunkCount; round += threadCount)
+    {
+        int roundChunks = static_cast<int>(std::min<long long>(threadCount, chunkCount - round));
+
+        #pragma omp parallel for schedule(dynamic) num_threads(threadCount)
+        for (int slot = 0; slot < roundChunks; slot++)
+        {
+            long long chunkIndex = round + slot;
+            long long commandCount = std::min<long long>(chunkSize, orderCount - chunkIndex * static_cast<long long>(chunkSize));
+            generateChunk(chunks[slot], chunkIndex, commandCount, commands[slot]);
+
+            if (format == CommandFormat::Text)
+            {
+                text[slot].resize(commands[slot].size() * maxFormattedCommandSize);
+                char* out = text[slot].data();
+                for (const Command& command : commands[slot])
+                {
+                    out = formatCommand(command, out);
+                }
+                text[slot].resize(out - text[slot].data());
+            }
+        }
+
+        for (int slot = 0; slot < roundChunks; slot++)
+        {
+            if (format == CommandFormat::Text)
+            {
+                writer.writeRaw(text[slot].data(), text[slot].size());
+                continue;
+            }
+            for (Command& command : commands[slot])
+            {
+                command.timestamp += clockOffset;
+            }
+            writer.writeRaw(reinterpret_cast<const char*>(commands[slot].data()), commands[slot].size() * sizeof(Command));
+            clockOffset = commands[slot].back().timestamp;
+        }
+    }
+    writer.close();
+    return true;
+}
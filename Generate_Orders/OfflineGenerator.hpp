@@ -0,0 +1,117 @@
+#ifndef OFFLINEGENERATOR_HPP
+#define OFFLINEGENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Order_Book/BookConfig.hpp"
+#include "../Process_Orders/Command.hpp"
+#include "Scenario.hpp"
+
+// Generates the order stream of a Scenario without a Book. Each chunk of the stream runs
+// against its own shadow of the book, aggregate volume per tick plus the ids it can cancel,
+// so chunks are generated in parallel and prices are drawn from truncated distributions
+// instead of being redrawn until they are valid.
+// Every chunk is seeded from the scenario seed and its index and starts from the initial
+// depth around the expected fair price at its first command, so the output doesn't depend
+// on the number of threads. The shadow is approximate: orders of an earlier chunk are never
+// cancelled, fills aren't attributed to orders and stops aren't triggered.
+class OfflineGenerator {
+private:
+	using Config = DefaultBookConfig;
+
+	static constexpr std::size_t chunkSize = 1 << 16;
+
+	struct RecentOrder {
+		int orderId;
+		int tick;
+		std::int64_t shares;
+		bool buyOrSell;
+	};
+
+	struct StopOrder {
+		int orderId;
+		bool buyOrSell;
+	};
+
+	// Shadow of the book and generator state of one chunk
+	struct Chunk {
+		std::vector<std::int64_t> bidVolume;
+		std::vector<std::int64_t> askVolume;
+		std::int64_t buyVolume = 0;
+		std::int64_t sellVolume = 0;
+		int bestBid = -1;
+		int bestAsk = static_cast<int>(Config::levelCount);
+		double fairPrice = 0;   // In ticks
+
+		// Recent limit orders cancels and modifies pick from, a cancelled order keeps 0 shares
+		std::vector<RecentOrder> recentOrders;
+		std::size_t recentCount = 0;
+		std::size_t recentNext = 0;
+		std::vector<StopOrder> stops;
+		std::vector<StopOrder> stopLimits;
+
+		std::mt19937_64 gen;
+		std::discrete_distribution<int> commandDist;
+		std::discrete_distribution<int> flashCrashCommandDist;
+		std::normal_distribution<> noiseDist;
+		std::int64_t clock = 0;
+		bool bursting = false;
+		long long commandsUntilSwitch = 0;
+	};
+
+	Scenario scenario;
+	int threadCount;
+
+	std::vector<double> zipfCumulative;
+	std::discrete_distribution<int> commandDist;
+	std::discrete_distribution<int> flashCrashCommandDist;
+
+	// Initial orders and the volume per tick they leave in the book
+	std::vector<Command> initialCommands;
+	std::vector<std::int64_t> initialBidVolume;
+	std::vector<std::int64_t> initialAskVolume;
+
+	long long flashCrashBegin;
+	long long flashCrashCommands;
+
+	static int lowestTick() { return 1; }
+	static int highestTick() { return static_cast<int>(Config::levelCount) - 2; }
+
+	double expectedFairPrice(long long index) const;
+	void resetChunk(Chunk& chunk, long long chunkIndex) const;
+	static int truncatedGeometric(double mean, int limit, std::mt19937_64& gen);
+
+	void addVolume(Chunk& chunk, bool buyOrSell, int tick, std::int64_t shares) const;
+	void removeVolume(Chunk& chunk, bool buyOrSell, int tick, std::int64_t shares) const;
+	std::int64_t availableVolume(const Chunk& chunk, bool buyOrSell, int limitTick) const;
+	std::int64_t takeVolume(Chunk& chunk, bool buyOrSell, int limitTick, std::int64_t shares) const;
+
+	void advanceClock(Chunk& chunk) const;
+	long long commandsUntilSwitch(Chunk& chunk) const;
+	void advanceFairPrice(Chunk& chunk, bool inFlashCrash) const;
+	int passiveTick(Chunk& chunk, bool buyOrSell) const;
+	int marketableTick(Chunk& chunk, bool buyOrSell) const;
+	int stopTick(Chunk& chunk, bool buyOrSell) const;
+	int stopLimitTick(Chunk& chunk, bool buyOrSell, int stop) const;
+	std::int64_t sampleShares(Chunk& chunk) const;
+	int sampleOwner(Chunk& chunk) const;
+
+	RecentOrder* pickRecentOrder(Chunk& chunk) const;
+	void rememberOrder(Chunk& chunk, const RecentOrder& order) const;
+
+	Command nextCommand(Chunk& chunk, long long index) const;
+	// Timestamps of a chunk start at 0, the offset of the chunk is added when it's written
+	void generateChunk(Chunk& chunk, long long chunkIndex, long long commandCount, std::vector<Command>& commands) const;
+
+public:
+	// threadCount 0 uses every available thread
+	OfflineGenerator(const Scenario& scenario, int threadCount = 0);
+	bool createInitialOrders(const std::string& filePath, CommandFormat format);
+	bool createOrders(const std::string& filePath, CommandFormat format);
+};
+
+#endif
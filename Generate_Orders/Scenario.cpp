@@ -0,0 +1,187 @@
+#include "Scenario.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    std::string trim(const std::string& text)
+    {
+        std::size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+        {
+            return "";
+        }
+        std::size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    bool parseMidModel(const std::string& value, MidModel& midModel)
+    {
+        if (value == "static") midModel = MidModel::Static;
+        else if (value == "trend") midModel = MidModel::Trend;
+        else if (value == "mean_reverting") midModel = MidModel::MeanReverting;
+        else return false;
+        return true;
+    }
+
+    template <typename T>
+    bool parseNumber(const std::string& value, T& number)
+    {
+        std::istringstream iss(value);
+        iss >> number;
+        return !iss.fail() && iss.eof();
+    }
+}
+
+std::array<double, commandTypeCount> Scenario::commandWeights(bool inFlashCrash) const
+{
+    std::array<double, commandTypeCount> result = weights;
+    auto weight = [&result](CommandType type) -> double& {
+        return result[static_cast<std::size_t>(type)];
+    };
+
+    // Cancel to trade ratio counts every command which can take liquidity as a trade
+    if (cancelToTradeRatio > 0)
+    {
+        weight(CommandType::CancelLimit) = cancelToTradeRatio * (weight(CommandType::Market)
+            + weight(CommandType::AddMarketLimit) + weight(CommandType::AddLimitIOC) + weight(CommandType::AddLimitFOK));
+    }
+    if (inFlashCrash)
+    {
+        weight(CommandType::Market) *= flashCrashIntensity;
+        weight(CommandType::AddLimitIOC) *= flashCrashIntensity;
+    }
+    return result;
+}
+
+bool Scenario::preset(const std::string& name, Scenario& scenario)
+{
+    scenario = Scenario();
+    scenario.name = name;
+    auto weight = [&scenario](CommandType type) -> double& {
+        return scenario.weights[static_cast<std::size_t>(type)];
+    };
+
+    if (name == "baseline")
+    {
+        return true;
+    }
+    if (name == "hft")
+    {
+        // Market makers requoting, most orders are cancelled close to the touch before they trade
+        scenario.cancelToTradeRatio = 30;
+        scenario.depthMeanTicks = 1.5;
+        scenario.cancelZipfExponent = 1.4;
+        scenario.cancelWindow = 2000;
+        scenario.burstStartProbability = 0.002;
+        weight(CommandType::ModifyLimit) = 0.3;
+        weight(CommandType::AddStop) = weight(CommandType::CancelStop) = weight(CommandType::ModifyStop) = 0;
+        weight(CommandType::AddStopLimit) = weight(CommandType::CancelStopLimit) = weight(CommandType::ModifyStopLimit) = 0;
+        return true;
+    }
+    if (name == "trending")
+    {
+        scenario.midModel = MidModel::Trend;
+        scenario.drift = 0.002;
+        scenario.volatility = 0.1;
+        return true;
+    }
+    if (name == "mean_reverting")
+    {
+        scenario.midModel = MidModel::MeanReverting;
+        scenario.volatility = 0.2;
+        scenario.meanReversion = 0.002;
+        return true;
+    }
+    if (name == "flash_crash")
+    {
+        // Deep stop book below the market which the crash sweeps through
+        scenario.midModel = MidModel::MeanReverting;
+        scenario.meanReversion = 0.0002;
+        scenario.flashCrashStart = 0.5;
+        weight(CommandType::AddStop) = 0.12;
+        weight(CommandType::AddStopLimit) = 0.08;
+        weight(CommandType::CancelStop) = weight(CommandType::CancelStopLimit) = 0.01;
+        return true;
+    }
+    return false;
+}
+
+bool Scenario::loadFromFile(const std::string& filePath, Scenario& scenario)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening scenario file: " << filePath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+        std::size_t equals = line.find('=');
+        if (equals == std::string::npos)
+        {
+            std::cerr << filePath << ":" << lineNumber << ": expected key = value" << std::endl;
+            return false;
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+
+        bool ok;
+        CommandType type;
+        if (key == "preset") ok = preset(value, scenario);
+        else if (key == "name") { scenario.name = value; ok = true; }
+        else if (key == "seed") ok = parseNumber(value, scenario.seed);
+        else if (key == "orderCount") ok = parseNumber(value, scenario.orderCount);
+        else if (key == "initialOrders") ok = parseNumber(value, scenario.initialOrders);
+        else if (key == "firstOrderId") ok = parseNumber(value, scenario.firstOrderId);
+        else if (key.rfind("weight.", 0) == 0 && commandTypeFromName(key.substr(7), type))
+            ok = parseNumber(value, scenario.weights[static_cast<std::size_t>(type)]);
+        else if (key == "cancelToTradeRatio") ok = parseNumber(value, scenario.cancelToTradeRatio);
+        else if (key == "minShares") ok = parseNumber(value, scenario.minShares);
+        else if (key == "maxShares") ok = parseNumber(value, scenario.maxShares);
+        else if (key == "depthMeanTicks") ok = parseNumber(value, scenario.depthMeanTicks);
+        else if (key == "maxCrossTicks") ok = parseNumber(value, scenario.maxCrossTicks);
+        else if (key == "stopLimitOffsetTicks") ok = parseNumber(value, scenario.stopLimitOffsetTicks);
+        else if (key == "icebergPeakFraction") ok = parseNumber(value, scenario.icebergPeakFraction);
+        else if (key == "ownerCount") ok = parseNumber(value, scenario.ownerCount);
+        else if (key == "midModel") ok = parseMidModel(value, scenario.midModel);
+        else if (key == "startPrice") ok = parseNumber(value, scenario.startPrice);
+        else if (key == "meanPrice") ok = parseNumber(value, scenario.meanPrice);
+        else if (key == "drift") ok = parseNumber(value, scenario.drift);
+        else if (key == "volatility") ok = parseNumber(value, scenario.volatility);
+        else if (key == "meanReversion") ok = parseNumber(value, scenario.meanReversion);
+        else if (key == "arrivalRate") ok = parseNumber(value, scenario.arrivalRate);
+        else if (key == "burstRate") ok = parseNumber(value, scenario.burstRate);
+        else if (key == "burstStartProbability") ok = parseNumber(value, scenario.burstStartProbability);
+        else if (key == "burstEndProbability") ok = parseNumber(value, scenario.burstEndProbability);
+        else if (key == "cancelZipfExponent") ok = parseNumber(value, scenario.cancelZipfExponent);
+        else if (key == "cancelWindow") ok = parseNumber(value, scenario.cancelWindow);
+        else if (key == "flashCrashStart") ok = parseNumber(value, scenario.flashCrashStart);
+        else if (key == "flashCrashLength") ok = parseNumber(value, scenario.flashCrashLength);
+        else if (key == "flashCrashDepth") ok = parseNumber(value, scenario.flashCrashDepth);
+        else if (key == "flashCrashIntensity") ok = parseNumber(value, scenario.flashCrashIntensity);
+        else if (key == "flashCrashSellBias") ok = parseNumber(value, scenario.flashCrashSellBias);
+        else
+        {
+            std::cerr << filePath << ":" << lineNumber << ": unknown key " << key << std::endl;
+            return false;
+        }
+
+        if (!ok)
+        {
+            std::cerr << filePath << ":" << lineNumber << ": invalid value for " << key << ": " << value << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
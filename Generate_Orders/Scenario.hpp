@@ -0,0 +1,81 @@
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "../Process_Orders/Command.hpp"
+
+// How the fair price the generated orders are placed around moves
+enum class MidModel {
+	Static,
+	Trend,          // Drift plus noise
+	MeanReverting   // Ornstein-Uhlenbeck pull towards meanPrice plus noise
+};
+
+// Workload description for ScenarioGenerator. Prices are in ticks of the book,
+// rates and probabilities are per generated command.
+struct Scenario {
+	std::string name = "baseline";
+	std::uint64_t seed = 1;
+	int orderCount = 1000000;
+	int initialOrders = 10000;
+	int firstOrderId = 1;
+
+	// Relative weight of each command type, indexed by CommandType
+	std::array<double, commandTypeCount> weights = {
+		0.02, 0.35, 0.02, 0.03, 0.01, 0.02, 0.25, 0.15, 0.03, 0.03, 0.02, 0.03, 0.02, 0.02
+	};
+	// When positive, the CancelLimit weight is set to this many cancels per trading command
+	double cancelToTradeRatio = 0;
+
+	// Order sizes and placement
+	int minShares = 1;
+	int maxShares = 1000;
+	double depthMeanTicks = 5;       // Mean distance of passive orders from the touch
+	int maxCrossTicks = 2;           // Marketable limits cross the touch by up to this many ticks
+	int stopLimitOffsetTicks = 5;    // Stop limit orders have their limit up to this far past the stop
+	double icebergPeakFraction = 0.1;
+	int ownerCount = 0;              // Orders carry owner ids 1..ownerCount, 0 for no owners
+
+	// Fair price process
+	MidModel midModel = MidModel::Static;
+	double startPrice = 5000;
+	double meanPrice = 5000;
+	double drift = 0;                // Ticks per command
+	double volatility = 0.05;        // Ticks per square root command
+	double meanReversion = 0.001;
+
+	// Arrivals follow a Poisson process which switches into and out of bursts
+	double arrivalRate = 100000;     // Commands per second outside of bursts
+	double burstRate = 2000000;      // Commands per second within a burst
+	double burstStartProbability = 0.0005;
+	double burstEndProbability = 0.01;
+
+	// Cancels and modifies pick among recent limit orders with a Zipf law over recency,
+	// the k-th most recent order is picked with probability proportional to k^-exponent
+	double cancelZipfExponent = 1.1;
+	int cancelWindow = 10000;
+
+	// Flash crash, between the given fractions of the stream the fair price falls by depth ticks
+	// and market and IOC orders are boosted and mostly sells. Disabled with a negative start.
+	double flashCrashStart = -1;
+	double flashCrashLength = 0.02;
+	double flashCrashDepth = 200;
+	double flashCrashIntensity = 5;
+	double flashCrashSellBias = 0.9;
+
+	// Weights with the cancel to trade ratio applied and, within the flash crash,
+	// market and IOC orders boosted
+	std::array<double, commandTypeCount> commandWeights(bool inFlashCrash) const;
+
+	// Named starting points: baseline, hft, trending, mean_reverting and flash_crash
+	static bool preset(const std::string& name, Scenario& scenario);
+
+	// Read a scenario from "key = value" lines, '#' starts a comment. A "preset" key
+	// resets the scenario to that preset, weights are set with keys like "weight.AddLimit".
+	static bool loadFromFile(const std::string& filePath, Scenario& scenario);
+};
+
+#endif
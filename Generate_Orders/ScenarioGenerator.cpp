@@ -0,0 +1,322 @@
+#include "ScenarioGenerator.hpp"
+#include "../Order_Book/Book.hpp"
+#include "../Order_Book/Limit.hpp"
+#include "../Order_Book/Order.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+ScenarioGenerator::ScenarioGenerator(Book* _book, const Scenario& _scenario)
+    : book(_book), pipeline(_book), scenario(_scenario), gen(static_cast<std::mt19937::result_type>(_scenario.seed)),
+    orderId(_scenario.firstOrderId), fairPrice(_scenario.startPrice)
+{
+    std::array<double, commandTypeCount> weights = scenario.commandWeights(false);
+    commandDist = std::discrete_distribution<int>(weights.begin(), weights.end());
+    weights = scenario.commandWeights(true);
+    flashCrashCommandDist = std::discrete_distribution<int>(weights.begin(), weights.end());
+
+    std::size_t window = static_cast<std::size_t>(std::max(scenario.cancelWindow, 1));
+    recentOrders.resize(window);
+    zipfCumulative.resize(window);
+    double total = 0;
+    for (std::size_t rank = 0; rank < window; rank++)
+    {
+        total += std::pow(static_cast<double>(rank + 1), -scenario.cancelZipfExponent);
+        zipfCumulative[rank] = total;
+    }
+}
+
+// Exponential gaps between commands, at the burst rate while a burst lasts
+void ScenarioGenerator::advanceClock()
+{
+    std::uniform_real_distribution<> switchDist(0.0, 1.0);
+    if (switchDist(gen) < (bursting ? scenario.burstEndProbability : scenario.burstStartProbability))
+    {
+        bursting = !bursting;
+    }
+    std::exponential_distribution<> gapDist(bursting ? scenario.burstRate : scenario.arrivalRate);
+    clock += static_cast<std::int64_t>(gapDist(gen) * 1e9);
+}
+
+void ScenarioGenerator::advanceFairPrice(bool inFlashCrash, int flashCrashCommands)
+{
+    std::normal_distribution<> noiseDist(0.0, scenario.volatility);
+    if (scenario.midModel == MidModel::Trend)
+    {
+        fairPrice += scenario.drift;
+    }
+    else if (scenario.midModel == MidModel::MeanReverting)
+    {
+        fairPrice += scenario.meanReversion * (scenario.meanPrice - fairPrice);
+    }
+    if (scenario.midModel != MidModel::Static)
+    {
+        fairPrice += noiseDist(gen);
+    }
+    if (inFlashCrash)
+    {
+        fairPrice -= scenario.flashCrashDepth / std::max(flashCrashCommands, 1);
+    }
+    fairPrice = clampPrice(fairPrice);
+}
+
+// Keep a tick away from the ends of the book so stop limit offsets stay inside it
+DefaultBookConfig::Price ScenarioGenerator::clampPrice(double price) const
+{
+    double lowest = static_cast<double>(DefaultBookConfig::fromTick(1));
+    double highest = static_cast<double>(DefaultBookConfig::fromTick(DefaultBookConfig::levelCount - 2));
+    return static_cast<DefaultBookConfig::Price>(std::llround(std::clamp(price, lowest, highest)));
+}
+
+// Passive orders rest behind the touch at a geometric distance, never crossing the book
+DefaultBookConfig::Price ScenarioGenerator::passivePrice(bool buyOrSell)
+{
+    std::geometric_distribution<> offsetDist(1.0 / (1.0 + scenario.depthMeanTicks));
+    int offset = offsetDist(gen);
+    if (buyOrSell)
+    {
+        double price = std::round(fairPrice) - 1 - offset;
+        if (book->getLowestSell() != nullptr)
+        {
+            price = std::min<double>(price, book->getLowestSell()->getLimitPrice() - 1);
+        }
+        return clampPrice(price);
+    }
+    double price = std::round(fairPrice) + 1 + offset;
+    if (book->getHighestBuy() != nullptr)
+    {
+        price = std::max<double>(price, book->getHighestBuy()->getLimitPrice() + 1);
+    }
+    return clampPrice(price);
+}
+
+// Marketable orders cross the opposite touch by a few ticks
+DefaultBookConfig::Price ScenarioGenerator::marketablePrice(bool buyOrSell)
+{
+    std::uniform_int_distribution<> crossDist(0, scenario.maxCrossTicks);
+    int cross = crossDist(gen);
+    if (buyOrSell)
+    {
+        double touch = book->getLowestSell() != nullptr ? book->getLowestSell()->getLimitPrice() : std::round(fairPrice);
+        return clampPrice(touch + cross);
+    }
+    double touch = book->getHighestBuy() != nullptr ? book->getHighestBuy()->getLimitPrice() : std::round(fairPrice);
+    return clampPrice(touch - cross);
+}
+
+// Stops sit beyond the opposite touch so they don't trigger on arrival
+DefaultBookConfig::Price ScenarioGenerator::stopPrice(bool buyOrSell)
+{
+    std::geometric_distribution<> offsetDist(1.0 / (1.0 + scenario.depthMeanTicks));
+    int offset = offsetDist(gen);
+    if (buyOrSell)
+    {
+        double touch = book->getLowestSell() != nullptr ? book->getLowestSell()->getLimitPrice() : std::round(fairPrice);
+        return clampPrice(touch + 1 + offset);
+    }
+    double touch = book->getHighestBuy() != nullptr ? book->getHighestBuy()->getLimitPrice() : std::round(fairPrice);
+    return clampPrice(touch - 1 - offset);
+}
+
+std::int64_t ScenarioGenerator::sampleShares()
+{
+    std::uniform_int_distribution<> sharesDist(scenario.minShares, scenario.maxShares);
+    return sharesDist(gen);
+}
+
+int ScenarioGenerator::sampleOwner()
+{
+    if (scenario.ownerCount <= 0)
+    {
+        return noOwner;
+    }
+    std::uniform_int_distribution<> ownerDist(1, scenario.ownerCount);
+    return ownerDist(gen);
+}
+
+// Pick a recent limit order, the k-th most recent with probability proportional to k^-exponent.
+// The order may have been filled since, which gives the cancels of filled orders real feeds see.
+bool ScenarioGenerator::pickRecentOrder(RecentOrder& order)
+{
+    if (recentCount == 0)
+    {
+        return false;
+    }
+    std::uniform_real_distribution<> weightDist(0.0, zipfCumulative[recentCount - 1]);
+    std::size_t rank = std::upper_bound(zipfCumulative.begin(), zipfCumulative.begin() + recentCount, weightDist(gen)) - zipfCumulative.begin();
+    rank = std::min(rank, recentCount - 1);
+    order = recentOrders[(recentNext + recentOrders.size() - 1 - rank) % recentOrders.size()];
+    return true;
+}
+
+void ScenarioGenerator::rememberOrder(int id, bool buyOrSell)
+{
+    recentOrders[recentNext] = { id, buyOrSell };
+    recentNext = (recentNext + 1) % recentOrders.size();
+    recentCount = std::min(recentCount + 1, recentOrders.size());
+}
+
+Command ScenarioGenerator::nextCommand(bool inFlashCrash)
+{
+    std::bernoulli_distribution sideDist(inFlashCrash ? 1.0 - scenario.flashCrashSellBias : 0.5);
+    std::bernoulli_distribution evenSideDist(0.5);
+
+    Command command = {};
+    command.type = static_cast<CommandType>(inFlashCrash ? flashCrashCommandDist(gen) : commandDist(gen));
+    command.buyOrSell = evenSideDist(gen);
+
+    RecentOrder recent;
+    Order* order;
+    switch (command.type)
+    {
+    case CommandType::Market:
+        command.buyOrSell = sideDist(gen);
+        command.shares = sampleShares();
+        break;
+    case CommandType::AddLimit:
+        command.shares = sampleShares();
+        command.price = passivePrice(command.buyOrSell);
+        break;
+    case CommandType::AddMarketLimit:
+    case CommandType::AddLimitIOC:
+    case CommandType::AddLimitFOK:
+        command.buyOrSell = sideDist(gen);
+        command.shares = sampleShares();
+        command.price = marketablePrice(command.buyOrSell);
+        break;
+    case CommandType::AddIceberg:
+        command.shares = sampleShares() * 5;
+        command.price = passivePrice(command.buyOrSell);
+        command.auxiliary = std::max<std::int64_t>(1, static_cast<std::int64_t>(command.shares * scenario.icebergPeakFraction));
+        break;
+    case CommandType::CancelLimit:
+    case CommandType::ModifyLimit:
+        if (!pickRecentOrder(recent))
+        {
+            command.type = CommandType::AddLimit;
+            command.shares = sampleShares();
+            command.price = passivePrice(command.buyOrSell);
+            break;
+        }
+        command.orderId = recent.orderId;
+        if (command.type == CommandType::ModifyLimit)
+        {
+            command.shares = sampleShares();
+            command.price = passivePrice(recent.buyOrSell);
+        }
+        return command;
+    case CommandType::AddStop:
+        command.shares = sampleShares();
+        command.price = stopPrice(command.buyOrSell);
+        break;
+    case CommandType::AddStopLimit:
+    {
+        std::uniform_int_distribution<> limitOffsetDist(1, std::max(scenario.stopLimitOffsetTicks, 1));
+        command.shares = sampleShares();
+        command.auxiliary = stopPrice(command.buyOrSell);
+        command.price = clampPrice(static_cast<double>(command.auxiliary) + (command.buyOrSell ? 1 : -1) * limitOffsetDist(gen));
+        break;
+    }
+    case CommandType::CancelStop:
+    case CommandType::ModifyStop:
+    case CommandType::CancelStopLimit:
+    case CommandType::ModifyStopLimit:
+    {
+        bool stopLimit = command.type == CommandType::CancelStopLimit || command.type == CommandType::ModifyStopLimit;
+        order = book->getRandomOrder(stopLimit ? 2 : 1, gen);
+        if (order == nullptr)
+        {
+            command.type = stopLimit ? CommandType::AddStopLimit : CommandType::AddStop;
+            command.shares = sampleShares();
+            command.price = stopPrice(command.buyOrSell);
+            if (stopLimit)
+            {
+                command.auxiliary = command.price;
+                command.price = clampPrice(static_cast<double>(command.auxiliary) + (command.buyOrSell ? 1 : -1));
+            }
+            break;
+        }
+        command.orderId = order->getOrderId(book->getPools());
+        if (command.type == CommandType::ModifyStop)
+        {
+            command.shares = sampleShares();
+            command.price = stopPrice(order->getBuyOrSell(book->getPools()));
+        }
+        else if (command.type == CommandType::ModifyStopLimit)
+        {
+            command.shares = sampleShares();
+            command.auxiliary = stopPrice(order->getBuyOrSell(book->getPools()));
+            command.price = clampPrice(static_cast<double>(command.auxiliary) + (order->getBuyOrSell(book->getPools()) ? 1 : -1));
+        }
+        return command;
+    }
+    }
+
+    // Every command which isn't a cancel or modify is a new order
+    command.orderId = orderId++;
+    command.ownerId = sampleOwner();
+    return command;
+}
+
+void ScenarioGenerator::emit(Command& command)
+{
+    command.timestamp = clock;
+    writer.write(command);
+    pipeline.processCommand(command);
+
+    if (command.type == CommandType::AddLimit || command.type == CommandType::AddMarketLimit || command.type == CommandType::AddIceberg)
+    {
+        rememberOrder(command.orderId, command.buyOrSell);
+    }
+}
+
+// Passive limit orders around the start price which build the book the stream runs against
+bool ScenarioGenerator::createInitialOrders(const std::string& filePath, CommandFormat format)
+{
+    if (!writer.open(filePath, format))
+    {
+        std::cerr << "Error opening file for writing: " << filePath << std::endl;
+        return false;
+    }
+
+    std::bernoulli_distribution sideDist(0.5);
+    for (int i = 0; i < scenario.initialOrders; i++)
+    {
+        Command command = {};
+        command.type = CommandType::AddLimit;
+        command.orderId = orderId++;
+        command.buyOrSell = sideDist(gen);
+        command.shares = sampleShares();
+        command.price = passivePrice(command.buyOrSell);
+        command.ownerId = sampleOwner();
+        emit(command);
+    }
+    writer.close();
+    return true;
+}
+
+bool ScenarioGenerator::createOrders(const std::string& filePath, CommandFormat format)
+{
+    if (!writer.open(filePath, format))
+    {
+        std::cerr << "Error opening file for writing: " << filePath << std::endl;
+        return false;
+    }
+
+    int flashCrashBegin = scenario.flashCrashStart < 0 ? scenario.orderCount
+        : static_cast<int>(scenario.flashCrashStart * scenario.orderCount);
+    int flashCrashCommands = static_cast<int>(scenario.flashCrashLength * scenario.orderCount);
+
+    for (int i = 0; i < scenario.orderCount; i++)
+    {
+        bool inFlashCrash = i >= flashCrashBegin && i < flashCrashBegin + flashCrashCommands;
+        advanceClock();
+        advanceFairPrice(inFlashCrash, flashCrashCommands);
+
+        Command command = nextCommand(inFlashCrash);
+        emit(command);
+    }
+    writer.close();
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SCENARIOGENERATOR_HPP
+#define SCENARIOGENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Order_Book/BookConfig.hpp"
+#include "../Process_Orders/Command.hpp"
+#include "../Process_Orders/OrderPipeline.hpp"
+#include "Scenario.hpp"
+
+// Generates an order stream described by a Scenario while applying it to a live book,
+// so generated prices follow the actual best bid and offer
+class ScenarioGenerator {
+private:
+	Book* book;
+	OrderPipeline pipeline;
+	Scenario scenario;
+	CommandWriter writer;
+	std::mt19937 gen;
+
+	int orderId;
+	double fairPrice;
+	std::int64_t clock = 0;
+	bool bursting = false;
+
+	// Ring buffer of the most recent limit orders with the cumulative Zipf weights of their recency ranks
+	struct RecentOrder {
+		int orderId;
+		bool buyOrSell;
+	};
+	std::vector<RecentOrder> recentOrders;
+	std::size_t recentCount = 0;
+	std::size_t recentNext = 0;
+	std::vector<double> zipfCumulative;
+
+	std::discrete_distribution<int> commandDist;
+	std::discrete_distribution<int> flashCrashCommandDist;
+
+	void advanceClock();
+	void advanceFairPrice(bool inFlashCrash, int flashCrashCommands);
+	DefaultBookConfig::Price clampPrice(double price) const;
+	DefaultBookConfig::Price passivePrice(bool buyOrSell);
+	DefaultBookConfig::Price marketablePrice(bool buyOrSell);
+	DefaultBookConfig::Price stopPrice(bool buyOrSell);
+	std::int64_t sampleShares();
+	int sampleOwner();
+	bool pickRecentOrder(RecentOrder& order);
+	void rememberOrder(int id, bool buyOrSell);
+	Command nextCommand(bool inFlashCrash);
+	void emit(Command& command);
+
+public:
+	ScenarioGenerator(Book* book, const Scenario& scenario);
+	bool createInitialOrders(const std::string& filePath, CommandFormat format);
+	bool createOrders(const std::string& filePath, CommandFormat format);
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef ALLOCATOR_HPP
+#define ALLOCATOR_HPP
+
+#include <new>
+#include <vector>
+#include "IndexPool.hpp"
+#include "MemoryPool.hpp"
+
+// Allocator policies store the orders and price levels of a book. Selected at compile time
+// through BookConfig. Every book owns its pools, and orders and levels link to each other by
+// PoolIndex, so a pool maps an index to the hot part of an object and to its cold part:
+//   PoolIndex allocate()           reserve a slot, the caller constructs the hot part in storage()
+//   void deallocate(PoolIndex)
+//   void* storage(PoolIndex)
+//   Hot* at(PoolIndex)             object at an index known not to be null
+//   Hot* get(PoolIndex)            nullptr for nullIndex
+//   Cold& cold(PoolIndex)
+
+// Hot and cold parts of an object kept together
+template <typename Hot, typename Cold>
+struct PoolEntry {
+	alignas(Hot) unsigned char hot[sizeof(Hot)];
+	Cold cold;
+};
+
+// Pool of entries found by index through a table, each entry is created and destroyed by Source
+template <typename Hot, typename Cold, template <typename> class Source>
+class EntryPool {
+public:
+	EntryPool() : entries(1, nullptr) {}
+	EntryPool(const EntryPool&) = delete;
+	EntryPool& operator=(const EntryPool&) = delete;
+
+	~EntryPool() {
+		for (Entry* entry : entries) {
+			if (entry != nullptr) {
+				source.destroy(entry);
+			}
+		}
+	}
+
+	PoolIndex allocate() {
+		PoolIndex index;
+		if (!freeIndices.empty()) {
+			index = freeIndices.back();
+			freeIndices.pop_back();
+		}
+		else {
+			index = static_cast<PoolIndex>(entries.size());
+			entries.push_back(nullptr);
+		}
+		entries[index] = source.create();
+		return index;
+	}
+
+	void deallocate(PoolIndex index) {
+		source.destroy(entries[index]);
+		entries[index] = nullptr;
+		freeIndices.push_back(index);
+	}
+
+	void* storage(PoolIndex index) {
+		return entries[index]->hot;
+	}
+
+	Hot* at(PoolIndex index) const {
+		return reinterpret_cast<Hot*>(entries[index]->hot);
+	}
+
+	Hot* get(PoolIndex index) const {
+		return index == nullIndex ? nullptr : at(index);
+	}
+
+	Cold& cold(PoolIndex index) const {
+		return entries[index]->cold;
+	}
+
+private:
+	using Entry = PoolEntry<Hot, Cold>;
+
+	std::vector<Entry*> entries;
+	std::vector<PoolIndex> freeIndices;
+	Source<Entry> source;
+};
+
+// Every object is a separate new and delete
+struct HeapAllocator {
+	template <typename Entry>
+	struct Source {
+		Entry* create() {
+			return new Entry;
+		}
+
+		void destroy(Entry* entry) {
+			delete entry;
+		}
+	};
+
+	template <typename Hot, typename Cold>
+	using Pool = EntryPool<Hot, Cold, Source>;
+};
+
+// Objects are carved out of MemoryPool blocks and recycled through its free list
+struct PoolAllocator {
+	template <typename Entry>
+	struct Source {
+		Entry* create() {
+			return new (pool.allocate()) Entry;
+		}
+
+		void destroy(Entry* entry) {
+			pool.deallocate(entry);
+		}
+
+		MemoryPool<Entry> pool;
+	};
+
+	template <typename Hot, typename Cold>
+	using Pool = EntryPool<Hot, Cold, Source>;
+};
+
+// Hot parts packed together in chunks with the cold parts in a parallel array, see IndexPool
+struct IndexPoolAllocator {
+	template <typename Hot, typename Cold>
+	using Pool = IndexPool<Hot, Cold>;
+};
+
+// Orders and price levels of one book
+template <typename Order, typename Limit, typename Allocator>
+struct BookPools {
+	typename Allocator::template Pool<Order, typename Order::Cold> orders;
+	typename Allocator::template Pool<Limit, typename Limit::Cold> limits;
+};
+
+#endif
@@ -4,448 +4,543 @@
 #include <iostream>
 #include <algorithm>
 #include <random>
-#include <iterator>
-
-Book::Book() {
-    buyTree = nullptr;
-    sellTree = nullptr;
-    lowestSell = nullptr;
-    highestBuy = nullptr;
-    stopBuyTree = nullptr;
-    stopSellTree = nullptr;
-    highestStopSell = nullptr;
-    lowestStopBuy = nullptr;
-}
+#include <initializer_list>
+#include <limits>
 
-Book::~Book() {
-    for (auto& [id, order] : orderMap) {
-        delete order;
-    }
-    orderMap.clear();
+template <typename Config>
+BasicBook<Config>::BasicBook()
+    : buyLimits(pools, true, AVLTreeBalanceCount), sellLimits(pools, false, AVLTreeBalanceCount),
+    stopBuys(pools, false, AVLTreeBalanceCount), stopSells(pools, true, AVLTreeBalanceCount) {
+}
 
-    for (auto& [limitPrice, limit] : limitBuyMap) {
-        delete limit;
-    }
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getBuyTree() const {
+    return buyLimits.root();
+}
 
-    limitBuyMap.clear();
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getSellTree() const {
+    return sellLimits.root();
+}
 
-    for (auto& [limitPrice, limit] : limitSellMap) {
-        delete limit;
-    }
-    limitSellMap.clear();
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getLowestSell() const {
+    return sellLimits.best();
+}
 
-    for (auto& [stopPrice, stop] : stopMap) {
-        delete stop;
-    }
-    stopMap.clear();
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getHighestBuy() const {
+    return buyLimits.best();
 }
 
-Limit* Book::getBuyTree() const {
-    return buyTree;
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getStopBuyTree() const {
+    return stopBuys.root();
 }
 
-Limit* Book::getSellTree() const {
-    return sellTree;
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getStopSellTree() const {
+    return stopSells.root();
 }
 
-Limit* Book::getLowestSell() const {
-    return lowestSell;
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getHighestStopSell() const {
+    return stopSells.best();
 }
 
-Limit* Book::getHighestBuy() const {
-    return highestBuy;
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::getLowestStopBuy() const {
+    return stopBuys.best();
 }
 
-Limit* Book::getStopBuyTree() const {
-    return stopBuyTree;
+template <typename Config>
+SelfTradePrevention BasicBook<Config>::getSelfTradePrevention() const {
+    return selfTradePrevention;
 }
 
-Limit* Book::getStopSellTree() const {
-    return stopSellTree;
+template <typename Config>
+void BasicBook<Config>::setSelfTradePrevention(SelfTradePrevention mode) {
+    selfTradePrevention = mode;
 }
 
-Limit* Book::getHighestStopSell() const {
-    return highestStopSell;
+template <typename Config>
+typename BasicBook<Config>::EventSink& BasicBook<Config>::getEventSink() {
+    return eventSink;
 }
 
-Limit* Book::getLowestStopBuy() const {
-    return lowestStopBuy;
+template <typename Config>
+const typename BasicBook<Config>::Pools& BasicBook<Config>::getPools() const {
+    return pools;
 }
 
 //exec market order
-void Book::marketOrder(int orderId, bool buyOrSell, int shares) {
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::marketOrder(int orderId, bool buyOrSell, Quantity shares, int ownerId) {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    marketOrderHelper(orderId, buyOrSell, shares);
+    Quantity remainingShares = marketOrderHelper(orderId, buyOrSell, shares, marketLimit(buyOrSell), ownerId);
+    Quantity filledShares = matchedShares;
+    Quantity cancelledShares = selfTradeCancelledShares;
 
     executeStopOrders(buyOrSell);
+    return { matchStatus(cancelledShares), filledShares, remainingShares, false, cancelledShares };
 }
 
-void Book::addLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice) {
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::addLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, TimeInForce timeInForce, int ownerId) {
     AVLTreeBalanceCount = 0;
+    if (!Config::isValidPrice(limitPrice)) {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    // The id of a resting order is rejected before the order can trade
+    if (orderStore.find(orderId) != nullptr) {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    // Fill or kill order leaves the book untouched if it can't be filled completely
+    if (timeInForce == TimeInForce::FillOrKill && !canFillWithinLimit(buyOrSell, shares, limitPrice, ownerId)) {
+        return { OrderStatus::Killed, 0, shares, false };
+    }
+
     // Order being executed immediately
-    shares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice);
+    Quantity remainingShares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
+    Quantity filledShares = matchedShares;
+    Quantity cancelledShares = selfTradeCancelledShares;
 
-    if (shares != 0) {
-        Order* newOrder = new Order(orderId, buyOrSell, shares, limitPrice);
-        orderMap.emplace(orderId, newOrder);
+    // Only good till cancel orders rest their remainder in the book
+    if (remainingShares != 0 && timeInForce == TimeInForce::GoodTillCancel) {
+        Order* newOrder = Order::create(pools, orderId, buyOrSell, remainingShares, limitPrice);
+        newOrder->setOwnerId(pools, ownerId);
+        orderStore.insert(orderId, newOrder);
 
-        auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+        Limit* limit = (buyOrSell ? buyLimits : sellLimits).find(limitPrice);
 
-        if (limitMap.find(limitPrice) == limitMap.end()) {
-            addLimit(limitPrice, newOrder->getBuyOrSell());
+        if (limit == nullptr) {
+            limit = addLimit(limitPrice, buyOrSell);
         }
 
-        limitMap.at(limitPrice)->addOrder(newOrder);
+        limit->addOrder(pools, newOrder);
+        liveOrders.insert(pools, newOrder, LiveOrders<Order>::limitKind);
+        return { matchStatus(cancelledShares), filledShares, remainingShares, true, cancelledShares };
     }
     else {
         executeStopOrders(buyOrSell);
+        return { matchStatus(cancelledShares), filledShares, remainingShares, false, cancelledShares };
+    }
+}
+
+// Add an iceberg order which only shows peakShares in the book and keeps the rest in reserve
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::addIcebergOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Quantity peakShares, int ownerId) {
+    if (!Config::isValidPrice(limitPrice)) {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orderStore.find(orderId) != nullptr) {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    if (peakShares <= 0) {
+        return addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::GoodTillCancel, ownerId);
+    }
+
+    AVLTreeBalanceCount = 0;
+    // Order being executed immediately with its full size
+    Quantity remainingShares = limitOrderAsMarketOrder(orderId, buyOrSell, shares, limitPrice, ownerId);
+    Quantity filledShares = matchedShares;
+    Quantity cancelledShares = selfTradeCancelledShares;
+
+    if (remainingShares != 0) {
+        Quantity displayedShares = std::min(remainingShares, peakShares);
+        Order* newOrder = Order::create(pools, orderId, buyOrSell, displayedShares, limitPrice);
+        newOrder->setIceberg(pools, peakShares, remainingShares - displayedShares);
+        newOrder->setOwnerId(pools, ownerId);
+        orderStore.insert(orderId, newOrder);
+
+        Limit* limit = (buyOrSell ? buyLimits : sellLimits).find(limitPrice);
+
+        if (limit == nullptr) {
+            limit = addLimit(limitPrice, buyOrSell);
+        }
+
+        limit->addOrder(pools, newOrder);
+        liveOrders.insert(pools, newOrder, LiveOrders<Order>::limitKind);
+        return { matchStatus(cancelledShares), filledShares, remainingShares, true, cancelledShares };
+    }
+    else {
+        executeStopOrders(buyOrSell);
+        return { matchStatus(cancelledShares), filledShares, 0, false, cancelledShares };
     }
 }
 
 // Delete a limit order from the book
-void Book::cancelLimitOrder(int orderId)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::cancelLimitOrder(int orderId)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    Order* order = searchOrderMap(orderId);
+    Order* order = searchOrderMap(orderId, LiveOrders<Order>::limitKind);
 
-    if (order != nullptr)
+    if (order == nullptr)
     {
-        order->cancel();
-        if (order->getParentLimit()->getSize() == 0)
-        {
-            deleteLimit(order->getParentLimit());
-        }
-        deleteFromOrderMap(orderId);
-        // limitOrders.erase(order);
-        delete order;
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+
+    order->cancel(pools);
+    if (order->getParentLimit(pools)->getSize() == 0)
+    {
+        deleteLimit(order->getParentLimit(pools));
     }
+    deleteFromOrderMap(order);
+    eventSink.onCancel(orderId);
+    Order::destroy(pools, order);
+    return { OrderStatus::Ok, 0, 0, false };
 }
 
 // Modify an existing limit order
-void Book::modifyLimitOrder(int orderId, int newShares, int newLimit)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::modifyLimitOrder(int orderId, Quantity newShares, Price newLimit)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    Order* order = searchOrderMap(orderId);
-    if (order != nullptr)
+    Order* order = searchOrderMap(orderId, LiveOrders<Order>::limitKind);
+    if (order == nullptr)
     {
-        order->cancel();
-        if (order->getParentLimit()->getSize() == 0)
-        {
-            deleteLimit(order->getParentLimit());
-        }
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    if (!Config::isValidPrice(newLimit))
+    {
+        return { OrderStatus::InvalidPrice, 0, order->getShares() + order->getHiddenShares(pools), true };
+    }
 
-        order->modifyOrder(newShares, newLimit);
-        auto& limitMap = order->getBuyOrSell() ? limitBuyMap : limitSellMap;
+    order->cancel(pools);
+    if (order->getParentLimit(pools)->getSize() == 0)
+    {
+        deleteLimit(order->getParentLimit(pools));
+    }
 
-        if (limitMap.find(newLimit) == limitMap.end())
-        {
-            addLimit(newLimit, order->getBuyOrSell());
-        }
-        limitMap.at(newLimit)->addOrder(order);
+    order->modifyOrder(pools, newShares, newLimit);
+    Limit* limit = (order->getBuyOrSell(pools) ? buyLimits : sellLimits).find(newLimit);
+
+    if (limit == nullptr)
+    {
+        limit = addLimit(newLimit, order->getBuyOrSell(pools));
     }
+    limit->addOrder(pools, order);
+    return { OrderStatus::Ok, 0, newShares, true };
 }
 
 // Add a stop order
-void Book::addStopOrder(int orderId, bool buyOrSell, int shares, int stopPrice)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::addStopOrder(int orderId, bool buyOrSell, Quantity shares, Price stopPrice, int ownerId)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
+    if (!Config::isValidPrice(stopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orderStore.find(orderId) != nullptr)
+    {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
     // Account for stop order being executed immediately
-    shares = stopOrderAsMarketOrder(orderId, buyOrSell, shares, stopPrice);
-
-    if (shares != 0)
+    if (stopTriggered(buyOrSell, stopPrice))
     {
-        Order* newOrder = new Order(orderId, buyOrSell, shares, 0);
-        orderMap.emplace(orderId, newOrder);
+        return marketOrder(orderId, buyOrSell, shares, ownerId);
+    }
 
-        if (stopMap.find(stopPrice) == stopMap.end())
-        {
-            addStop(stopPrice, newOrder->getBuyOrSell());
-        }
-        stopMap.at(stopPrice)->addOrder(newOrder);
-        // stopOrders.insert(newOrder);
+    Order* newOrder = Order::create(pools, orderId, buyOrSell, shares, 0);
+    newOrder->setOwnerId(pools, ownerId);
+    orderStore.insert(orderId, newOrder);
+
+    Limit* stopLevel = (buyOrSell ? stopBuys : stopSells).find(stopPrice);
+    if (stopLevel == nullptr)
+    {
+        stopLevel = addStop(stopPrice, buyOrSell);
     }
+    stopLevel->addOrder(pools, newOrder);
+    liveOrders.insert(pools, newOrder, LiveOrders<Order>::stopKind);
+    return { OrderStatus::Ok, 0, shares, true };
 }
 
-void Book::cancelStopOrder(int orderId)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::cancelStopOrder(int orderId)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    Order* order = searchOrderMap(orderId);
+    Order* order = searchOrderMap(orderId, LiveOrders<Order>::stopKind);
 
-    if (order != nullptr)
+    if (order == nullptr)
     {
-        order->cancel();
-        if (order->getParentLimit()->getSize() == 0)
-        {
-            deleteStop(order->getParentLimit());
-        }
-        deleteFromOrderMap(orderId);
-        delete order;
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+
+    order->cancel(pools);
+    if (order->getParentLimit(pools)->getSize() == 0)
+    {
+        deleteStop(order->getParentLimit(pools));
     }
+    deleteFromOrderMap(order);
+    eventSink.onCancel(orderId);
+    Order::destroy(pools, order);
+    return { OrderStatus::Ok, 0, 0, false };
 }
 
-void Book::modifyStopOrder(int orderId, int newShares, int newStopPrice)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::modifyStopOrder(int orderId, Quantity newShares, Price newStopPrice)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    Order* order = searchOrderMap(orderId);
-    if (order != nullptr)
+    Order* order = searchOrderMap(orderId, LiveOrders<Order>::stopKind);
+    if (order == nullptr)
     {
-        order->cancel();
-        if (order->getParentLimit()->getSize() == 0)
-        {
-            deleteStop(order->getParentLimit());
-        }
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    if (!Config::isValidPrice(newStopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, order->getShares(), true };
+    }
 
-        order->modifyOrder(newShares, 0);
+    order->cancel(pools);
+    if (order->getParentLimit(pools)->getSize() == 0)
+    {
+        deleteStop(order->getParentLimit(pools));
+    }
 
-        if (stopMap.find(newStopPrice) == stopMap.end())
-        {
-            addStop(newStopPrice, order->getBuyOrSell());
-        }
-        stopMap.at(newStopPrice)->addOrder(order);
+    order->modifyOrder(pools, newShares, 0);
+
+    Limit* stopLevel = (order->getBuyOrSell(pools) ? stopBuys : stopSells).find(newStopPrice);
+    if (stopLevel == nullptr)
+    {
+        stopLevel = addStop(newStopPrice, order->getBuyOrSell(pools));
     }
+    stopLevel->addOrder(pools, order);
+    return { OrderStatus::Ok, 0, newShares, true };
 }
 
-void Book::addStopLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::addStopLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Price stopPrice, int ownerId)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    // stop limit order being executed immediately
-    shares = stopLimitOrderAsLimitOrder(orderId, buyOrSell, shares, limitPrice, stopPrice);
-
-    if (shares != 0)
+    if (!Config::isValidPrice(limitPrice) || !Config::isValidPrice(stopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, shares, false };
+    }
+    if (orderStore.find(orderId) != nullptr)
+    {
+        return { OrderStatus::DuplicateId, 0, shares, false };
+    }
+    // stop limit order being executed immediately as a limit order
+    if (stopTriggered(buyOrSell, stopPrice))
     {
-        Order* newOrder = new Order(orderId, buyOrSell, shares, limitPrice);
-        orderMap.emplace(orderId, newOrder);
+        return addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::GoodTillCancel, ownerId);
+    }
 
-        if (stopMap.find(stopPrice) == stopMap.end())
-        {
-            addStop(stopPrice, newOrder->getBuyOrSell());
-        }
-        stopMap.at(stopPrice)->addOrder(newOrder);
+    Order* newOrder = Order::create(pools, orderId, buyOrSell, shares, limitPrice);
+    newOrder->setOwnerId(pools, ownerId);
+    orderStore.insert(orderId, newOrder);
+
+    Limit* stopLevel = (buyOrSell ? stopBuys : stopSells).find(stopPrice);
+    if (stopLevel == nullptr)
+    {
+        stopLevel = addStop(stopPrice, buyOrSell);
     }
+    stopLevel->addOrder(pools, newOrder);
+    liveOrders.insert(pools, newOrder, LiveOrders<Order>::stopLimitKind);
+    return { OrderStatus::Ok, 0, shares, true };
 }
 
-void Book::cancelStopLimitOrder(int orderId)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::cancelStopLimitOrder(int orderId)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    Order* order = searchOrderMap(orderId);
+    Order* order = searchOrderMap(orderId, LiveOrders<Order>::stopLimitKind);
 
-    if (order != nullptr)
+    if (order == nullptr)
     {
-        order->cancel();
-        if (order->getParentLimit()->getSize() == 0)
-        {
-            deleteStop(order->getParentLimit());
-        }
-        deleteFromOrderMap(orderId);
-        delete order;
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+
+    order->cancel(pools);
+    if (order->getParentLimit(pools)->getSize() == 0)
+    {
+        deleteStop(order->getParentLimit(pools));
     }
+    deleteFromOrderMap(order);
+    eventSink.onCancel(orderId);
+    Order::destroy(pools, order);
+    return { OrderStatus::Ok, 0, 0, false };
 }
 
-void Book::modifyStopLimitOrder(int orderId, int newShares, int newLimitPrice, int newStopPrice)
+template <typename Config>
+typename BasicBook<Config>::OrderResult BasicBook<Config>::modifyStopLimitOrder(int orderId, Quantity newShares, Price newLimitPrice, Price newStopPrice)
 {
     executedOrdersCount = 0;
     AVLTreeBalanceCount = 0;
-    Order* order = searchOrderMap(orderId);
-    if (order != nullptr)
+    Order* order = searchOrderMap(orderId, LiveOrders<Order>::stopLimitKind);
+    if (order == nullptr)
     {
-        order->cancel();
-        if (order->getParentLimit()->getSize() == 0)
-        {
-            deleteStop(order->getParentLimit());
-        }
+        return { OrderStatus::NotFound, 0, 0, false };
+    }
+    if (!Config::isValidPrice(newLimitPrice) || !Config::isValidPrice(newStopPrice))
+    {
+        return { OrderStatus::InvalidPrice, 0, order->getShares(), true };
+    }
 
-        order->modifyOrder(newShares, newLimitPrice);
+    order->cancel(pools);
+    if (order->getParentLimit(pools)->getSize() == 0)
+    {
+        deleteStop(order->getParentLimit(pools));
+    }
 
-        if (stopMap.find(newStopPrice) == stopMap.end())
-        {
-            addStop(newStopPrice, order->getBuyOrSell());
-        }
-        stopMap.at(newStopPrice)->addOrder(order);
+    order->modifyOrder(pools, newShares, newLimitPrice);
+
+    Limit* stopLevel = (order->getBuyOrSell(pools) ? stopBuys : stopSells).find(newStopPrice);
+    if (stopLevel == nullptr)
+    {
+        stopLevel = addStop(newStopPrice, order->getBuyOrSell(pools));
     }
+    stopLevel->addOrder(pools, order);
+    return { OrderStatus::Ok, 0, newShares, true };
 }
 
-int Book::getLimitHeight(Limit* limit) const {
+template <typename Config>
+int BasicBook<Config>::getLimitHeight(Limit* limit) const {
     if (limit == nullptr) {
         return 0;
     }
     else {
-        int l_height = getLimitHeight(limit->getLeftChild());
-        int r_height = getLimitHeight(limit->getRightChild());
+        int l_height = getLimitHeight(limit->getLeftChild(pools));
+        int r_height = getLimitHeight(limit->getRightChild(pools));
         int max = std::max(l_height, r_height) + 1;
         return max;
     }
 }
 
 // Find an order
-Order* Book::searchOrderMap(int orderId) const
+template <typename Config>
+typename BasicBook<Config>::Order* BasicBook<Config>::searchOrderMap(int orderId) const
 {
-    auto it = orderMap.find(orderId);
-    if (it != orderMap.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        std::cout << "No order number " << orderId << std::endl;
-        return nullptr;
-    }
+    return orderStore.find(orderId);
 }
 
-// Find a limit
-Limit* Book::searchLimitMaps(int limitPrice, bool buyOrSell) const
+// Find an order of the given kind, a stop limit order which has become a limit order
+// can no longer be cancelled or modified as a stop limit order
+template <typename Config>
+typename BasicBook<Config>::Order* BasicBook<Config>::searchOrderMap(int orderId, int kind) const
 {
-    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+    Order* order = orderStore.find(orderId);
+    return order != nullptr && LiveOrders<Order>::kindOf(pools, order) == kind ? order : nullptr;
+}
 
-    auto it = limitMap.find(limitPrice);
-    if (it != limitMap.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        std::cout << "No " << (buyOrSell ? "buy " : "sell ") << "limit at " << limitPrice << std::endl;
-        return nullptr;
-    }
+// Find a limit
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::searchLimitMaps(Price limitPrice, bool buyOrSell) const
+{
+    return Config::isValidPrice(limitPrice) ? (buyOrSell ? buyLimits : sellLimits).find(limitPrice) : nullptr;
 }
 
 // Find a stop level
-Limit* Book::searchStopMap(int stopPrice) const
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::searchStopMap(Price stopPrice, bool buyOrSell) const
 {
-    auto it = stopMap.find(stopPrice);
-    if (it != stopMap.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        std::cout << "No stop level at " << stopPrice << std::endl;
-        return nullptr;
-    }
+    return Config::isValidPrice(stopPrice) ? (buyOrSell ? stopBuys : stopSells).find(stopPrice) : nullptr;
 }
 
-void Book::printLimit(int limitPrice, bool buyOrSell) const
+template <typename Config>
+void BasicBook<Config>::printLimit(Price limitPrice, bool buyOrSell) const
 {
-    searchLimitMaps(limitPrice, buyOrSell)->print();
+    Limit* limit = searchLimitMaps(limitPrice, buyOrSell);
+    if (limit == nullptr)
+    {
+        std::cout << "No " << (buyOrSell ? "buy " : "sell ") << "limit at " << limitPrice << std::endl;
+        return;
+    }
+    limit->print();
 }
 
-void Book::printOrder(int orderId) const
+template <typename Config>
+void BasicBook<Config>::printOrder(int orderId) const
 {
-    searchOrderMap(orderId)->print();
+    Order* order = searchOrderMap(orderId);
+    if (order == nullptr)
+    {
+        std::cout << "No order number " << orderId << std::endl;
+        return;
+    }
+    order->print(pools);
 }
 
-void Book::printBookEdges() const
+template <typename Config>
+void BasicBook<Config>::printBookEdges() const
 {
-    std::cout << "Buy edge: " << highestBuy->getLimitPrice()
-        << "Sell edge: " << lowestSell->getLimitPrice() << std::endl;
+    std::cout << "Buy edge: " << getHighestBuy()->getLimitPrice()
+        << "Sell edge: " << getLowestSell()->getLimitPrice() << std::endl;
 }
 
-void Book::printOrderBook() const
+template <typename Config>
+void BasicBook<Config>::printOrderBook() const
 {
-    std::vector<int> vec = inOrderTreeTraversal(getStopBuyTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchStopMap(vec[i])->getTotalVolume();
-        if (i != 0 && i != vec.size() - 1 && vec[i] < vec[i - 1]) {
-            throw std::runtime_error("Error: vector is error");
-        }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
-        }
-    }
-    std::cout << "]" << std::endl;
-
-    vec = inOrderTreeTraversal(getStopSellTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchStopMap(vec[i])->getTotalVolume();
-        if (i != 0 && i != vec.size() - 1 && vec[i] < vec[i - 1]) {
-            throw std::runtime_error("Error: Vector is error");
-        }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
-        }
-    }
-    std::cout << "]" << std::endl;
-
-    vec = inOrderTreeTraversal(getBuyTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchLimitMaps(vec[i], true)->getTotalVolume();
-        if (i != 0 && i != vec.size() - 1 && vec[i] < vec[i - 1]) {
-            throw std::runtime_error("Error: vector is error");
-        }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
-        }
-    }
-    std::cout << "]" << std::endl;
-
-    vec = inOrderTreeTraversal(getSellTree());
-    std::cout << "[";
-    for (size_t i = 0; i < vec.size(); ++i) {
-        std::cout << vec[i] << "-" << searchLimitMaps(vec[i], false)->getTotalVolume();
-        if (i != 0 && i != vec.size() - 1 && vec[i] < vec[i - 1]) {
-            throw std::runtime_error("Error: Vector is error");
-        }
-        if (i != vec.size() - 1) {
-            std::cout << ", ";
-        }
+    // Stop buys, stop sells, buys and sells in ascending price order with their volume
+    for (const PriceIndex* side : { &stopBuys, &stopSells, &buyLimits, &sellLimits })
+    {
+        bool first = true;
+        std::cout << "[";
+        side->forEach([&first](Limit* limit) {
+            std::cout << (first ? "" : ", ") << limit->getLimitPrice() << "-" << limit->getTotalVolume();
+            first = false;
+        });
+        std::cout << "]" << std::endl;
     }
-    std::cout << "]" << std::endl;
 }
 
-std::vector<int> Book::inOrderTreeTraversal(Limit* root) const
+template <typename Config>
+std::vector<typename BasicBook<Config>::Price> BasicBook<Config>::inOrderTreeTraversal(Limit* root) const
 {
-    std::vector<int> result;
+    std::vector<Price> result;
     if (root == nullptr)
         return result;
 
-    std::vector<int> leftSubtree = inOrderTreeTraversal(root->getLeftChild());
+    std::vector<Price> leftSubtree = inOrderTreeTraversal(root->getLeftChild(pools));
     result.insert(result.end(), leftSubtree.begin(), leftSubtree.end());
 
     result.push_back(root->getLimitPrice());
 
-    std::vector<int> rightSubtree = inOrderTreeTraversal(root->getRightChild());
+    std::vector<Price> rightSubtree = inOrderTreeTraversal(root->getRightChild(pools));
     result.insert(result.end(), rightSubtree.begin(), rightSubtree.end());
 
     return result;
 }
 
-std::vector<int> Book::preOrderTreeTraversal(Limit* root) const
+template <typename Config>
+std::vector<typename BasicBook<Config>::Price> BasicBook<Config>::preOrderTreeTraversal(Limit* root) const
 {
-    std::vector<int> result;
+    std::vector<Price> result;
     if (root == nullptr)
         return result;
 
     result.push_back(root->getLimitPrice());
 
-    std::vector<int> leftSubtree = preOrderTreeTraversal(root->getLeftChild());
+    std::vector<Price> leftSubtree = preOrderTreeTraversal(root->getLeftChild(pools));
     result.insert(result.end(), leftSubtree.begin(), leftSubtree.end());
 
-    std::vector<int> rightSubtree = preOrderTreeTraversal(root->getRightChild());
+    std::vector<Price> rightSubtree = preOrderTreeTraversal(root->getRightChild(pools));
     result.insert(result.end(), rightSubtree.begin(), rightSubtree.end());
 
     return result;
 }
 
-std::vector<int> Book::postOrderTreeTraversal(Limit* root) const
+template <typename Config>
+std::vector<typename BasicBook<Config>::Price> BasicBook<Config>::postOrderTreeTraversal(Limit* root) const
 {
-    std::vector<int> result;
+    std::vector<Price> result;
     if (root == nullptr)
         return result;
 
-    std::vector<int> leftSubtree = postOrderTreeTraversal(root->getLeftChild());
+    std::vector<Price> leftSubtree = postOrderTreeTraversal(root->getLeftChild(pools));
     result.insert(result.end(), leftSubtree.begin(), leftSubtree.end());
 
-    std::vector<int> rightSubtree = postOrderTreeTraversal(root->getRightChild());
+    std::vector<Price> rightSubtree = postOrderTreeTraversal(root->getRightChild(pools));
     result.insert(result.end(), rightSubtree.begin(), rightSubtree.end());
 
     result.push_back(root->getLimitPrice());
@@ -453,501 +548,119 @@ std::vector<int> Book::postOrderTreeTraversal(Limit* root) const
     return result;
 }
 
-// Return a random active order for testing purposes
+// Return a random active order for testing purposes, in constant time
 // 0:Limit, 1:Stop, 2:StopLimit
-Order* Book::getRandomOrder(int key, std::mt19937 gen) const
+template <typename Config>
+typename BasicBook<Config>::Order* BasicBook<Config>::getRandomOrder(int key, std::mt19937& gen) const
 {
-    if (key == 0)
+    if (key < 0 || key > 2)
     {
-        if (limitOrders.size() > 10000)
-        {
-            // Generate a random index within the range of the hash set size
-            std::uniform_int_distribution<> mapDist(0, limitOrders.size() - 1);
-            int randomIndex = mapDist(gen);
-
-            // Access the element at the random index directly
-            auto it = limitOrders.begin();
-            std::advance(it, randomIndex);
-            return *it;
-        }
         return nullptr;
     }
-    else if (key == 1)
+    // Keep the book deep enough that generated cancels and modifies don't drain it
+    std::size_t minimumOrders = key == 0 ? 10000 : 500;
+    if (liveOrders.size(key) <= minimumOrders)
     {
-        if (stopOrders.size() > 500)
-        {
-            // Generate a random index within the range of the hash set size
-            std::uniform_int_distribution<> mapDist(0, stopOrders.size() - 1);
-            int randomIndex = mapDist(gen);
-
-            // Access the element at the random index directly
-            auto it = stopOrders.begin();
-            std::advance(it, randomIndex);
-            return *it;
-        }
         return nullptr;
     }
-    else if (key == 2)
-    {
-        if (stopLimitOrders.size() > 500)
-        {
-            // Generate a random index within the range of the hash set size
-            std::uniform_int_distribution<> mapDist(0, stopLimitOrders.size() - 1);
-            int randomIndex = mapDist(gen);
-
-            // Access the element at the random index directly
-            auto it = stopLimitOrders.begin();
-            std::advance(it, randomIndex);
-            return *it;
-        }
-        return nullptr;
-    }
-    return nullptr;
-}
-
-void Book::addLimit(int limitPrice, bool buyOrSell)
-{
-    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
-    auto& tree = buyOrSell ? buyTree : sellTree;
-    auto& bookEdge = buyOrSell ? highestBuy : lowestSell;
-
-    Limit* newLimit = new Limit(limitPrice, buyOrSell);
-    limitMap.emplace(limitPrice, newLimit);
-
-    if (tree == nullptr)
-    {
-        tree = newLimit;
-        bookEdge = newLimit;
-    }
-    else
-    {
-        Limit* root = insert(tree, newLimit);
-        updateBookEdgeInsert(newLimit);
-    }
-}
-
-void Book::addStop(int stopPrice, bool buyOrSell)
-{
-    auto& tree = buyOrSell ? stopBuyTree : stopSellTree;
-    auto& bookEdge = buyOrSell ? lowestStopBuy : highestStopSell;
-
-    Limit* newStop = new Limit(stopPrice, buyOrSell);
-    stopMap.emplace(stopPrice, newStop);
-
-    if (tree == nullptr)
-    {
-        tree = newStop;
-        bookEdge = newStop;
-    }
-    else
-    {
-        Limit* root = insertStop(tree, newStop);
-        updateStopBookEdgeInsert(newStop);
-    }
-}
-
-// Insert a limit into its binary search tree
-Limit* Book::insert(Limit* root, Limit* limit, Limit* parent)
-{
-    if (root == nullptr)
-    {
-        limit->setParent(parent);
-        return limit;
-    }
-    if (limit->getLimitPrice() < root->getLimitPrice())
-    {
-        root->setLeftChild(insert(root->getLeftChild(), limit, root));
-        root = balance(root);
-    }
-    else if (limit->getLimitPrice() > root->getLimitPrice())
-    {
-        root->setRightChild(insert(root->getRightChild(), limit, root));
-        root = balance(root);
-    }
-
-    return root;
-}
-
-// Insert a limit into its stop binary search tree
-Limit* Book::insertStop(Limit* root, Limit* limit, Limit* parent)
-{
-    if (root == nullptr)
-    {
-        limit->setParent(parent);
-        return limit;
-    }
-    if (limit->getLimitPrice() < root->getLimitPrice())
-    {
-        root->setLeftChild(insertStop(root->getLeftChild(), limit, root));
-        root = balanceStop(root);
-    }
-    else if (limit->getLimitPrice() > root->getLimitPrice())
-    {
-        root->setRightChild(insertStop(root->getRightChild(), limit, root));
-        root = balanceStop(root);
-    }
-    return root;
-}
-
-// Update the edge of the book if new limit is on edge of the book
-void Book::updateBookEdgeInsert(Limit* newLimit)
-{
-    if (newLimit->getBuyOrSell())
-    {
-        if (newLimit->getLimitPrice() > highestBuy->getLimitPrice())
-        {
-            highestBuy = newLimit;
-        }
-    }
-    else
-    {
-        if (newLimit->getLimitPrice() < lowestSell->getLimitPrice())
-        {
-            lowestSell = newLimit;
-        }
-    }
-}
-
-// Update the edge of the stop book if new stop is on edge of the book
-void Book::updateStopBookEdgeInsert(Limit* newStop)
-{
-    if (newStop->getBuyOrSell())
-    {
-        if (newStop->getLimitPrice() < lowestStopBuy->getLimitPrice())
-        {
-            lowestStopBuy = newStop;
-        }
-    }
-    else
-    {
-        if (newStop->getLimitPrice() > highestStopSell->getLimitPrice())
-        {
-            highestStopSell = newStop;
-        }
-    }
-}
-
-// Update the edge of the book if current edge of the book is empty
-void Book::updateBookEdgeDelete(Limit* limit)
-{
-    auto& bookEdge = limit->getBuyOrSell() ? highestBuy : lowestSell;
-    auto& tree = limit->getBuyOrSell() ? buyTree : sellTree;
-
-    if (limit == bookEdge)
-    {
-        if (bookEdge != tree)
-        {
-            if (limit->getBuyOrSell() && bookEdge->getLeftChild() != nullptr)
-            {
-                bookEdge = bookEdge->getLeftChild();
-            }
-            else if (!limit->getBuyOrSell() && bookEdge->getRightChild() != nullptr)
-            {
-                bookEdge = bookEdge->getRightChild();
-            }
-            else {
-                bookEdge = bookEdge->getParent();
-            }
-        }
-        else {
-            if (limit->getBuyOrSell() && bookEdge->getLeftChild() != nullptr)
-            {
-                bookEdge = bookEdge->getLeftChild();
-            }
-            else if (!limit->getBuyOrSell() && bookEdge->getRightChild() != nullptr)
-            {
-                bookEdge = bookEdge->getRightChild();
-            }
-            else {
-                bookEdge = nullptr;
-            }
-        }
-    }
+    return liveOrders.sample(key, gen);
 }
 
-// Update the edge of the stop book if current edge of the stop book is empty
-void Book::updateStopBookEdgeDelete(Limit* stopLevel)
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::addLimit(Price limitPrice, bool buyOrSell)
 {
-    auto& bookEdge = stopLevel->getBuyOrSell() ? lowestStopBuy : highestStopSell;
-    auto& tree = stopLevel->getBuyOrSell() ? stopBuyTree : stopSellTree;
-
-    if (stopLevel == bookEdge)
-    {
-        if (bookEdge != tree)
-        {
-            if (stopLevel->getBuyOrSell() && bookEdge->getRightChild() != nullptr)
-            {
-                bookEdge = bookEdge->getRightChild();
-            }
-            else if (!stopLevel->getBuyOrSell() && bookEdge->getLeftChild() != nullptr)
-            {
-                bookEdge = bookEdge->getLeftChild();
-            }
-            else {
-                bookEdge = bookEdge->getParent();
-            }
-        }
-        else {
-            if (stopLevel->getBuyOrSell() && bookEdge->getRightChild() != nullptr)
-            {
-                bookEdge = bookEdge->getRightChild();
-            }
-            else if (!stopLevel->getBuyOrSell() && bookEdge->getLeftChild() != nullptr)
-            {
-                bookEdge = bookEdge->getLeftChild();
-            }
-            else {
-                bookEdge = nullptr;
-            }
-        }
-    }
+    Limit* newLimit = Limit::create(pools, limitPrice, buyOrSell);
+    (buyOrSell ? buyLimits : sellLimits).insert(newLimit);
+    return newLimit;
 }
 
-// Change the root limit in the AVL tree if the root limit is deleted
-void Book::changeBookRoots(Limit* limit) {
-    auto& tree = limit->getBuyOrSell() ? buyTree : sellTree;
-    if (limit == tree)
-    {
-        if (limit->getRightChild() != nullptr)
-        {
-            tree = tree->getRightChild();
-            while (tree->getLeftChild() != nullptr)
-            {
-                tree = tree->getLeftChild();
-            }
-        }
-        else
-        {
-            tree = limit->getLeftChild();
-        }
-    }
-}
-
-// Change the root stop level in the AVL tree if the root stop level is deleted
-void Book::changeStopBookRoots(Limit* stopLevel) {
-    auto& tree = stopLevel->getBuyOrSell() ? stopBuyTree : stopSellTree;
-    if (stopLevel == tree)
-    {
-        if (stopLevel->getRightChild() != nullptr)
-        {
-            tree = tree->getRightChild();
-            while (tree->getLeftChild() != nullptr)
-            {
-                tree = tree->getLeftChild();
-            }
-        }
-        else
-        {
-            tree = stopLevel->getLeftChild();
-        }
-    }
-}
-
-void Book::deleteLimit(Limit* limit)
+template <typename Config>
+typename BasicBook<Config>::Limit* BasicBook<Config>::addStop(Price stopPrice, bool buyOrSell)
 {
-    updateBookEdgeDelete(limit);
-    deleteFromLimitMaps(limit->getLimitPrice(), limit->getBuyOrSell());
-    changeBookRoots(limit);
-
-    Limit* parent = limit->getParent();
-    int limitPrice = limit->getLimitPrice();
-    delete limit;
-    while (parent != nullptr)
-    {
-        parent = balance(parent);
-        if (parent->getParent() != nullptr)
-        {
-            if (parent->getParent()->getLimitPrice() > limitPrice)
-            {
-                parent->getParent()->setLeftChild(parent);
-            }
-            else {
-                parent->getParent()->setRightChild(parent);
-            }
-        }
-        parent = parent->getParent();
-    }
+    Limit* newStop = Limit::create(pools, stopPrice, buyOrSell);
+    (buyOrSell ? stopBuys : stopSells).insert(newStop);
+    return newStop;
 }
 
-void Book::deleteStop(Limit* stopLevel)
+template <typename Config>
+void BasicBook<Config>::deleteLimit(Limit* limit)
 {
-    updateStopBookEdgeDelete(stopLevel);
-    deleteFromStopMap(stopLevel->getLimitPrice());
-    changeStopBookRoots(stopLevel);
-
-    Limit* parent = stopLevel->getParent();
-    int stopPrice = stopLevel->getLimitPrice();
-    delete stopLevel;
-    while (parent != nullptr)
-    {
-        parent = balanceStop(parent);
-        if (parent->getParent() != nullptr)
-        {
-            if (parent->getParent()->getLimitPrice() > stopPrice)
-            {
-                parent->getParent()->setLeftChild(parent);
-            }
-            else {
-                parent->getParent()->setRightChild(parent);
-            }
-        }
-        parent = parent->getParent();
-    }
+    (limit->getBuyOrSell(pools) ? buyLimits : sellLimits).erase(limit);
+    Limit::destroy(pools, limit);
 }
 
-void Book::deleteFromOrderMap(int orderId)
+template <typename Config>
+void BasicBook<Config>::deleteStop(Limit* stopLevel)
 {
-    orderMap.erase(orderId);
+    (stopLevel->getBuyOrSell(pools) ? stopBuys : stopSells).erase(stopLevel);
+    Limit::destroy(pools, stopLevel);
 }
 
-void Book::deleteFromLimitMaps(int limitPrice, bool buyOrSell)
+template <typename Config>
+void BasicBook<Config>::deleteFromOrderMap(Order* order)
 {
-    auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
-    limitMap.erase(limitPrice);
-}
-
-void Book::deleteFromStopMap(int stopPrice)
-{
-    stopMap.erase(stopPrice);
+    orderStore.erase(order->getOrderId(pools));
+    liveOrders.erase(pools, order);
 }
 
 // When a limit order overlaps with the highest buy or lowest sell, immediately
 // execute it as if it were a market order
-int Book::limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int limitPrice)
+template <typename Config>
+typename BasicBook<Config>::Quantity BasicBook<Config>::limitOrderAsMarketOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, int ownerId)
 {
-    if (buyOrSell)
-    {
-        while (lowestSell != nullptr && shares != 0 && lowestSell->getLimitPrice() <= limitPrice)
-        {
-            if (shares <= lowestSell->getTotalVolume())
-            {
-                marketOrderHelper(orderId, buyOrSell, shares);
-                return 0;
-            }
-            else {
-                shares -= lowestSell->getTotalVolume();
-                marketOrderHelper(orderId, buyOrSell, lowestSell->getTotalVolume());
-            }
-        }
-        return shares;
-    }
-    else {
-        while (highestBuy != nullptr && shares != 0 && highestBuy->getLimitPrice() >= limitPrice)
-        {
-            if (shares <= highestBuy->getTotalVolume())
-            {
-                marketOrderHelper(orderId, buyOrSell, shares);
-                return 0;
-            }
-            else {
-                shares -= highestBuy->getTotalVolume();
-                marketOrderHelper(orderId, buyOrSell, highestBuy->getTotalVolume());
-            }
-        }
-        return shares;
-    }
+    return marketOrderHelper(orderId, buyOrSell, shares, limitPrice, ownerId);
 }
 
-// When a stop order overlaps with the highest buy or lowest sell, immediately
-// execute it as if it were a market order
-int Book::stopOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int stopPrice)
+// A stop order overlapping with the highest buy or lowest sell is executed
+// immediately, stop limit orders as limit orders and stop orders as market orders
+template <typename Config>
+bool BasicBook<Config>::stopTriggered(bool buyOrSell, Price stopPrice) const
 {
-    if (buyOrSell && lowestSell != nullptr && stopPrice <= lowestSell->getLimitPrice())
-    {
-        marketOrder(orderId, true, shares);
-        return 0;
-    }
-    else if (!buyOrSell && highestBuy != nullptr && stopPrice >= highestBuy->getLimitPrice())
+    if (buyOrSell)
     {
-        marketOrder(orderId, false, shares);
-        return 0;
+        return sellLimits.best() != nullptr && stopPrice <= sellLimits.best()->getLimitPrice();
     }
-    return shares;
+    return buyLimits.best() != nullptr && stopPrice >= buyLimits.best()->getLimitPrice();
 }
 
 // When a limit order that used to be a stop limit order overlaps with the highest buy or lowest sell, 
 // immediately execute it as if it were a market order
-int Book::currentOrderAsMarketOrder(Order* headOrder, bool buyOrSell)
+template <typename Config>
+typename BasicBook<Config>::Quantity BasicBook<Config>::currentOrderAsMarketOrder(Order* headOrder, bool buyOrSell)
 {
-    int shares = headOrder->getShares();
-    int orderId = headOrder->getOrderId();
-    int limitPrice = headOrder->getLimit();
-
-    if (buyOrSell)
-    {
-        while (lowestSell != nullptr && lowestSell->getLimitPrice() <= limitPrice)
-        {
-            if (shares <= lowestSell->getTotalVolume())
-            {
-                deleteFromOrderMap(orderId);
-                delete headOrder;
-                marketOrderHelper(orderId, buyOrSell, shares);
-                return 0;
-            }
-            else {
-                shares -= lowestSell->getTotalVolume();
-                marketOrderHelper(orderId, buyOrSell, lowestSell->getTotalVolume());
-            }
-        }
-        return shares;
-    }
-    else {
-        while (highestBuy != nullptr && highestBuy->getLimitPrice() >= limitPrice)
-        {
-            if (shares <= highestBuy->getTotalVolume())
-            {
-                deleteFromOrderMap(orderId);
-                delete headOrder;
-                marketOrderHelper(orderId, buyOrSell, shares);
-                return 0;
-            }
-            else {
-                shares -= highestBuy->getTotalVolume();
-                marketOrderHelper(orderId, buyOrSell, highestBuy->getTotalVolume());
-            }
-        }
-        return shares;
-    }
-}
+    Quantity shares = marketOrderHelper(headOrder->getOrderId(pools), buyOrSell, headOrder->getShares(), headOrder->getLimit(pools), headOrder->getOwnerId(pools));
 
-// When a stop limit order overlaps with the highest buy or lowest sell, immediately
-// execute it as if it were a limit order
-int Book::stopLimitOrderAsLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice)
-{
-    if (buyOrSell && lowestSell != nullptr && stopPrice <= lowestSell->getLimitPrice())
+    if (shares == 0)
     {
-        addLimitOrder(orderId, true, shares, limitPrice);
-        return 0;
-    }
-    else if (!buyOrSell && highestBuy != nullptr && stopPrice >= highestBuy->getLimitPrice())
-    {
-        addLimitOrder(orderId, false, shares, limitPrice);
-        return 0;
+        deleteFromOrderMap(headOrder);
+        Order::destroy(pools, headOrder);
     }
     return shares;
 }
 
-// Executes any stop orders which need to be executed
-void Book::executeStopOrders(bool buyOrSell)
+template <typename Config>
+void BasicBook<Config>::executeStopOrders(bool buyOrSell)
 {
     if (buyOrSell)
     {
         // Execute any buy stop market orders
         // If the book is empty and can't complete stop market order then it just doesn't execute and is forgotten.
-        while (lowestStopBuy != nullptr && (lowestSell == nullptr || lowestStopBuy->getLimitPrice() <= lowestSell->getLimitPrice()))
+        Limit* lowestStopBuy;
+        while ((lowestStopBuy = stopBuys.best()) != nullptr && (sellLimits.best() == nullptr || lowestStopBuy->getLimitPrice() <= sellLimits.best()->getLimitPrice()))
         {
-            Order* headOrder = lowestStopBuy->getHeadOrder();
-            if (headOrder->getLimit() == 0)
+            Order* headOrder = lowestStopBuy->getHeadOrder(pools);
+            if (headOrder->getLimit(pools) == 0)
             {
-                int shares = headOrder->getShares();
-                headOrder->execute();
+                Quantity shares = headOrder->getShares();
+                int ownerId = headOrder->getOwnerId(pools);
+                headOrder->execute(pools);
                 if (lowestStopBuy->getSize() == 0)
                 {
                     deleteStop(lowestStopBuy);
                 }
-                deleteFromOrderMap(headOrder->getOrderId());
-                delete headOrder;
-                marketOrderHelper(0, true, shares);
+                deleteFromOrderMap(headOrder);
+                Order::destroy(pools, headOrder);
+                marketOrderHelper(0, true, shares, marketLimit(true), ownerId);
             }
             else {
                 stopLimitOrderToLimitOrder(headOrder, buyOrSell);
@@ -957,20 +670,22 @@ void Book::executeStopOrders(bool buyOrSell)
     else {
         // Execute any sell stop market orders
         // If the book is empty and can't complete stop market order then it doesn't execute and is forgotten.
-        while (highestStopSell != nullptr && (highestBuy == nullptr || highestStopSell->getLimitPrice() >= highestBuy->getLimitPrice()))
+        Limit* highestStopSell;
+        while ((highestStopSell = stopSells.best()) != nullptr && (buyLimits.best() == nullptr || highestStopSell->getLimitPrice() >= buyLimits.best()->getLimitPrice()))
         {
-            Order* headOrder = highestStopSell->getHeadOrder();
-            if (headOrder->getLimit() == 0)
+            Order* headOrder = highestStopSell->getHeadOrder(pools);
+            if (headOrder->getLimit(pools) == 0)
             {
-                int shares = headOrder->getShares();
-                headOrder->execute();
+                Quantity shares = headOrder->getShares();
+                int ownerId = headOrder->getOwnerId(pools);
+                headOrder->execute(pools);
                 if (highestStopSell->getSize() == 0)
                 {
                     deleteStop(highestStopSell);
                 }
-                deleteFromOrderMap(headOrder->getOrderId());
-                delete headOrder;
-                marketOrderHelper(0, false, shares);
+                deleteFromOrderMap(headOrder);
+                Order::destroy(pools, headOrder);
+                marketOrderHelper(0, false, shares, marketLimit(false), ownerId);
             }
             else {
                 stopLimitOrderToLimitOrder(headOrder, buyOrSell);
@@ -980,217 +695,326 @@ void Book::executeStopOrders(bool buyOrSell)
 }
 
 // Turn stop limit order into limit order
-void Book::stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell)
+template <typename Config>
+void BasicBook<Config>::stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell)
 {
-    auto& bookEdge = buyOrSell ? lowestStopBuy : highestStopSell;
-    headOrder->execute();
+    Limit* bookEdge = (buyOrSell ? stopBuys : stopSells).best();
+    headOrder->execute(pools);
     if (bookEdge->getSize() == 0)
     {
         deleteStop(bookEdge);
     }
 
     // Account for order being executed immediately - majority of cases
-    int shares = currentOrderAsMarketOrder(headOrder, buyOrSell);
+    Quantity shares = currentOrderAsMarketOrder(headOrder, buyOrSell);
 
     if (shares != 0)
     {
         headOrder->setShares(shares);
-        auto& limitMap = buyOrSell ? limitBuyMap : limitSellMap;
+        Limit* limit = (buyOrSell ? buyLimits : sellLimits).find(headOrder->getLimit(pools));
 
-        if (limitMap.find(headOrder->getLimit()) == limitMap.end())
+        if (limit == nullptr)
         {
-            addLimit(headOrder->getLimit(), buyOrSell);
+            limit = addLimit(headOrder->getLimit(pools), buyOrSell);
         }
-        limitMap.at(headOrder->getLimit())->addOrder(headOrder);
+        limit->addOrder(pools, headOrder);
+        liveOrders.erase(pools, headOrder);
+        liveOrders.insert(pools, headOrder, LiveOrders<Order>::limitKind);
     }
 }
 
-// Function which actually executes the market order.
+// Function which actually executes the market order up to limitPrice and returns the shares which couldn't be matched.
 // If the book is empty and can't complete market order then market order doesn't execute and is forgotten
-void Book::marketOrderHelper(int orderId, bool buyOrSell, int shares)
+template <typename Config>
+typename BasicBook<Config>::Quantity BasicBook<Config>::marketOrderHelper(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, int ownerId)
 {
-    auto& bookEdge = buyOrSell ? lowestSell : highestBuy;
+    PriceIndex& oppositeSide = buyOrSell ? sellLimits : buyLimits;
 
-    while (bookEdge != nullptr && bookEdge->getHeadOrder()->getShares() <= shares)
+    // Without self trade prevention the fill loop never reads the owner of resting orders
+    const int selfTradeOwner = (selfTradePrevention == SelfTradePrevention::None || ownerId == noOwner) ? noSelfTradeOwner : ownerId;
+    matchedShares = 0;
+    selfTradeCancelledShares = 0;
+
+    Limit* limit;
+    while ((limit = oppositeSide.best()) != nullptr && shares != 0 && (buyOrSell ? limit->getLimitPrice() <= limitPrice : limit->getLimitPrice() >= limitPrice))
     {
-        Order* headOrder = bookEdge->getHeadOrder();
-        shares -= headOrder->getShares();
-        headOrder->execute();
-        if (bookEdge->getSize() == 0)
+        if constexpr (!MatchingPolicy::fifo)
         {
-            deleteLimit(bookEdge);
+            shares = allocateLimit(limit, orderId, shares, selfTradeOwner);
+            continue;
         }
-        deleteFromOrderMap(headOrder->getOrderId());
-        delete headOrder;
-        executedOrdersCount += 1;
-    }
-    if (bookEdge != nullptr && shares != 0)
-    {
-        bookEdge->getHeadOrder()->partiallyFillOrder(shares);
-        executedOrdersCount += 1;
-    }
-}
-
-// Get height difference between a limits children
-int Book::limitHeightDifference(Limit* limit) {
-    int l_height = getLimitHeight(limit->getLeftChild());
-    int r_height = getLimitHeight(limit->getRightChild());
-    int b_factor = l_height - r_height;
-    return b_factor;
-}
 
-// RR rotation for AVL restructure
-Limit* Book::rr_rotate(Limit* parent) {
-    Limit* newParent = parent->getRightChild();
-    parent->setRightChild(newParent->getLeftChild());
-    if (newParent->getLeftChild() != nullptr)
-    {
-        newParent->getLeftChild()->setParent(parent);
-    }
-    newParent->setLeftChild(parent);
-    if (parent->getParent() != nullptr)
-    {
-        newParent->setParent(parent->getParent());
-    }
-    else {
-        newParent->setParent(nullptr);
-        auto& tree = parent->getBuyOrSell() ? buyTree : sellTree;
-        tree = newParent;
+        while (shares != 0)
+        {
+            Order* headOrder = limit->getHeadOrder(pools);
+            if (selfTradeOwner != noSelfTradeOwner && headOrder->getOwnerId(pools) == selfTradeOwner)
+            {
+                shares = preventSelfTrade(headOrder, shares);
+                if (limit->getSize() == 0)
+                {
+                    deleteLimit(limit);
+                    break;
+                }
+                continue;
+            }
+            if (headOrder->getShares() > shares)
+            {
+                eventSink.onTrade(headOrder->getOrderId(pools), orderId, limit->getLimitPrice(), shares);
+                headOrder->partiallyFillOrder(pools, shares);
+                matchedShares += shares;
+                executedOrdersCount += 1;
+                return 0;
+            }
+            eventSink.onTrade(headOrder->getOrderId(pools), orderId, limit->getLimitPrice(), headOrder->getShares());
+            matchedShares += headOrder->getShares();
+            shares -= headOrder->getShares();
+            if (headOrder->isIceberg() && headOrder->getHiddenShares(pools) != 0)
+            {
+                // Iceberg order is refilled from its reserve and requeued instead of being deleted
+                headOrder->replenish(pools);
+                executedOrdersCount += 1;
+                continue;
+            }
+            headOrder->execute(pools);
+            bool emptyLimit = limit->getSize() == 0;
+            if (emptyLimit)
+            {
+                deleteLimit(limit);
+            }
+            deleteFromOrderMap(headOrder);
+            Order::destroy(pools, headOrder);
+            executedOrdersCount += 1;
+            if (emptyLimit)
+            {
+                break;
+            }
+        }
     }
-    parent->setParent(newParent);
-    return newParent;
+    return shares;
 }
 
-// LL rotation for AVL restructure
-Limit* Book::ll_rotate(Limit* parent) {
-    Limit* newParent = parent->getLeftChild();
-    parent->setLeftChild(newParent->getRightChild());
-    if (newParent->getRightChild() != nullptr)
-    {
-        newParent->getRightChild()->setParent(parent);
-    }
-    newParent->setRightChild(parent);
-    if (parent->getParent() != nullptr)
+// Share an incoming order between all orders of a limit using the matching policy
+// and return the shares of the incoming order which are left
+template <typename Config>
+typename BasicBook<Config>::Quantity BasicBook<Config>::allocateLimit(Limit* limit, int orderId, Quantity shares, int selfTradeOwner)
+{
+    // Self trades are resolved before the level is allocated
+    if (selfTradeOwner != noSelfTradeOwner)
     {
-        newParent->setParent(parent->getParent());
-    }
-    else {
-        newParent->setParent(nullptr);
-        auto& tree = parent->getBuyOrSell() ? buyTree : sellTree;
-        tree = newParent;
+        Order* order = limit->getHeadOrder(pools);
+        int count = limit->getSize();
+        for (int i = 0; i < count && shares != 0; i++)
+        {
+            Order* nextOrder = order->getNextOrder(pools);
+            if (order->getOwnerId(pools) == selfTradeOwner)
+            {
+                shares = preventSelfTrade(order, shares);
+            }
+            order = nextOrder;
+        }
+        if (limit->getSize() == 0)
+        {
+            deleteLimit(limit);
+            return shares;
+        }
+        if (shares == 0)
+        {
+            return 0;
+        }
     }
-    parent->setParent(newParent);
-    return newParent;
-}
-
-// LR rotation for AVL restructure
-Limit* Book::lr_rotate(Limit* parent) {
-    Limit* newParent = parent->getLeftChild();
-    parent->setLeftChild(rr_rotate(newParent));
-    return ll_rotate(parent);
-}
 
-// RL rotation for AVL restructure
-Limit* Book::rl_rotate(Limit* parent) {
-    Limit* newParent = parent->getRightChild();
-    parent->setRightChild(ll_rotate(newParent));
-    return rr_rotate(parent);
-}
+    int count = limit->getSize();
+    Quantity incomingShares = std::min(shares, limit->getTotalVolume());
+    allocationShares.resize(count);
+    allocationFills.assign(count, 0);
 
-// Check if the AVL tree needs to be restructured
-Limit* Book::balance(Limit* limit) {
-    int bal_factor = limitHeightDifference(limit);
-    if (bal_factor > 1) {
-        if (limitHeightDifference(limit->getLeftChild()) >= 0)
-            limit = ll_rotate(limit);
-        else
-            limit = lr_rotate(limit);
-        AVLTreeBalanceCount += 1;
-    }
-    else if (bal_factor < -1) {
-        if (limitHeightDifference(limit->getRightChild()) > 0)
-            limit = rl_rotate(limit);
-        else
-            limit = rr_rotate(limit);
-        AVLTreeBalanceCount += 1;
+    Order* order = limit->getHeadOrder(pools);
+    for (int i = 0; i < count; i++)
+    {
+        allocationShares[i] = order->getShares();
+        order = order->getNextOrder(pools);
     }
-    return limit;
-}
 
-// RR rotation for AVL stop tree restructure
-Limit* Book::rr_rotateStop(Limit* parent) {
-    Limit* newParent = parent->getRightChild();
-    parent->setRightChild(newParent->getLeftChild());
-    if (newParent->getLeftChild() != nullptr)
+    MatchingPolicy::allocate(allocationShares.data(), allocationFills.data(), count, incomingShares);
+
+    // Replenished iceberg orders move to the back, so only the original orders are visited
+    order = limit->getHeadOrder(pools);
+    for (int i = 0; i < count; i++)
     {
-        newParent->getLeftChild()->setParent(parent);
+        Order* nextOrder = order->getNextOrder(pools);
+        if (allocationFills[i] != 0)
+        {
+            eventSink.onTrade(order->getOrderId(pools), orderId, limit->getLimitPrice(), allocationFills[i]);
+            matchedShares += allocationFills[i];
+        }
+        if (allocationFills[i] == allocationShares[i])
+        {
+            if (order->isIceberg() && order->getHiddenShares(pools) != 0)
+            {
+                order->replenish(pools);
+            }
+            else
+            {
+                order->cancel(pools);
+                deleteFromOrderMap(order);
+                Order::destroy(pools, order);
+            }
+            executedOrdersCount += 1;
+        }
+        else if (allocationFills[i] != 0)
+        {
+            order->partiallyFillOrder(pools, allocationFills[i]);
+            executedOrdersCount += 1;
+        }
+        order = nextOrder;
     }
-    newParent->setLeftChild(parent);
-    if (parent->getParent() != nullptr)
+
+    if (limit->getSize() == 0)
     {
-        newParent->setParent(parent->getParent());
-    }
-    else {
-        newParent->setParent(nullptr);
-        auto& tree = parent->getBuyOrSell() ? stopBuyTree : stopSellTree;
-        tree = newParent;
+        deleteLimit(limit);
     }
-    parent->setParent(newParent);
-    return newParent;
+    return shares - incomingShares;
 }
 
-// LL rotation for AVL stop tree restructure
-Limit* Book::ll_rotateStop(Limit* parent) {
-    Limit* newParent = parent->getLeftChild();
-    parent->setLeftChild(newParent->getRightChild());
-    if (newParent->getRightChild() != nullptr)
+// Resolve an incoming order meeting a resting order of the same owner and return the shares
+// of the incoming order which are left. Empty limits are left for the caller to delete
+template <typename Config>
+typename BasicBook<Config>::Quantity BasicBook<Config>::preventSelfTrade(Order* restingOrder, Quantity shares)
+{
+    if (selfTradePrevention == SelfTradePrevention::CancelNewest)
     {
-        newParent->getRightChild()->setParent(parent);
+        selfTradeCancelledShares += shares;
+        return 0;
     }
-    newParent->setRightChild(parent);
-    if (parent->getParent() != nullptr)
+
+    Quantity decrement = restingOrder->getShares();
+    if (selfTradePrevention == SelfTradePrevention::DecrementBoth)
     {
-        newParent->setParent(parent->getParent());
-    }
-    else {
-        newParent->setParent(nullptr);
-        auto& tree = parent->getBuyOrSell() ? stopBuyTree : stopSellTree;
-        tree = newParent;
+        if (shares < decrement)
+        {
+            restingOrder->partiallyFillOrder(pools, shares);
+            selfTradeCancelledShares += shares;
+            return 0;
+        }
+        selfTradeCancelledShares += decrement;
+        if (restingOrder->isIceberg() && restingOrder->getHiddenShares(pools) != 0)
+        {
+            restingOrder->replenish(pools);
+            return shares - decrement;
+        }
     }
-    parent->setParent(newParent);
-    return newParent;
+
+    restingOrder->cancel(pools);
+    deleteFromOrderMap(restingOrder);
+    eventSink.onCancel(restingOrder->getOrderId(pools));
+    Order::destroy(pools, restingOrder);
+
+    return selfTradePrevention == SelfTradePrevention::DecrementBoth ? shares - decrement : shares;
 }
 
-// LR rotation for AVL stop tree restructure
-Limit* Book::lr_rotateStop(Limit* parent) {
-    Limit* newParent = parent->getLeftChild();
-    parent->setLeftChild(rr_rotateStop(newParent));
-    return ll_rotateStop(parent);
+// Orders which lost shares to self trade prevention report it in their status
+template <typename Config>
+OrderStatus BasicBook<Config>::matchStatus(Quantity cancelledShares)
+{
+    return cancelledShares != 0 ? OrderStatus::SelfTradeCancelled : OrderStatus::Ok;
 }
 
-// RL rotation for AVL stop tree restructure
-Limit* Book::rl_rotateStop(Limit* parent) {
-    Limit* newParent = parent->getRightChild();
-    parent->setRightChild(ll_rotateStop(newParent));
-    return rr_rotateStop(parent);
+// Price which lets an order sweep the whole opposite side of the book
+template <typename Config>
+typename BasicBook<Config>::Price BasicBook<Config>::marketLimit(bool buyOrSell)
+{
+    return buyOrSell ? std::numeric_limits<Price>::max() : std::numeric_limits<Price>::min();
 }
 
-// Check if the AVL stop tree needs to be restructured
-Limit* Book::balanceStop(Limit* limit) {
-    int bal_factor = limitHeightDifference(limit);
-    if (bal_factor > 1) {
-        if (limitHeightDifference(limit->getLeftChild()) >= 0)
-            limit = ll_rotateStop(limit);
-        else
-            limit = lr_rotateStop(limit);
-        AVLTreeBalanceCount += 1;
-    }
-    else if (bal_factor < -1) {
-        if (limitHeightDifference(limit->getRightChild()) > 0)
-            limit = rl_rotateStop(limit);
-        else
-            limit = rr_rotateStop(limit);
-        AVLTreeBalanceCount += 1;
-    }
-    return limit;
-}
\ No newline at end of file
+// Check if there is enough volume within the limit price to completely fill an order,
+// walking the levels from the edge of the book without changing anything
+template <typename Config>
+bool BasicBook<Config>::canFillWithinLimit(bool buyOrSell, Quantity shares, Price limitPrice, int ownerId) const
+{
+    const PriceIndex& oppositeSide = buyOrSell ? sellLimits : buyLimits;
+    const int selfTradeOwner = (selfTradePrevention == SelfTradePrevention::None || ownerId == noOwner) ? noSelfTradeOwner : ownerId;
+    Limit* limit = oppositeSide.best();
+
+    while (limit != nullptr && shares > 0)
+    {
+        if (buyOrSell ? limit->getLimitPrice() > limitPrice : limit->getLimitPrice() < limitPrice)
+        {
+            break;
+        }
+        if (selfTradeOwner == noSelfTradeOwner)
+        {
+            // Iceberg orders refill the level from their reserve while it trades
+            shares -= limit->getTotalVolume() + limit->getHiddenVolume(pools);
+            limit = oppositeSide.next(limit);
+            continue;
+        }
+
+        // Orders of the owner never trade. CancelOldest cancels them out of the way, the other
+        // modes drop incoming shares on reaching one, so the order must fill before that.
+        // Refilled icebergs queue behind the order of the owner and are out of reach then.
+        Quantity sharesAhead = 0;
+        Quantity levelShares = 0;
+        Order* order = limit->getHeadOrder(pools);
+        for (int i = 0, count = limit->getSize(); i < count; i++, order = order->getNextOrder(pools))
+        {
+            if (order->getOwnerId(pools) != selfTradeOwner)
+            {
+                sharesAhead += order->getShares();
+                levelShares += order->getShares() + order->getHiddenShares(pools);
+            }
+            else if (selfTradePrevention != SelfTradePrevention::CancelOldest)
+            {
+                // Non FIFO policies resolve self trades before allocating the level
+                return MatchingPolicy::fifo && shares <= sharesAhead;
+            }
+        }
+        shares -= levelShares;
+        limit = oppositeSide.next(limit);
+    }
+    return shares <= 0;
+}
+
+// Shipped book configurations, their order and limit types are instantiated in Order.cpp and Limit.cpp
+template class BasicBook<DefaultBookConfig>;
+template class BasicBook<NarrowBookConfig>;
+template class BasicBook<WideBookConfig>;
+template class BasicBook<ProRataBookConfig>;
+template class BasicBook<FifoProRataBookConfig>;
+
+// Every engine policy combination over the default configuration, so benchmarks can pick any of them
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, UnorderedMapOrderStore, HeapAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, UnorderedMapOrderStore, HeapAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, UnorderedMapOrderStore, PoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, UnorderedMapOrderStore, PoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, FlatHashOrderStore, HeapAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, FlatHashOrderStore, HeapAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, FlatHashOrderStore, PoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, FlatHashOrderStore, PoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, FlatHashOrderStore, IndexPoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, FlatHashOrderStore, IndexPoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, DenseVectorOrderStore, HeapAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, DenseVectorOrderStore, HeapAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, DenseVectorOrderStore, PoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, DenseVectorOrderStore, PoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, AVLPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, UnorderedMapOrderStore, HeapAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, UnorderedMapOrderStore, HeapAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, UnorderedMapOrderStore, PoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, UnorderedMapOrderStore, PoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, FlatHashOrderStore, HeapAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, FlatHashOrderStore, HeapAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, FlatHashOrderStore, PoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, FlatHashOrderStore, PoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, FlatHashOrderStore, IndexPoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, FlatHashOrderStore, IndexPoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, DenseVectorOrderStore, HeapAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, DenseVectorOrderStore, HeapAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, DenseVectorOrderStore, PoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, DenseVectorOrderStore, PoolAllocator, RecordingEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, NullEventSink>>;
+template class BasicBook<BookPolicies<DefaultBookConfig, LadderPriceIndex, DenseVectorOrderStore, IndexPoolAllocator, RecordingEventSink>>;
\ No newline at end of file
@@ -1,89 +1,83 @@
 #ifndef BOOK_HPP
 #define BOOK_HPP
 
-#include <unordered_map>
 #include <vector>
 #include <random>
-#include <unordered_set>
-#include <array>
-#include "MemoryPool.hpp"
-
-class Limit;
-class Order;
+#include "OrderTypes.hpp"
+#include "BookConfig.hpp"
+#include "Order.hpp"
+#include "Limit.hpp"
+#include "LiveOrders.hpp"
+
+template <typename Config>
+class BasicBook {
+public:
+	using Price = typename Config::Price;
+	using Quantity = typename Config::Quantity;
+	using Order = BasicOrder<Price, Quantity, typename Config::Allocator>;
+	using Limit = BasicLimit<Price, Quantity, typename Config::Allocator>;
+	using Pools = typename Order::Pools;
+	using EventSink = typename Config::EventSink;
+	using OrderResult = BasicOrderResult<Quantity>;
 
-class Book {
 private:
-	// Original pointers kept as-is
-	Limit* buyTree;
-	Limit* sellTree;
-	Limit* lowestSell;
-	Limit* highestBuy;
-
-	Limit* stopBuyTree;
-	Limit* stopSellTree;
-	Limit* highestStopSell;
-	Limit* lowestStopBuy;
-
-	// Original maps kept as-is
-	std::unordered_map<int, Order*> orderMap;
-	std::unordered_map<int, Limit*> limitBuyMap;
-	std::unordered_map<int, Limit*> limitSellMap;
-	std::unordered_map<int, Limit*> stopMap;
-
-	// Memory pools and optimization structures
-	MemoryPool<Order> orderPool;
-	MemoryPool<Limit> limitPool;
-	std::array<Limit*, 10000> buyLevels;
-	std::array<Limit*, 10000> sellLevels;
-	std::array<Limit*, 10000> stopBuyLevels;
-	std::array<Limit*, 10000> stopSellLevels;
+	using MatchingPolicy = typename Config::MatchingPolicy;
+	using PriceIndex = typename Config::PriceIndex::template Side<Config, Limit>;
+	using OrderStore = typename Config::OrderStore::template Store<Order>;
+
+	// Orders and price levels of this book, owned by it and freed with it
+	Pools pools;
+
+	// Price levels of both sides of the book and of the stop book
+	PriceIndex buyLimits;
+	PriceIndex sellLimits;
+	PriceIndex stopBuys;
+	PriceIndex stopSells;
+
+	OrderStore orderStore;
+	EventSink eventSink;
+	LiveOrders<Order> liveOrders;
+
+	// Self trade prevention applied in the matching loop
+	static constexpr int noSelfTradeOwner = -1;
+	SelfTradePrevention selfTradePrevention = SelfTradePrevention::None;
+
+	// Shares the incoming order traded in the last call of marketOrderHelper
+	Quantity matchedShares = 0;
+	// Shares of the incoming order self trade prevention dropped in the same call
+	Quantity selfTradeCancelledShares = 0;
+
+	// Scratch buffers for allocating a level between its orders in non FIFO matching
+	std::vector<Quantity> allocationShares;
+	std::vector<Quantity> allocationFills;
 
 	// Original private methods
-	void addLimit(int limitPrice, bool buyOrSell);
-	void addStop(int stopPrice, bool buyOrSell);
-	Limit* insert(Limit* root, Limit* limit, Limit* parent = nullptr);
-	Limit* insertStop(Limit* root, Limit* limit, Limit* parent = nullptr);
-	void updateBookEdgeInsert(Limit* newLimit);
-	void updateStopBookEdgeInsert(Limit* newStop);
-	void updateBookEdgeDelete(Limit* limit);
-	void updateStopBookEdgeDelete(Limit* stop);
-	void changeBookRoots(Limit* limit);
-	void changeStopBookRoots(Limit* stop);
+	Limit* addLimit(Price limitPrice, bool buyOrSell);
+	Limit* addStop(Price stopPrice, bool buyOrSell);
 	void deleteLimit(Limit* limit);
 	void deleteStop(Limit* stop);
-	void deleteFromOrderMap(int orderId);
-	void deleteFromLimitMaps(int limitPrice, bool buyOrSell);
-	void deleteFromStopMap(int stopPrice);
-	int limitOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int limitPrice);
-	int stopOrderAsMarketOrder(int orderId, bool buyOrSell, int shares, int stopPrice);
-	int currentOrderAsMarketOrder(Order* headOrder, bool buyOrSell);
-	int stopLimitOrderAsLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice);
+	void deleteFromOrderMap(Order* order);
+	Order* searchOrderMap(int orderId, int kind) const;
+	Quantity limitOrderAsMarketOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, int ownerId);
+	bool stopTriggered(bool buyOrSell, Price stopPrice) const;
+	Quantity currentOrderAsMarketOrder(Order* headOrder, bool buyOrSell);
 	void executeStopOrders(bool buyOrSell);
 	void stopLimitOrderToLimitOrder(Order* headOrder, bool buyOrSell);
-	void marketOrderHelper(int orderId, bool buyOrSell, int shares);
-
-	// Balance AVL tree
-	int limitHeightDifference(Limit* limit);
-	Limit* rr_rotate(Limit* limit);
-	Limit* ll_rotate(Limit* limit);
-	Limit* lr_rotate(Limit* limit);
-	Limit* rl_rotate(Limit* limit);
-	Limit* balance(Limit* limit);
-	Limit* rr_rotateStop(Limit* limit);
-	Limit* ll_rotateStop(Limit* limit);
-	Limit* lr_rotateStop(Limit* limit);
-	Limit* rl_rotateStop(Limit* limit);
-	Limit* balanceStop(Limit* limit);
+	Quantity marketOrderHelper(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, int ownerId);
+	Quantity allocateLimit(Limit* limit, int orderId, Quantity shares, int selfTradeOwner);
+	Quantity preventSelfTrade(Order* restingOrder, Quantity shares);
+	static Price marketLimit(bool buyOrSell);
+	static OrderStatus matchStatus(Quantity cancelledShares);
+	bool canFillWithinLimit(bool buyOrSell, Quantity shares, Price limitPrice, int ownerId) const;
 
 public:
-	Book();
-	~Book();
+	BasicBook();
 
 	// Counts used in order book benchmarking
 	int executedOrdersCount = 0;
 	int AVLTreeBalanceCount = 0;
 
-	// Getter and setter
+	// Getter and setter, the trees are only linked with an AVL price index
 	Limit* getBuyTree() const;
 	Limit* getSellTree() const;
 	Limit* getLowestSell() const;
@@ -92,38 +86,43 @@ public:
 	Limit* getStopSellTree() const;
 	Limit* getHighestStopSell() const;
 	Limit* getLowestStopBuy() const;
+	SelfTradePrevention getSelfTradePrevention() const;
+	void setSelfTradePrevention(SelfTradePrevention mode);
+	EventSink& getEventSink();
+	// Orders and levels returned by the book are read through its pools, e.g. order->getOrderId(book.getPools())
+	const Pools& getPools() const;
 
 	// Functions for different types of orders
-	void marketOrder(int orderId, bool buyOrSell, int shares);
-	void addLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice);
-	void cancelLimitOrder(int orderId);
-	void modifyLimitOrder(int orderId, int newShares, int newLimit);
-	void addStopOrder(int orderId, bool buyOrSell, int shares, int stopPrice);
-	void cancelStopOrder(int orderId);
-	void modifyStopOrder(int orderId, int newShares, int newStopPrice);
-	void addStopLimitOrder(int orderId, bool buyOrSell, int shares, int limitPrice, int stopPrice);
-	void cancelStopLimitOrder(int orderId);
-	void modifyStopLimitOrder(int orderId, int newShares, int newLimitPrice, int newStopPrice);
+	// Orders with a price that can't rest in the book (see BookConfig::isValidPrice) are rejected with InvalidPrice
+	OrderResult marketOrder(int orderId, bool buyOrSell, Quantity shares, int ownerId = noOwner);
+	OrderResult addLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, TimeInForce timeInForce = TimeInForce::GoodTillCancel, int ownerId = noOwner);
+	OrderResult addIcebergOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Quantity peakShares, int ownerId = noOwner);
+	OrderResult cancelLimitOrder(int orderId);
+	OrderResult modifyLimitOrder(int orderId, Quantity newShares, Price newLimit);
+	OrderResult addStopOrder(int orderId, bool buyOrSell, Quantity shares, Price stopPrice, int ownerId = noOwner);
+	OrderResult cancelStopOrder(int orderId);
+	OrderResult modifyStopOrder(int orderId, Quantity newShares, Price newStopPrice);
+	OrderResult addStopLimitOrder(int orderId, bool buyOrSell, Quantity shares, Price limitPrice, Price stopPrice, int ownerId = noOwner);
+	OrderResult cancelStopLimitOrder(int orderId);
+	OrderResult modifyStopLimitOrder(int orderId, Quantity newShares, Price newLimitPrice, Price newStopPrice);
 
 	int getLimitHeight(Limit* limit) const;
+	// Lookups return nullptr on a miss without printing
 	Order* searchOrderMap(int orderId) const;
-	Limit* searchLimitMaps(int limitPrice, bool buyOrSell) const;
-	Limit* searchStopMap(int stopPrice) const;
+	Limit* searchLimitMaps(Price limitPrice, bool buyOrSell) const;
+	Limit* searchStopMap(Price stopPrice, bool buyOrSell) const;
 
 	// visualising the order book
-	void printLimit(int limitPrice, bool buyOrSell) const;
+	void printLimit(Price limitPrice, bool buyOrSell) const;
 	void printOrder(int orderId) const;
 	void printBookEdges() const;
 	void printOrderBook() const;
-	std::vector<int> inOrderTreeTraversal(Limit* root) const;
-	std::vector<int> preOrderTreeTraversal(Limit* root) const;
-	std::vector<int> postOrderTreeTraversal(Limit* root) const;
+	std::vector<Price> inOrderTreeTraversal(Limit* root) const;
+	std::vector<Price> preOrderTreeTraversal(Limit* root) const;
+	std::vector<Price> postOrderTreeTraversal(Limit* root) const;
 
 	// generating sample data
-	Order* getRandomOrder(int key, std::mt19937 gen) const;
-	std::unordered_set<Order*> limitOrders;
-	std::unordered_set<Order*> stopOrders;
-	std::unordered_set<Order*> stopLimitOrders;
+	Order* getRandomOrder(int key, std::mt19937& gen) const;
 };
 
 #endif
\ No newline at end of file
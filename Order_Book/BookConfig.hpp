@@ -0,0 +1,88 @@
+#ifndef BOOK_CONFIG_HPP
+#define BOOK_CONFIG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "MatchingPolicy.hpp"
+#include "PriceIndex.hpp"
+#include "OrderStore.hpp"
+#include "Allocator.hpp"
+#include "EventSink.hpp"
+
+// Compile time configuration of an order book.
+// Prices are fixed point integers in the smallest price unit, a book holds
+// levelCount price levels of tickSize units starting at minPrice. Internally
+// levels are addressed by their tick index, so with a power of two tick size
+// the mapping from a price to its slot is a subtraction and a shift.
+// The engine policies default to the original AVL trees and unordered_map, with orders
+// and levels split into hot and cold parts by the index pool allocator.
+template <typename PriceT = std::int32_t, typename QuantityT = std::int64_t, PriceT TickSize = 1,
+	PriceT MinPrice = 0, std::size_t LevelCount = 10000, typename MatchingPolicyT = FifoMatching>
+struct BookConfig {
+	static_assert(std::is_integral_v<PriceT> && std::is_signed_v<PriceT>, "Prices are signed fixed point integers");
+	static_assert(std::is_integral_v<QuantityT> && std::is_signed_v<QuantityT>, "Quantities are signed integers");
+	static_assert(TickSize > 0, "Tick size must be positive");
+
+	using Price = PriceT;
+	using Quantity = QuantityT;
+	using MatchingPolicy = MatchingPolicyT;
+	using PriceIndex = AVLPriceIndex;
+	using OrderStore = UnorderedMapOrderStore;
+	using Allocator = IndexPoolAllocator;
+	using EventSink = NullEventSink;
+
+	static constexpr Price tickSize = TickSize;
+	static constexpr Price minPrice = MinPrice;
+	static constexpr std::size_t levelCount = LevelCount;
+
+	// Prices outside of the configured range or off the tick grid can't rest in the book
+	static constexpr bool isValidPrice(Price price) {
+		return price >= minPrice && (price - minPrice) % tickSize == 0 && toTick(price) < levelCount;
+	}
+
+	static constexpr std::size_t toTick(Price price) {
+		return static_cast<std::size_t>(static_cast<std::make_unsigned_t<Price>>(price - minPrice) / tickSize);
+	}
+
+	static constexpr Price fromTick(std::size_t tick) {
+		return minPrice + static_cast<Price>(tick) * tickSize;
+	}
+};
+
+// Default book, 32 bit prices with 64 bit quantities so level volumes can't overflow
+using DefaultBookConfig = BookConfig<>;
+// 32 bit quantities for cache density when level volumes are known to stay small
+using NarrowBookConfig = BookConfig<std::int32_t, std::int32_t>;
+// 64 bit prices for instruments quoted with many decimals
+using WideBookConfig = BookConfig<std::int64_t, std::int64_t>;
+using ProRataBookConfig = BookConfig<std::int32_t, std::int64_t, 1, 0, 10000, ProRataMatching>;
+using FifoProRataBookConfig = BookConfig<std::int32_t, std::int64_t, 1, 0, 10000, FifoProRataMatching>;
+
+// Replace the engine policies of a configuration
+template <typename Config, typename PriceIndexT, typename OrderStoreT, typename AllocatorT, typename EventSinkT>
+struct BookPolicies : Config {
+	using PriceIndex = PriceIndexT;
+	using OrderStore = OrderStoreT;
+	using Allocator = AllocatorT;
+	using EventSink = EventSinkT;
+};
+
+template <typename Price, typename Quantity, typename Allocator>
+class BasicOrder;
+
+template <typename Price, typename Quantity, typename Allocator>
+class BasicLimit;
+
+template <typename Config>
+class BasicBook;
+
+using Order = BasicOrder<DefaultBookConfig::Price, DefaultBookConfig::Quantity, DefaultBookConfig::Allocator>;
+using Limit = BasicLimit<DefaultBookConfig::Price, DefaultBookConfig::Quantity, DefaultBookConfig::Allocator>;
+using Book = BasicBook<DefaultBookConfig>;
+
+// Book with its engine picked at compile time, e.g. PolicyBook<LadderPriceIndex, FlatHashOrderStore, IndexPoolAllocator, NullEventSink>
+template <typename PriceIndex, typename OrderStore, typename Allocator, typename EventSink, typename Config = DefaultBookConfig>
+using PolicyBook = BasicBook<BookPolicies<Config, PriceIndex, OrderStore, Allocator, EventSink>>;
+
+#endif
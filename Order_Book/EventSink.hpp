@@ -0,0 +1,45 @@
+#ifndef EVENT_SINK_HPP
+#define EVENT_SINK_HPP
+
+#include <cstdint>
+#include <vector>
+
+// Event sink policies are told about trades and cancels from inside the matching loop.
+// Selected at compile time through BookConfig.
+
+// Drops every event, the calls compile away
+struct NullEventSink {
+	template <typename Price, typename Quantity>
+	void onTrade(int, int, Price, Quantity) {}
+
+	void onCancel(int) {}
+};
+
+// Keeps every event so fills can be checked after the fact
+struct RecordingEventSink {
+	struct Trade {
+		int restingOrderId;
+		int incomingOrderId;
+		std::int64_t price;
+		std::int64_t shares;
+	};
+
+	std::vector<Trade> trades;
+	std::vector<int> cancels;
+
+	template <typename Price, typename Quantity>
+	void onTrade(int restingOrderId, int incomingOrderId, Price price, Quantity shares) {
+		trades.push_back({ restingOrderId, incomingOrderId, static_cast<std::int64_t>(price), static_cast<std::int64_t>(shares) });
+	}
+
+	void onCancel(int orderId) {
+		cancels.push_back(orderId);
+	}
+
+	void clear() {
+		trades.clear();
+		cancels.clear();
+	}
+};
+
+#endif
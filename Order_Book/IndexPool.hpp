@@ -0,0 +1,79 @@
+#ifndef INDEX_POOL_HPP
+#define INDEX_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Link between pooled objects, index 0 is never handed out and stands for no object
+using PoolIndex = std::uint32_t;
+constexpr PoolIndex nullIndex = 0;
+
+// Objects split into the fields touched while matching and the rarely read rest.
+// The hot parts are packed together in one array and the cold parts live at the same
+// index of a parallel array. Both grow in chunks which are never moved, so pointers to
+// the hot parts stay valid and 32 bit indices can replace pointers between objects.
+template <typename Hot, typename Cold, std::size_t ChunkBits = 12>
+class IndexPool {
+public:
+	constexpr IndexPool() = default;
+	IndexPool(const IndexPool&) = delete;
+	IndexPool& operator=(const IndexPool&) = delete;
+
+	~IndexPool() {
+		for (std::size_t chunk = 0; chunk < hotChunks.size(); chunk++) {
+			delete[] hotChunks[chunk];
+			delete[] coldChunks[chunk];
+		}
+	}
+
+	// Reserve a slot, the hot part is constructed in place by the caller
+	PoolIndex allocate() {
+		if (!freeIndices.empty()) {
+			PoolIndex index = freeIndices.back();
+			freeIndices.pop_back();
+			return index;
+		}
+		if ((nextIndex >> ChunkBits) == hotChunks.size()) {
+			hotChunks.push_back(new Slot[chunkSize]);
+			coldChunks.push_back(new Cold[chunkSize]);
+		}
+		return nextIndex++;
+	}
+
+	void deallocate(PoolIndex index) {
+		freeIndices.push_back(index);
+	}
+
+	void* storage(PoolIndex index) const {
+		return &hotChunks[index >> ChunkBits][index & chunkMask];
+	}
+
+	// Object at an index which is known not to be null
+	Hot* at(PoolIndex index) const {
+		return reinterpret_cast<Hot*>(storage(index));
+	}
+
+	Hot* get(PoolIndex index) const {
+		return index == nullIndex ? nullptr : at(index);
+	}
+
+	Cold& cold(PoolIndex index) const {
+		return coldChunks[index >> ChunkBits][index & chunkMask];
+	}
+
+private:
+	static constexpr std::size_t chunkSize = std::size_t(1) << ChunkBits;
+	static constexpr std::size_t chunkMask = chunkSize - 1;
+
+	struct Slot {
+		alignas(Hot) unsigned char bytes[sizeof(Hot)];
+	};
+
+	std::vector<Slot*> hotChunks;
+	std::vector<Cold*> coldChunks;
+	std::vector<PoolIndex> freeIndices;
+	PoolIndex nextIndex = 1;
+};
+
+#endif
@@ -1,192 +1,148 @@
 #include "Limit.hpp"
 #include "Order.hpp"
 #include <iostream>
+#include <new>
 
-Limit::Limit(int _limitPrice, bool _buyOrSell, int _size, int _totalVolume) {
+template <typename Price, typename Quantity, typename Allocator>
+BasicLimit<Price, Quantity, Allocator>::BasicLimit(PoolIndex _index, Price _limitPrice) {
+	totalVolume = 0;
 	limitPrice = _limitPrice;
-	size = _size;
-	totalVolume = _totalVolume;
-	buyOrSell = _buyOrSell;
-	parent = nullptr;
-	leftChild = nullptr;
-	rightChild = nullptr;
-	headOrder = nullptr;
-	tailOrder = nullptr;
-}
-
-Limit::~Limit() {
-	if (parent != nullptr) {
-		bool leftOrRightChild = (limitPrice < parent->getLimitPrice());
-
-		// Node with only 1 child or no child
-		if (leftChild == nullptr) {
-			if (leftOrRightChild) {
-				parent->leftChild = rightChild;
-			}
-			else {
-				parent->rightChild = rightChild;
-			}
-			if (rightChild != nullptr) {
-				rightChild->setParent(parent);
-			}
-			return;
-		}
-		else if (rightChild == nullptr) {
-			if (leftOrRightChild) {
-				parent->leftChild = leftChild;
-			}
-			else {
-				parent->rightChild = leftChild;
-			}
-			leftChild->setParent(parent);
-			return;
-		}
-
-		// Node with 2 children
-		Limit* temp = rightChild;
-
-		while (temp->getLeftChild() != nullptr) {
-			temp = temp->getLeftChild();
-		}
-
-		if (rightChild->getLeftChild() != nullptr) {
-			temp->getParent()->setLeftChild(temp->getRightChild());
-			if (temp->getRightChild() != nullptr) {
-				temp->getRightChild()->setParent(temp->getParent());
-			}
-			temp->setRightChild(rightChild);
-			rightChild->setParent(temp);
-		}
-		temp->setParent(parent);
-		temp->setLeftChild(leftChild);
-		leftChild->setParent(temp);
-		if (leftOrRightChild) {
-			parent->leftChild = temp;
-		}
-		else {
-			parent->rightChild = temp;
-		}
-	}
-	else {
-		// Node with 1 child or no child
-		if (leftChild == nullptr && rightChild == nullptr) {
-			return;
-		}
-		else if (leftChild == nullptr) {
-			rightChild->setParent(nullptr);
-			return;
-		}
-		else if (rightChild == nullptr) {
-			leftChild->setParent(nullptr);
-			return;
-		}
-
-		// Node with 2 children
-		Limit* temp = rightChild;
-		while (temp->getLeftChild() != nullptr) {
-			temp = temp->getLeftChild();
-		}
-		if (rightChild->getLeftChild() != nullptr) {
-			temp->getParent()->setLeftChild(temp->getRightChild());
-			if (temp->getRightChild() != nullptr) {
-				temp->getRightChild()->setParent(temp->getParent());
-			}
-			temp->setRightChild(rightChild);
-			rightChild->setParent(temp);
-		}
-		temp->setParent(nullptr);
-		temp->setLeftChild(leftChild);
-		leftChild->setParent(temp);
-	}
+	size = 0;
+	index = _index;
+	headOrder = nullIndex;
+	tailOrder = nullIndex;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+BasicLimit<Price, Quantity, Allocator>* BasicLimit<Price, Quantity, Allocator>::create(Pools& pools, Price limitPrice, bool buyOrSell) {
+	PoolIndex index = pools.limits.allocate();
+	pools.limits.cold(index) = Cold{ buyOrSell, nullIndex, nullIndex, nullIndex, 0 };
+	return new (pools.limits.storage(index)) Limit(index, limitPrice);
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::destroy(Pools& pools, Limit* limit) {
+	pools.limits.deallocate(limit->index);
 }
 
-Order *Limit::getHeadOrder() const {
-	return headOrder;
+template <typename Price, typename Quantity, typename Allocator>
+BasicOrder<Price, Quantity, Allocator>* BasicLimit<Price, Quantity, Allocator>::getHeadOrder(const Pools& pools) const {
+	return pools.orders.get(headOrder);
 }
 
-int Limit::getLimitPrice() const {
+template <typename Price, typename Quantity, typename Allocator>
+Price BasicLimit<Price, Quantity, Allocator>::getLimitPrice() const {
 	return limitPrice;
 }
 
-int Limit::getSize() const {
+template <typename Price, typename Quantity, typename Allocator>
+int BasicLimit<Price, Quantity, Allocator>::getSize() const {
 	return size;
 }
 
-int Limit::getTotalVolume() const {
+template <typename Price, typename Quantity, typename Allocator>
+Quantity BasicLimit<Price, Quantity, Allocator>::getTotalVolume() const {
 	return totalVolume;
 }
 
-bool Limit::getBuyOrSell() const {
-	return buyOrSell;
+template <typename Price, typename Quantity, typename Allocator>
+Quantity BasicLimit<Price, Quantity, Allocator>::getHiddenVolume(const Pools& pools) const {
+	return pools.limits.cold(index).hiddenVolume;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+bool BasicLimit<Price, Quantity, Allocator>::getBuyOrSell(const Pools& pools) const {
+	return pools.limits.cold(index).buyOrSell;
 }
 
-Limit *Limit::getParent() const {
-	return parent;
+template <typename Price, typename Quantity, typename Allocator>
+BasicLimit<Price, Quantity, Allocator>* BasicLimit<Price, Quantity, Allocator>::getParent(const Pools& pools) const {
+	return pools.limits.get(pools.limits.cold(index).parent);
 }
 
-Limit *Limit::getLeftChild() const {
-	return leftChild;
+template <typename Price, typename Quantity, typename Allocator>
+BasicLimit<Price, Quantity, Allocator>* BasicLimit<Price, Quantity, Allocator>::getLeftChild(const Pools& pools) const {
+	return pools.limits.get(pools.limits.cold(index).leftChild);
 }
 
-Limit *Limit::getRightChild() const {
-	return rightChild;
+template <typename Price, typename Quantity, typename Allocator>
+BasicLimit<Price, Quantity, Allocator>* BasicLimit<Price, Quantity, Allocator>::getRightChild(const Pools& pools) const {
+	return pools.limits.get(pools.limits.cold(index).rightChild);
 }
 
-void Limit::setParent(Limit* newParent) {
-	parent = newParent;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::setParent(Pools& pools, Limit* newParent) {
+	pools.limits.cold(index).parent = newParent != nullptr ? newParent->index : nullIndex;
 }
 
-void Limit::setLeftChild(Limit* newLeftChild) {
-	leftChild = newLeftChild;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::setLeftChild(Pools& pools, Limit* newLeftChild) {
+	pools.limits.cold(index).leftChild = newLeftChild != nullptr ? newLeftChild->index : nullIndex;
 }
 
-void Limit::setRightChild(Limit* newRightChild) {
-	rightChild = newRightChild;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::setRightChild(Pools& pools, Limit* newRightChild) {
+	pools.limits.cold(index).rightChild = newRightChild != nullptr ? newRightChild->index : nullIndex;
 }
 
-void Limit::partiallyFillTotalVolume(int orderedShares) {
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::partiallyFillTotalVolume(Quantity orderedShares) {
 	totalVolume -= orderedShares;
 }
 
-void Limit::addOrder(Order* order) {
-	if (headOrder == nullptr) {
-		headOrder = order;
-		tailOrder = order;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::addOrder(Pools& pools, Order* order) {
+	if (headOrder == nullIndex) {
+		headOrder = order->index;
+		tailOrder = order->index;
 	}
 	else {
-		tailOrder->nextOrder = order;
+		pools.orders.at(tailOrder)->nextOrder = order->index;
 		order->prevOrder = tailOrder;
-		order->nextOrder = nullptr;
-		tailOrder = order;
+		order->nextOrder = nullIndex;
+		tailOrder = order->index;
 	}
 	size++;
-	totalVolume += order->getShares();
-	order->parentLimit = this;
+	totalVolume += order->shares;
+	if (order->iceberg) {
+		pools.limits.cold(index).hiddenVolume += pools.orders.cold(order->index).hiddenShares;
+	}
+	order->parentLimit = index;
 }
 
-void Limit::printForward() const
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::printForward(const Pools& pools) const
 {
-	Order* current = headOrder;
+	Order* current = pools.orders.get(headOrder);
 	while (current != nullptr) {
-		std::cout << current->getOrderId() << " ";
-		current = current->nextOrder;
+		std::cout << current->getOrderId(pools) << " ";
+		current = pools.orders.get(current->nextOrder);
 	}
 	std::cout << std::endl;
 }
 
-void Limit::printBackward() const
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::printBackward(const Pools& pools) const
 {
-	Order* current = tailOrder;
+	Order* current = pools.orders.get(tailOrder);
 	while (current != nullptr) {
-		std::cout << current->getOrderId() << " ";
-		current = current->prevOrder;
+		std::cout << current->getOrderId(pools) << " ";
+		current = pools.orders.get(current->prevOrder);
 	}
 	std::cout << std::endl;
 }
 
-void Limit::print() const
+template <typename Price, typename Quantity, typename Allocator>
+void BasicLimit<Price, Quantity, Allocator>::print() const
 {
 	std::cout << "Limit Price: " << limitPrice << std::endl;
 	std::cout << "Limit Size: " << size << std::endl;
 	std::cout << "Limit Volume: " << totalVolume << std::endl;
-}
\ No newline at end of file
+}
+
+// Limit types of the shipped book configurations and of the other allocators over the default one
+template class BasicLimit<std::int32_t, std::int64_t, IndexPoolAllocator>;
+template class BasicLimit<std::int32_t, std::int32_t, IndexPoolAllocator>;
+template class BasicLimit<std::int64_t, std::int64_t, IndexPoolAllocator>;
+template class BasicLimit<std::int32_t, std::int64_t, HeapAllocator>;
+template class BasicLimit<std::int32_t, std::int64_t, PoolAllocator>;
\ No newline at end of file
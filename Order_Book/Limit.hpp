@@ -1,42 +1,61 @@
 #ifndef LIMIT_HPP
 #define LIMIT_HPP
 
-class Order;
+#include "BookConfig.hpp"
 
-class Limit {
+// Price levels live in the pools of their book like orders, see BasicOrder
+template <typename Price, typename Quantity, typename Allocator>
+class BasicLimit {
 private:
-	int limitPrice;    // Price level
-	int size;         // Number of orders at this price
-	int totalVolume;  // Total shares at this price
-	bool buyOrSell;
-	Limit* parent;
-	Limit* leftChild;
-	Limit* rightChild;
-	Order* headOrder; // Linked list of orders at this price
-	Order* tailOrder;
-
-	friend class Order;
+	using Order = BasicOrder<Price, Quantity, Allocator>;
+	using Limit = BasicLimit<Price, Quantity, Allocator>;
 
 public:
-	Limit(int limitPrice, bool buyOrSell, int size = 0, int totalVolume = 0);
-	~Limit();
+	using Pools = BookPools<Order, Limit, Allocator>;
 
-	Order *getHeadOrder() const;
-	int getLimitPrice() const;
+	// Fields only read when the level is added, removed or walked by its price index
+	struct Cold {
+		bool buyOrSell;
+		PoolIndex parent;
+		PoolIndex leftChild;
+		PoolIndex rightChild;
+		Quantity hiddenVolume;  // Iceberg reserve of the orders at this price
+	};
+
+private:
+	// Fields touched while matching, linked by indices into the order and limit pools
+	Quantity totalVolume;  // Total shares at this price
+	Price limitPrice;      // Price level
+	int size;              // Number of orders at this price
+	PoolIndex index;
+	PoolIndex headOrder;   // Linked list of orders at this price
+	PoolIndex tailOrder;
+
+	BasicLimit(PoolIndex _index, Price _limitPrice);
+
+	friend class BasicOrder<Price, Quantity, Allocator>;
+
+public:
+	static Limit* create(Pools& pools, Price limitPrice, bool buyOrSell);
+	static void destroy(Pools& pools, Limit* limit);
+
+	Order *getHeadOrder(const Pools& pools) const;
+	Price getLimitPrice() const;
 	int getSize() const;
-	int getTotalVolume() const;
-	bool getBuyOrSell() const;
-	Limit *getParent() const;
-	Limit *getLeftChild() const;
-	Limit *getRightChild() const;
-	void setParent(Limit* newParent);
-	void setLeftChild(Limit* newLeftChild);
-	void setRightChild(Limit* newRightChild);
-	void partiallyFillTotalVolume(int orderedShares);
-
-	void addOrder(Order* _order);
-	void printForward() const;
-	void printBackward() const;
+	Quantity getTotalVolume() const;
+	Quantity getHiddenVolume(const Pools& pools) const;
+	bool getBuyOrSell(const Pools& pools) const;
+	Limit *getParent(const Pools& pools) const;
+	Limit *getLeftChild(const Pools& pools) const;
+	Limit *getRightChild(const Pools& pools) const;
+	void setParent(Pools& pools, Limit* newParent);
+	void setLeftChild(Pools& pools, Limit* newLeftChild);
+	void setRightChild(Pools& pools, Limit* newRightChild);
+	void partiallyFillTotalVolume(Quantity orderedShares);
+
+	void addOrder(Pools& pools, Order* _order);
+	void printForward(const Pools& pools) const;
+	void printBackward(const Pools& pools) const;
 	void print() const;
 };
 
@@ -0,0 +1,56 @@
+#ifndef LIVE_ORDERS_HPP
+#define LIVE_ORDERS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Orders resting in a book, kept densely per kind so generators can pick a uniformly
+// random live order in constant time. Every order remembers its slot, the position in
+// its vector shifted left by 2 with the kind in the low bits, so erasing swaps the last
+// order of the same kind into the hole without a search.
+template <typename Order>
+class LiveOrders {
+public:
+	using Pools = typename Order::Pools;
+
+	// Kinds match the keys of Book::getRandomOrder
+	static constexpr int limitKind = 0;
+	static constexpr int stopKind = 1;
+	static constexpr int stopLimitKind = 2;
+
+	void insert(Pools& pools, Order* order, int kind) {
+		std::vector<Order*>& kindOrders = orders[kind];
+		order->setLiveSlot(pools, static_cast<std::uint32_t>(kindOrders.size() << 2 | kind));
+		kindOrders.push_back(order);
+	}
+
+	void erase(Pools& pools, Order* order) {
+		std::uint32_t slot = order->getLiveSlot(pools);
+		std::vector<Order*>& kindOrders = orders[slot & 3];
+		Order* last = kindOrders.back();
+		kindOrders[slot >> 2] = last;
+		last->setLiveSlot(pools, slot);
+		kindOrders.pop_back();
+	}
+
+	// Kind of an order which is in the set
+	static int kindOf(const Pools& pools, const Order* order) {
+		return static_cast<int>(order->getLiveSlot(pools) & 3);
+	}
+
+	std::size_t size(int kind) const {
+		return orders[kind].size();
+	}
+
+	Order* sample(int kind, std::mt19937& gen) const {
+		std::uniform_int_distribution<std::size_t> positionDist(0, orders[kind].size() - 1);
+		return orders[kind][positionDist(gen)];
+	}
+
+private:
+	std::vector<Order*> orders[3];
+};
+
+#endif
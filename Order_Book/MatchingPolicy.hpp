@@ -0,0 +1,96 @@
+#ifndef MATCHING_POLICY_HPP
+#define MATCHING_POLICY_HPP
+
+#include <cstdint>
+
+// Allocation policies deciding how an incoming order is shared between the
+// resting orders of a price level. Selected at compile time through BookConfig.
+
+// Price-time priority, the head order of a level is always filled first.
+// The book keeps its original matching loop for this policy.
+struct FifoMatching {
+	static constexpr bool fifo = true;
+
+	template <typename Quantity>
+	static void allocate(const Quantity* restingShares, Quantity* fills, int count, Quantity incomingShares) {
+		for (int i = 0; i < count; i++) {
+			fills[i] = incomingShares < restingShares[i] ? incomingShares : restingShares[i];
+			incomingShares -= fills[i];
+		}
+	}
+};
+
+// Every resting order gets a share proportional to its size, rounding
+// leftovers are handed out one share at a time in time priority
+struct ProRataMatching {
+	static constexpr bool fifo = false;
+
+	// Fill fills[0..count) from restingShares[0..count) for incomingShares,
+	// incomingShares must not exceed the total resting volume
+	template <typename Quantity>
+	static void allocate(const Quantity* restingShares, Quantity* fills, int count, Quantity incomingShares) {
+		std::int64_t totalShares = 0;
+		for (int i = 0; i < count; i++) {
+			totalShares += restingShares[i];
+		}
+		if (count == 0 || totalShares == 0) {
+			return;
+		}
+
+		// Floating point estimate of each floor(resting * incoming / total). The estimate is corrected
+		// to be exact whenever the products fit in 64 bits, which holds for any realistic level
+		const double ratio = static_cast<double>(incomingShares) / static_cast<double>(totalShares);
+		const bool exactFits = totalShares <= INT64_MAX / (static_cast<std::int64_t>(incomingShares) + 2);
+		std::int64_t allocated = 0;
+		for (int i = 0; i < count; i++) {
+			std::int64_t fill = static_cast<std::int64_t>(restingShares[i] * ratio);
+			if (exactFits) {
+				const std::int64_t exact = static_cast<std::int64_t>(restingShares[i]) * incomingShares;
+				fill += (fill + 1) * totalShares <= exact;
+				fill -= fill * totalShares > exact;
+			}
+			else {
+				fill = fill < restingShares[i] ? fill : restingShares[i];
+			}
+			fills[i] = static_cast<Quantity>(fill);
+			allocated += fill;
+		}
+
+		// Rounding leftovers go to the oldest orders which aren't completely filled,
+		// an estimate rounded up too far is taken back from the newest orders
+		std::int64_t leftover = incomingShares - allocated;
+		while (leftover > 0) {
+			for (int i = 0; leftover > 0 && i < count; i++) {
+				if (fills[i] < restingShares[i]) {
+					fills[i]++;
+					leftover--;
+				}
+			}
+		}
+		while (leftover < 0) {
+			for (int i = count - 1; leftover < 0 && i >= 0; i--) {
+				if (fills[i] > 0) {
+					fills[i]--;
+					leftover++;
+				}
+			}
+		}
+	}
+};
+
+// The head order of a level gets priority up to its full size and the rest
+// of the incoming order is allocated pro-rata among the remaining orders
+struct FifoProRataMatching {
+	static constexpr bool fifo = false;
+
+	template <typename Quantity>
+	static void allocate(const Quantity* restingShares, Quantity* fills, int count, Quantity incomingShares) {
+		if (count == 0) {
+			return;
+		}
+		fills[0] = incomingShares < restingShares[0] ? incomingShares : restingShares[0];
+		ProRataMatching::allocate(restingShares + 1, fills + 1, count - 1, incomingShares - fills[0]);
+	}
+};
+
+#endif
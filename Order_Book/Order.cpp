@@ -1,103 +1,216 @@
 #include "Order.hpp"
 #include "Limit.hpp"
+#include "OrderTypes.hpp"
 #include <iostream>
+#include <new>
 
-Order::Order(int _orderId, bool _buyOrSell, int _shares, int _limit, int _entryTime, int _eventTime) {
-	orderId = _orderId;
-	buyOrSell = _buyOrSell;
+template <typename Price, typename Quantity, typename Allocator>
+BasicOrder<Price, Quantity, Allocator>::BasicOrder(PoolIndex _index, Quantity _shares) {
 	shares = _shares;
-	limit = _limit;
-	entryTime = _entryTime;
-	eventTime = _eventTime;
-	nextOrder = nullptr;
-	prevOrder = nullptr;
-	parentLimit = nullptr;
+	index = _index;
+	iceberg = 0;
+	nextOrder = nullIndex;
+	prevOrder = nullIndex;
+	parentLimit = nullIndex;
 }
 
-int Order::getOrderId() const {
-	return orderId;
+template <typename Price, typename Quantity, typename Allocator>
+BasicOrder<Price, Quantity, Allocator>* BasicOrder<Price, Quantity, Allocator>::create(Pools& pools, int orderId, bool buyOrSell, Quantity shares, Price limit, int entryTime, int eventTime) {
+	PoolIndex index = pools.orders.allocate();
+	pools.orders.cold(index) = Cold{ orderId, buyOrSell, 0, 0, limit, noOwner, entryTime, eventTime, 0 };
+	return new (pools.orders.storage(index)) Order(index, shares);
 }
 
-int Order::getShares() const {
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::destroy(Pools& pools, Order* order) {
+	pools.orders.deallocate(order->index);
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+int BasicOrder<Price, Quantity, Allocator>::getOrderId(const Pools& pools) const {
+	return pools.orders.cold(index).orderId;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+Quantity BasicOrder<Price, Quantity, Allocator>::getShares() const {
 	return shares;
 }
 
-bool Order::getBuyOrSell() const {
-	return buyOrSell;
+template <typename Price, typename Quantity, typename Allocator>
+bool BasicOrder<Price, Quantity, Allocator>::isIceberg() const {
+	return iceberg != 0;
 }
 
-int Order::getLimit() const {
-	return limit;
+template <typename Price, typename Quantity, typename Allocator>
+Quantity BasicOrder<Price, Quantity, Allocator>::getPeakShares(const Pools& pools) const {
+	return pools.orders.cold(index).peakShares;
 }
 
-int Order::getEntryTime() const {
-	return entryTime;
+template <typename Price, typename Quantity, typename Allocator>
+Quantity BasicOrder<Price, Quantity, Allocator>::getHiddenShares(const Pools& pools) const {
+	return pools.orders.cold(index).hiddenShares;
 }
 
-int Order::getEventTime() const {
-	return eventTime;
+template <typename Price, typename Quantity, typename Allocator>
+bool BasicOrder<Price, Quantity, Allocator>::getBuyOrSell(const Pools& pools) const {
+	return pools.orders.cold(index).buyOrSell;
 }
 
-Limit* Order::getParentLimit() const {
-	return parentLimit;
+template <typename Price, typename Quantity, typename Allocator>
+Price BasicOrder<Price, Quantity, Allocator>::getLimit(const Pools& pools) const {
+	return pools.orders.cold(index).limit;
 }
 
-void Order::partiallyFillOrder(int orderedShares) {
+template <typename Price, typename Quantity, typename Allocator>
+int BasicOrder<Price, Quantity, Allocator>::getOwnerId(const Pools& pools) const {
+	return pools.orders.cold(index).ownerId;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+int BasicOrder<Price, Quantity, Allocator>::getEntryTime(const Pools& pools) const {
+	return pools.orders.cold(index).entryTime;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+int BasicOrder<Price, Quantity, Allocator>::getEventTime(const Pools& pools) const {
+	return pools.orders.cold(index).eventTime;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+BasicLimit<Price, Quantity, Allocator>* BasicOrder<Price, Quantity, Allocator>::getParentLimit(const Pools& pools) const {
+	return pools.limits.get(parentLimit);
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+BasicOrder<Price, Quantity, Allocator>* BasicOrder<Price, Quantity, Allocator>::getNextOrder(const Pools& pools) const {
+	return pools.orders.get(nextOrder);
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+std::uint32_t BasicOrder<Price, Quantity, Allocator>::getLiveSlot(const Pools& pools) const {
+	return pools.orders.cold(index).liveSlot;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::partiallyFillOrder(Pools& pools, Quantity orderedShares) {
 	shares -= orderedShares;
-	parentLimit->partiallyFillTotalVolume(orderedShares);
+	pools.limits.at(parentLimit)->partiallyFillTotalVolume(orderedShares);
 }
 
-void Order::cancel() {
-	if (prevOrder == nullptr) {
-		parentLimit->headOrder = nextOrder;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::cancel(Pools& pools) {
+	Limit* limit = pools.limits.at(parentLimit);
+	if (prevOrder == nullIndex) {
+		limit->headOrder = nextOrder;
 	}
 	else {
-		prevOrder->nextOrder = nextOrder;
+		pools.orders.at(prevOrder)->nextOrder = nextOrder;
 	}
-	if (nextOrder == nullptr) {
-		parentLimit->tailOrder = prevOrder;
+	if (nextOrder == nullIndex) {
+		limit->tailOrder = prevOrder;
 	}
 	else {
-		nextOrder->prevOrder = prevOrder;
+		pools.orders.at(nextOrder)->prevOrder = prevOrder;
 	}
 
-	parentLimit->totalVolume -= shares;
-	parentLimit->size--;
+	limit->totalVolume -= shares;
+	limit->size--;
+	if (iceberg) {
+		pools.limits.cold(parentLimit).hiddenVolume -= pools.orders.cold(index).hiddenShares;
+	}
 }
 
-void Order::execute() {
-	parentLimit->headOrder = nextOrder;
-	if (nextOrder == nullptr) {
-		parentLimit->tailOrder = nullptr;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::execute(Pools& pools) {
+	Limit* limit = pools.limits.at(parentLimit);
+	limit->headOrder = nextOrder;
+	if (nextOrder == nullIndex) {
+		limit->tailOrder = nullIndex;
 	}
 	else {
-		nextOrder->prevOrder = nullptr;
+		pools.orders.at(nextOrder)->prevOrder = nullIndex;
 	}
-	nextOrder = nullptr;
-	prevOrder = nullptr;
+	nextOrder = nullIndex;
+	prevOrder = nullIndex;
 
-	parentLimit->totalVolume -= shares;
-	parentLimit->size--;
+	limit->totalVolume -= shares;
+	limit->size--;
+	if (iceberg) {
+		pools.limits.cold(parentLimit).hiddenVolume -= pools.orders.cold(index).hiddenShares;
+	}
 }
 
-void Order::modifyOrder(int newShares, int newLimit) {
-	shares = newShares;
-	limit = newLimit;
-	nextOrder = nullptr;
-	prevOrder = nullptr;
-	parentLimit = nullptr;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::modifyOrder(Pools& pools, Quantity newShares, Price newLimit) {
+	Cold& coldFields = pools.orders.cold(index);
+	if (coldFields.peakShares != 0) {
+		// Iceberg orders are modified by their total size and split again
+		shares = newShares < coldFields.peakShares ? newShares : coldFields.peakShares;
+		coldFields.hiddenShares = newShares - shares;
+	}
+	else {
+		shares = newShares;
+	}
+	coldFields.limit = newLimit;
+	nextOrder = nullIndex;
+	prevOrder = nullIndex;
+	parentLimit = nullIndex;
 }
 
-void Order::setShares(int newShares) {
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::setShares(Quantity newShares) {
 	shares = newShares;
 }
 
-void Order::print() const {
-	std::cout << "Order ID: " << orderId << std::endl;
-	std::cout << "Order Type: " << (buyOrSell == 1 ? "buy" : "sell") << std::endl;
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::setIceberg(Pools& pools, Quantity newPeakShares, Quantity newHiddenShares) {
+	Cold& coldFields = pools.orders.cold(index);
+	coldFields.peakShares = newPeakShares;
+	coldFields.hiddenShares = newHiddenShares;
+	iceberg = newPeakShares != 0;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::setOwnerId(Pools& pools, int newOwnerId) {
+	pools.orders.cold(index).ownerId = newOwnerId;
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::setLiveSlot(Pools& pools, std::uint32_t newLiveSlot) {
+	pools.orders.cold(index).liveSlot = newLiveSlot;
+}
+
+// Replenish the displayed shares of an iceberg order from its reserve and move it
+// to the back of the queue of its limit, losing its time priority
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::replenish(Pools& pools) {
+	Limit* limit = pools.limits.at(parentLimit);
+	cancel(pools);
+
+	Cold& coldFields = pools.orders.cold(index);
+	shares = coldFields.hiddenShares < coldFields.peakShares ? coldFields.hiddenShares : coldFields.peakShares;
+	coldFields.hiddenShares -= shares;
+	limit->addOrder(pools, this);
+}
+
+template <typename Price, typename Quantity, typename Allocator>
+void BasicOrder<Price, Quantity, Allocator>::print(const Pools& pools) const {
+	const Cold& coldFields = pools.orders.cold(index);
+	std::cout << "Order ID: " << coldFields.orderId << std::endl;
+	std::cout << "Order Type: " << (coldFields.buyOrSell == 1 ? "buy" : "sell") << std::endl;
 	std::cout << "Shares: " << shares << std::endl;
-	std::cout << "Limit: " << limit << std::endl;
-	std::cout << "Entry Time: " << entryTime << std::endl;
-	std::cout << "Event Time: " << eventTime << std::endl;
+	if (coldFields.peakShares != 0) {
+		std::cout << "Hidden Shares: " << coldFields.hiddenShares << std::endl;
+	}
+	std::cout << "Limit: " << coldFields.limit << std::endl;
+	std::cout << "Entry Time: " << coldFields.entryTime << std::endl;
+	std::cout << "Event Time: " << coldFields.eventTime << std::endl;
 	std::cout << std::endl;
-}
\ No newline at end of file
+}
+
+// Order types of the shipped book configurations and of the other allocators over the default one
+template class BasicOrder<std::int32_t, std::int64_t, IndexPoolAllocator>;
+template class BasicOrder<std::int32_t, std::int32_t, IndexPoolAllocator>;
+template class BasicOrder<std::int64_t, std::int64_t, IndexPoolAllocator>;
+template class BasicOrder<std::int32_t, std::int64_t, HeapAllocator>;
+template class BasicOrder<std::int32_t, std::int64_t, PoolAllocator>;
\ No newline at end of file
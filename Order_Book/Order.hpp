@@ -1,41 +1,74 @@
 #ifndef ORDER_HPP
 #define ORDER_HPP
 
-class Limit;
+#include "BookConfig.hpp"
 
-class Order {
+// Orders live in the pools of their book and link to other orders and levels by index,
+// so everything past the hot fields is reached through those pools
+template <typename Price, typename Quantity, typename Allocator>
+class BasicOrder {
 private:
-	int orderId;
-	bool buyOrSell;
-	int shares;
-	int limit;
-	int entryTime;
-	int eventTime;
-	Order* nextOrder;
-	Order* prevOrder;
+	using Order = BasicOrder<Price, Quantity, Allocator>;
+	using Limit = BasicLimit<Price, Quantity, Allocator>;
 
-	Limit* parentLimit;
+public:
+	using Pools = BookPools<Order, Limit, Allocator>;
+
+	// Fields only read when an order is added, cancelled or completely filled
+	struct Cold {
+		int orderId;
+		bool buyOrSell;
+		Quantity peakShares;    // Displayed size an iceberg order is replenished to, 0 if not an iceberg
+		Quantity hiddenShares;  // Iceberg reserve not visible in the book
+		Price limit;
+		int ownerId;
+		int entryTime;
+		int eventTime;
+		std::uint32_t liveSlot;  // Slot in the live orders of the book, see LiveOrders
+	};
+
+private:
+	// Fields touched while matching, linked by indices into the order and limit pools
+	Quantity shares;        // Displayed shares
+	PoolIndex index : 31;   // A book holds fewer than 2^31 orders
+	PoolIndex iceberg : 1;  // Set with a peak size, so fills only read the reserve of iceberg orders
+	PoolIndex nextOrder;
+	PoolIndex prevOrder;
+	PoolIndex parentLimit;
 
-	friend class Limit;
+	BasicOrder(PoolIndex _index, Quantity _shares);
+
+	friend class BasicLimit<Price, Quantity, Allocator>;
 
 public:
-	Order(int _orderId, bool _buyOrSell, int _shares, int _limit, int _entryTime = 0, int _eventTime = 0);
-
-	int getOrderId() const;
-	int getShares() const;
-	bool getBuyOrSell() const;
-	int getLimit() const;
-	int getEntryTime() const;
-	int getEventTime() const;
-	Limit* getParentLimit() const;
-
-	void partiallyFillOrder(int orderedShares);
-	void cancel();
-	void execute();
-	void modifyOrder(int newShares, int newLimit);
-	void setShares(int newShares);
-
-	void print() const;
+	static Order* create(Pools& pools, int orderId, bool buyOrSell, Quantity shares, Price limit, int entryTime = 0, int eventTime = 0);
+	static void destroy(Pools& pools, Order* order);
+
+	int getOrderId(const Pools& pools) const;
+	Quantity getShares() const;
+	bool isIceberg() const;
+	Quantity getPeakShares(const Pools& pools) const;
+	Quantity getHiddenShares(const Pools& pools) const;
+	bool getBuyOrSell(const Pools& pools) const;
+	Price getLimit(const Pools& pools) const;
+	int getOwnerId(const Pools& pools) const;
+	int getEntryTime(const Pools& pools) const;
+	int getEventTime(const Pools& pools) const;
+	Limit* getParentLimit(const Pools& pools) const;
+	Order* getNextOrder(const Pools& pools) const;
+	std::uint32_t getLiveSlot(const Pools& pools) const;
+
+	void partiallyFillOrder(Pools& pools, Quantity orderedShares);
+	void cancel(Pools& pools);
+	void execute(Pools& pools);
+	void modifyOrder(Pools& pools, Quantity newShares, Price newLimit);
+	void setShares(Quantity newShares);
+	void setIceberg(Pools& pools, Quantity newPeakShares, Quantity newHiddenShares);
+	void setOwnerId(Pools& pools, int newOwnerId);
+	void setLiveSlot(Pools& pools, std::uint32_t newLiveSlot);
+	void replenish(Pools& pools);
+
+	void print(const Pools& pools) const;
 };
 
-#endif
\ No newline at end of file
+#endif
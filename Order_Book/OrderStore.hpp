@@ -0,0 +1,202 @@
+#ifndef ORDER_STORE_HPP
+#define ORDER_STORE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Order store policies map order ids to the resting orders of the book.
+// Selected at compile time through BookConfig.
+
+// Node based std::unordered_map, the original store of the book
+struct UnorderedMapOrderStore {
+	template <typename Order>
+	class Store {
+	public:
+		Order* find(int orderId) const {
+			auto it = orders.find(orderId);
+			return it != orders.end() ? it->second : nullptr;
+		}
+
+		bool insert(int orderId, Order* order) {
+			return orders.emplace(orderId, order).second;
+		}
+
+		void erase(int orderId) {
+			orders.erase(orderId);
+		}
+
+		template <typename Visitor>
+		void forEach(Visitor visit) const {
+			for (auto& [orderId, order] : orders) {
+				visit(order);
+			}
+		}
+
+		void clear() {
+			orders.clear();
+		}
+
+	private:
+		std::unordered_map<int, Order*> orders;
+	};
+};
+
+// Open addressing with linear probing over a power of two table. Erasing shifts the
+// following entries back instead of leaving tombstones, so lookups stay short under churn.
+struct FlatHashOrderStore {
+	template <typename Order>
+	class Store {
+	public:
+		Store() : entries(initialCapacity), mask(initialCapacity - 1), size(0) {}
+
+		Order* find(int orderId) const {
+			for (std::size_t slot = home(orderId); entries[slot].order != nullptr; slot = (slot + 1) & mask) {
+				if (entries[slot].orderId == orderId) {
+					return entries[slot].order;
+				}
+			}
+			return nullptr;
+		}
+
+		bool insert(int orderId, Order* order) {
+			if ((size + 1) * 2 > entries.size()) {
+				grow();
+			}
+			std::size_t slot = home(orderId);
+			for (; entries[slot].order != nullptr; slot = (slot + 1) & mask) {
+				if (entries[slot].orderId == orderId) {
+					return false;
+				}
+			}
+			entries[slot] = { orderId, order };
+			size++;
+			return true;
+		}
+
+		void erase(int orderId) {
+			std::size_t slot = home(orderId);
+			for (; entries[slot].order != nullptr; slot = (slot + 1) & mask) {
+				if (entries[slot].orderId == orderId) {
+					break;
+				}
+			}
+			if (entries[slot].order == nullptr) {
+				return;
+			}
+
+			// Move back every following entry whose probe sequence passes the emptied slot
+			std::size_t next = slot;
+			while (true) {
+				next = (next + 1) & mask;
+				if (entries[next].order == nullptr) {
+					break;
+				}
+				if (((next - home(entries[next].orderId)) & mask) >= ((next - slot) & mask)) {
+					entries[slot] = entries[next];
+					slot = next;
+				}
+			}
+			entries[slot].order = nullptr;
+			size--;
+		}
+
+		template <typename Visitor>
+		void forEach(Visitor visit) const {
+			for (const Entry& entry : entries) {
+				if (entry.order != nullptr) {
+					visit(entry.order);
+				}
+			}
+		}
+
+		void clear() {
+			entries.assign(entries.size(), Entry{});
+			size = 0;
+		}
+
+	private:
+		struct Entry {
+			int orderId = 0;
+			Order* order = nullptr;
+		};
+
+		static constexpr std::size_t initialCapacity = 1024;
+
+		std::vector<Entry> entries;
+		std::size_t mask;
+		std::size_t size;
+
+		// Fibonacci hashing spreads sequential order ids over the table
+		std::size_t home(int orderId) const {
+			std::uint64_t hash = static_cast<std::uint32_t>(orderId) * 0x9E3779B97F4A7C15ull;
+			return static_cast<std::size_t>(hash >> 32) & mask;
+		}
+
+		void grow() {
+			std::vector<Entry> oldEntries(entries.size() * 2);
+			oldEntries.swap(entries);
+			mask = entries.size() - 1;
+			for (const Entry& entry : oldEntries) {
+				if (entry.order != nullptr) {
+					std::size_t slot = home(entry.orderId);
+					while (entries[slot].order != nullptr) {
+						slot = (slot + 1) & mask;
+					}
+					entries[slot] = entry;
+				}
+			}
+		}
+	};
+};
+
+// Orders indexed directly by id, for feeds which hand out dense non negative order ids
+struct DenseVectorOrderStore {
+	template <typename Order>
+	class Store {
+	public:
+		Order* find(int orderId) const {
+			return static_cast<std::size_t>(orderId) < orders.size() ? orders[orderId] : nullptr;
+		}
+
+		bool insert(int orderId, Order* order) {
+			if (orderId < 0) {
+				return false;
+			}
+			if (static_cast<std::size_t>(orderId) >= orders.size()) {
+				orders.resize(std::max<std::size_t>(orderId + 1, orders.size() * 2), nullptr);
+			}
+			if (orders[orderId] != nullptr) {
+				return false;
+			}
+			orders[orderId] = order;
+			return true;
+		}
+
+		void erase(int orderId) {
+			if (static_cast<std::size_t>(orderId) < orders.size()) {
+				orders[orderId] = nullptr;
+			}
+		}
+
+		template <typename Visitor>
+		void forEach(Visitor visit) const {
+			for (Order* order : orders) {
+				if (order != nullptr) {
+					visit(order);
+				}
+			}
+		}
+
+		void clear() {
+			orders.clear();
+		}
+
+	private:
+		std::vector<Order*> orders;
+	};
+};
+
+#endif
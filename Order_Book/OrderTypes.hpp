@@ -0,0 +1,42 @@
+#ifndef ORDER_TYPES_HPP
+#define ORDER_TYPES_HPP
+
+// How long an incoming limit order is allowed to live
+enum class TimeInForce {
+	GoodTillCancel,     // Rest any remainder in the book
+	ImmediateOrCancel,  // Fill what is possible, drop the remainder
+	FillOrKill          // Fill completely or leave the book untouched
+};
+
+// What happens when an incoming order would trade with a resting order of the same owner
+enum class SelfTradePrevention {
+	None,           // Orders of the same owner trade with each other
+	CancelNewest,   // Cancel the remainder of the incoming order
+	CancelOldest,   // Cancel the resting order and keep matching
+	DecrementBoth   // Reduce both orders by the smaller size without trading
+};
+
+// Outcome of a book operation
+enum class OrderStatus {
+	Ok,                 // Applied to the book
+	NotFound,           // No resting order with this id, e.g. it was already filled
+	InvalidPrice,       // Price outside the configured range or off the tick grid
+	Killed,             // Fill or kill order which couldn't be filled completely
+	DuplicateId,        // Id of an order still resting in the book, rejected before the order trades
+	SelfTradeCancelled  // Self trade prevention cancelled cancelledShares of the order, the rest was applied
+};
+
+// Returned by every order operation of the book so upstream can reject or log without the book printing
+template <typename Quantity>
+struct BasicOrderResult {
+	OrderStatus status;
+	Quantity filledShares;     // Shares the order traded
+	Quantity remainingShares;  // Shares the order has left, in the book when resting
+	bool resting;
+	Quantity cancelledShares = 0;  // Shares dropped by self trade prevention without trading
+};
+
+// Owner ids are positive, orders without an owner never self trade
+constexpr int noOwner = 0;
+
+#endif
@@ -0,0 +1,353 @@
+#ifndef PRICE_INDEX_HPP
+#define PRICE_INDEX_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Price index policies keep the price levels of one side of the book ordered and
+// addressable by price. Selected at compile time through BookConfig. A side is created
+// with the pools of its book and the direction of its best price, the highest level for
+// buy limits and sell stops, the lowest level for sell limits and buy stops.
+
+// Self balancing AVL tree linked through the tree pointers of the levels,
+// with a slot per tick for lookups and the subtree heights kept next to the slots
+struct AVLPriceIndex {
+	template <typename Config, typename Limit>
+	class Side {
+	public:
+		using Price = typename Config::Price;
+		using Pools = typename Limit::Pools;
+
+		Side(Pools& _pools, bool _bestIsHighest, int& _rebalanceCount)
+			: pools(_pools), slots(Config::levelCount, nullptr), heights(Config::levelCount, 0), rootLimit(nullptr),
+			bestLimit(nullptr), bestIsHighest(_bestIsHighest), rebalanceCount(_rebalanceCount) {}
+
+		Limit* find(Price price) const {
+			return slots[Config::toTick(price)];
+		}
+
+		Limit* best() const {
+			return bestLimit;
+		}
+
+		Limit* root() const {
+			return rootLimit;
+		}
+
+		// Next level moving away from the best price
+		Limit* next(Limit* limit) const {
+			return successor(limit, !bestIsHighest);
+		}
+
+		// Visit every level in ascending price order
+		template <typename Visitor>
+		void forEach(Visitor visit) const {
+			for (Limit* limit : slots) {
+				if (limit != nullptr) {
+					visit(limit);
+				}
+			}
+		}
+
+		void insert(Limit* limit) {
+			Price price = limit->getLimitPrice();
+			slots[Config::toTick(price)] = limit;
+			height(limit) = 1;
+
+			if (rootLimit == nullptr) {
+				rootLimit = limit;
+				bestLimit = limit;
+				return;
+			}
+
+			Limit* parent = rootLimit;
+			Limit* child = price < parent->getLimitPrice() ? parent->getLeftChild(pools) : parent->getRightChild(pools);
+			while (child != nullptr) {
+				parent = child;
+				child = price < parent->getLimitPrice() ? parent->getLeftChild(pools) : parent->getRightChild(pools);
+			}
+			limit->setParent(pools, parent);
+			if (price < parent->getLimitPrice()) {
+				parent->setLeftChild(pools, limit);
+			}
+			else {
+				parent->setRightChild(pools, limit);
+			}
+
+			if (bestIsHighest ? price > bestLimit->getLimitPrice() : price < bestLimit->getLimitPrice()) {
+				bestLimit = limit;
+			}
+			retrace(parent);
+		}
+
+		// Unlink a level from the tree, the level itself is freed by the book
+		void erase(Limit* limit) {
+			if (limit == bestLimit) {
+				bestLimit = next(limit);
+			}
+			slots[Config::toTick(limit->getLimitPrice())] = nullptr;
+
+			Limit* parent = limit->getParent(pools);
+			Limit* leftChild = limit->getLeftChild(pools);
+			Limit* rightChild = limit->getRightChild(pools);
+			Limit* retraceFrom;
+
+			if (leftChild != nullptr && rightChild != nullptr) {
+				// Node with 2 children is replaced by its in order successor
+				Limit* successor = rightChild;
+				while (successor->getLeftChild(pools) != nullptr) {
+					successor = successor->getLeftChild(pools);
+				}
+				if (successor != rightChild) {
+					retraceFrom = successor->getParent(pools);
+					retraceFrom->setLeftChild(pools, successor->getRightChild(pools));
+					if (successor->getRightChild(pools) != nullptr) {
+						successor->getRightChild(pools)->setParent(pools, retraceFrom);
+					}
+					successor->setRightChild(pools, rightChild);
+					rightChild->setParent(pools, successor);
+				}
+				else {
+					retraceFrom = successor;
+				}
+				successor->setLeftChild(pools, leftChild);
+				leftChild->setParent(pools, successor);
+				replaceChild(parent, limit, successor);
+				height(successor) = height(limit);
+			}
+			else {
+				// Node with only 1 child or no child
+				replaceChild(parent, limit, leftChild != nullptr ? leftChild : rightChild);
+				retraceFrom = parent;
+			}
+
+			limit->setParent(pools, nullptr);
+			limit->setLeftChild(pools, nullptr);
+			limit->setRightChild(pools, nullptr);
+			retrace(retraceFrom);
+		}
+
+	private:
+		Pools& pools;
+		std::vector<Limit*> slots;
+		std::vector<std::int8_t> heights;
+		Limit* rootLimit;
+		Limit* bestLimit;
+		bool bestIsHighest;
+		int& rebalanceCount;
+
+		std::int8_t& height(Limit* limit) {
+			return heights[Config::toTick(limit->getLimitPrice())];
+		}
+
+		int heightOf(Limit* limit) const {
+			return limit == nullptr ? 0 : heights[Config::toTick(limit->getLimitPrice())];
+		}
+
+		int balanceFactor(Limit* limit) const {
+			return heightOf(limit->getLeftChild(pools)) - heightOf(limit->getRightChild(pools));
+		}
+
+		void updateHeight(Limit* limit) {
+			int leftHeight = heightOf(limit->getLeftChild(pools));
+			int rightHeight = heightOf(limit->getRightChild(pools));
+			height(limit) = static_cast<std::int8_t>((leftHeight > rightHeight ? leftHeight : rightHeight) + 1);
+		}
+
+		void replaceChild(Limit* parent, Limit* oldChild, Limit* newChild) {
+			if (newChild != nullptr) {
+				newChild->setParent(pools, parent);
+			}
+			if (parent == nullptr) {
+				rootLimit = newChild;
+			}
+			else if (parent->getLeftChild(pools) == oldChild) {
+				parent->setLeftChild(pools, newChild);
+			}
+			else {
+				parent->setRightChild(pools, newChild);
+			}
+		}
+
+		Limit* rotateLeft(Limit* limit) {
+			Limit* newParent = limit->getRightChild(pools);
+			limit->setRightChild(pools, newParent->getLeftChild(pools));
+			if (newParent->getLeftChild(pools) != nullptr) {
+				newParent->getLeftChild(pools)->setParent(pools, limit);
+			}
+			replaceChild(limit->getParent(pools), limit, newParent);
+			newParent->setLeftChild(pools, limit);
+			limit->setParent(pools, newParent);
+			updateHeight(limit);
+			updateHeight(newParent);
+			return newParent;
+		}
+
+		Limit* rotateRight(Limit* limit) {
+			Limit* newParent = limit->getLeftChild(pools);
+			limit->setLeftChild(pools, newParent->getRightChild(pools));
+			if (newParent->getRightChild(pools) != nullptr) {
+				newParent->getRightChild(pools)->setParent(pools, limit);
+			}
+			replaceChild(limit->getParent(pools), limit, newParent);
+			newParent->setRightChild(pools, limit);
+			limit->setParent(pools, newParent);
+			updateHeight(limit);
+			updateHeight(newParent);
+			return newParent;
+		}
+
+		// Restore the heights and balance from a changed node up to the root
+		void retrace(Limit* limit) {
+			while (limit != nullptr) {
+				updateHeight(limit);
+				int factor = balanceFactor(limit);
+				if (factor > 1) {
+					if (balanceFactor(limit->getLeftChild(pools)) < 0) {
+						rotateLeft(limit->getLeftChild(pools));
+					}
+					limit = rotateRight(limit);
+					rebalanceCount += 1;
+				}
+				else if (factor < -1) {
+					if (balanceFactor(limit->getRightChild(pools)) > 0) {
+						rotateRight(limit->getRightChild(pools));
+					}
+					limit = rotateLeft(limit);
+					rebalanceCount += 1;
+				}
+				limit = limit->getParent(pools);
+			}
+		}
+
+		// In order successor when ascending, in order predecessor otherwise
+		Limit* successor(Limit* limit, bool ascending) const {
+			Limit* child = ascending ? limit->getRightChild(pools) : limit->getLeftChild(pools);
+			if (child != nullptr) {
+				while ((ascending ? child->getLeftChild(pools) : child->getRightChild(pools)) != nullptr) {
+					child = ascending ? child->getLeftChild(pools) : child->getRightChild(pools);
+				}
+				return child;
+			}
+
+			Limit* parent = limit->getParent(pools);
+			while (parent != nullptr && limit == (ascending ? parent->getRightChild(pools) : parent->getLeftChild(pools))) {
+				limit = parent;
+				parent = parent->getParent(pools);
+			}
+			return parent;
+		}
+	};
+};
+
+// Flat array of levels over the whole tick range with an occupancy bitmap, finding
+// the next level is a scan over 64 ticks per word. Fits instruments with a dense book.
+struct LadderPriceIndex {
+	template <typename Config, typename Limit>
+	class Side {
+	public:
+		using Price = typename Config::Price;
+
+		using Pools = typename Limit::Pools;
+
+		Side(Pools&, bool _bestIsHighest, int&)
+			: slots(Config::levelCount, nullptr), occupied((Config::levelCount + 63) / 64, 0),
+			bestLimit(nullptr), bestIsHighest(_bestIsHighest) {}
+
+		Limit* find(Price price) const {
+			return slots[Config::toTick(price)];
+		}
+
+		Limit* best() const {
+			return bestLimit;
+		}
+
+		// Levels aren't linked as a tree
+		Limit* root() const {
+			return nullptr;
+		}
+
+		// Next level moving away from the best price
+		Limit* next(Limit* limit) const {
+			std::size_t tick = Config::toTick(limit->getLimitPrice());
+			return bestIsHighest ? below(tick) : above(tick);
+		}
+
+		// Visit every level in ascending price order
+		template <typename Visitor>
+		void forEach(Visitor visit) const {
+			for (std::size_t word = 0; word < occupied.size(); word++) {
+				std::uint64_t bits = occupied[word];
+				while (bits != 0) {
+					Limit* limit = slots[word * 64 + std::countr_zero(bits)];
+					bits &= bits - 1;
+					visit(limit);
+				}
+			}
+		}
+
+		void insert(Limit* limit) {
+			std::size_t tick = Config::toTick(limit->getLimitPrice());
+			slots[tick] = limit;
+			occupied[tick / 64] |= std::uint64_t(1) << (tick % 64);
+
+			if (bestLimit == nullptr || (bestIsHighest ? limit->getLimitPrice() > bestLimit->getLimitPrice()
+				: limit->getLimitPrice() < bestLimit->getLimitPrice())) {
+				bestLimit = limit;
+			}
+		}
+
+		void erase(Limit* limit) {
+			if (limit == bestLimit) {
+				bestLimit = next(limit);
+			}
+			std::size_t tick = Config::toTick(limit->getLimitPrice());
+			slots[tick] = nullptr;
+			occupied[tick / 64] &= ~(std::uint64_t(1) << (tick % 64));
+		}
+
+	private:
+		std::vector<Limit*> slots;
+		std::vector<std::uint64_t> occupied;
+		Limit* bestLimit;
+		bool bestIsHighest;
+
+		// Closest occupied level above a tick
+		Limit* above(std::size_t tick) const {
+			std::size_t start = tick + 1;
+			if (start >= Config::levelCount) {
+				return nullptr;
+			}
+			std::size_t word = start / 64;
+			std::uint64_t bits = occupied[word] & (~std::uint64_t(0) << (start % 64));
+			while (bits == 0) {
+				if (++word == occupied.size()) {
+					return nullptr;
+				}
+				bits = occupied[word];
+			}
+			return slots[word * 64 + std::countr_zero(bits)];
+		}
+
+		// Closest occupied level below a tick
+		Limit* below(std::size_t tick) const {
+			if (tick == 0) {
+				return nullptr;
+			}
+			std::size_t start = tick - 1;
+			std::size_t word = start / 64;
+			std::uint64_t bits = occupied[word] & (~std::uint64_t(0) >> (63 - start % 64));
+			while (bits == 0) {
+				if (word == 0) {
+					return nullptr;
+				}
+				bits = occupied[--word];
+			}
+			return slots[word * 64 + 63 - std::countl_zero(bits)];
+		}
+	};
+};
+
+#endif
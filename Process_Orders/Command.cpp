@@ -0,0 +1,264 @@
+#include "Command.hpp"
+#include "../Order_Book/OrderTypes.hpp"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    const char* const commandNames[commandTypeCount] = {
+        "Market", "AddLimit", "AddMarketLimit", "AddLimitIOC", "AddLimitFOK", "AddIceberg", "CancelLimit",
+        "ModifyLimit", "AddStop", "CancelStop", "ModifyStop", "AddStopLimit", "CancelStopLimit", "ModifyStopLimit"
+    };
+
+    // Magic and version of binary command files, followed by the record size
+    const char binaryMagic[8] = { 'O', 'B', 'C', 'M', 'D', 0, 0, 1 };
+}
+
+const char* commandName(CommandType type)
+{
+    return commandNames[static_cast<std::size_t>(type)];
+}
+
+bool commandTypeFromName(const std::string& name, CommandType& type)
+{
+    for (std::size_t i = 0; i < commandTypeCount; i++)
+    {
+        if (name == commandNames[i])
+        {
+            type = static_cast<CommandType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CommandWriter::open(const std::string& filePath, CommandFormat _format)
+{
+    format = _format;
+    file.open(filePath, format == CommandFormat::Binary ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    if (format == CommandFormat::Binary)
+    {
+        std::uint32_t recordSize = sizeof(Command);
+        file.write(binaryMagic, sizeof(binaryMagic));
+        file.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    }
+    return true;
+}
+
+namespace {
+    char* appendNumber(char* out, std::int64_t value)
+    {
+        *out++ = ' ';
+        return std::to_chars(out, out + 24, value).ptr;
+    }
+}
+
+char* formatCommand(const Command& command, char* out)
+{
+    const char* name = commandName(command.type);
+    std::size_t nameLength = std::strlen(name);
+    std::memcpy(out, name, nameLength);
+    out = appendNumber(out + nameLength, command.orderId);
+
+    switch (command.type)
+    {
+    case CommandType::Market:
+        out = appendNumber(out, command.buyOrSell);
+        out = appendNumber(out, command.shares);
+        break;
+    case CommandType::AddLimit:
+    case CommandType::AddMarketLimit:
+    case CommandType::AddLimitIOC:
+    case CommandType::AddLimitFOK:
+    case CommandType::AddStop:
+        out = appendNumber(out, command.buyOrSell);
+        out = appendNumber(out, command.shares);
+        out = appendNumber(out, command.price);
+        break;
+    case CommandType::AddIceberg:
+    case CommandType::AddStopLimit:
+        out = appendNumber(out, command.buyOrSell);
+        out = appendNumber(out, command.shares);
+        out = appendNumber(out, command.price);
+        out = appendNumber(out, command.auxiliary);
+        break;
+    case CommandType::ModifyLimit:
+    case CommandType::ModifyStop:
+        out = appendNumber(out, command.shares);
+        out = appendNumber(out, command.price);
+        break;
+    case CommandType::ModifyStopLimit:
+        out = appendNumber(out, command.shares);
+        out = appendNumber(out, command.price);
+        out = appendNumber(out, command.auxiliary);
+        break;
+    default:
+        break;
+    }
+    // Owners trail the add commands and are left out when there is none
+    bool isAdd = command.type != CommandType::CancelLimit && command.type != CommandType::ModifyLimit
+        && command.type != CommandType::CancelStop && command.type != CommandType::ModifyStop
+        && command.type != CommandType::CancelStopLimit && command.type != CommandType::ModifyStopLimit;
+    if (isAdd && command.ownerId != noOwner)
+    {
+        out = appendNumber(out, command.ownerId);
+    }
+    *out++ = '\n';
+    return out;
+}
+
+bool parseCommand(const std::string& line, Command& command)
+{
+    command = {};
+    std::istringstream iss(line);
+    std::string name;
+    iss >> name;
+    if (!commandTypeFromName(name, command.type))
+    {
+        return false;
+    }
+
+    std::int64_t orderId = 0, buyOrSell = 0, ownerId = noOwner;
+    iss >> orderId;
+    switch (command.type)
+    {
+    case CommandType::Market:
+        iss >> buyOrSell >> command.shares;
+        break;
+    case CommandType::AddLimit:
+    case CommandType::AddMarketLimit:
+    case CommandType::AddLimitIOC:
+    case CommandType::AddLimitFOK:
+    case CommandType::AddStop:
+        iss >> buyOrSell >> command.shares >> command.price;
+        break;
+    case CommandType::AddIceberg:
+    case CommandType::AddStopLimit:
+        iss >> buyOrSell >> command.shares >> command.price >> command.auxiliary;
+        break;
+    case CommandType::ModifyLimit:
+    case CommandType::ModifyStop:
+        iss >> command.shares >> command.price;
+        break;
+    case CommandType::ModifyStopLimit:
+        iss >> command.shares >> command.price >> command.auxiliary;
+        break;
+    default:
+        break;
+    }
+    if (iss.fail())
+    {
+        return false;
+    }
+    // The owner is optional, a missing owner leaves the stream at its end
+    iss >> ownerId;
+    command.orderId = static_cast<std::int32_t>(orderId);
+    command.ownerId = static_cast<std::int32_t>(iss.fail() ? noOwner : ownerId);
+    command.buyOrSell = buyOrSell != 0;
+    return true;
+}
+
+bool readCommandFile(const std::string& filePath, std::vector<Command>& commands)
+{
+    commands.clear();
+    CommandReader reader;
+    if (reader.open(filePath))
+    {
+        Command command;
+        while (reader.read(command))
+        {
+            commands.push_back(command);
+        }
+        return !reader.failed();
+    }
+
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        Command command;
+        if (line.empty())
+        {
+            continue;
+        }
+        if (!parseCommand(line, command))
+        {
+            std::cerr << "Invalid command in " << filePath << ": " << line << std::endl;
+            return false;
+        }
+        commands.push_back(command);
+    }
+    return true;
+}
+
+void CommandWriter::write(const Command& command)
+{
+    if (format == CommandFormat::Binary)
+    {
+        file.write(reinterpret_cast<const char*>(&command), sizeof(Command));
+        return;
+    }
+    char line[maxFormattedCommandSize];
+    file.write(line, formatCommand(command, line) - line);
+}
+
+void CommandWriter::writeRaw(const char* data, std::size_t size)
+{
+    file.write(data, static_cast<std::streamsize>(size));
+}
+
+void CommandWriter::close()
+{
+    file.close();
+}
+
+bool CommandReader::open(const std::string& filePath)
+{
+    file.open(filePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    char magic[sizeof(binaryMagic)];
+    std::uint32_t recordSize = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    return file.good() && std::memcmp(magic, binaryMagic, sizeof(magic)) == 0 && recordSize == sizeof(Command);
+}
+
+bool CommandReader::read(Command& command)
+{
+    file.read(reinterpret_cast<char*>(&command), sizeof(Command));
+    if (file.gcount() == 0 && file.eof())
+    {
+        return false;
+    }
+    if (file.gcount() != sizeof(Command))
+    {
+        std::cerr << "Truncated command record " << records << ": " << file.gcount() << " of " << sizeof(Command) << " bytes" << std::endl;
+        invalid = true;
+        return false;
+    }
+    if (static_cast<std::size_t>(command.type) >= commandTypeCount)
+    {
+        std::cerr << "Invalid type " << static_cast<unsigned>(command.type) << " in command record " << records << std::endl;
+        invalid = true;
+        return false;
+    }
+    records++;
+    return true;
+}
+
+bool CommandReader::failed() const
+{
+    return invalid;
+}
@@ -0,0 +1,95 @@
+#ifndef COMMAND_HPP
+#define COMMAND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Commands understood by OrderPipeline, named as in the text format
+enum class CommandType : std::uint8_t {
+	Market,
+	AddLimit,
+	AddMarketLimit,
+	AddLimitIOC,
+	AddLimitFOK,
+	AddIceberg,
+	CancelLimit,
+	ModifyLimit,
+	AddStop,
+	CancelStop,
+	ModifyStop,
+	AddStopLimit,
+	CancelStopLimit,
+	ModifyStopLimit
+};
+
+constexpr std::size_t commandTypeCount = 14;
+
+const char* commandName(CommandType type);
+bool commandTypeFromName(const std::string& name, CommandType& type);
+
+// One command of an order stream. Fields which don't apply to the type are 0.
+struct Command {
+	std::int64_t timestamp;  // Nanoseconds since the start of the stream, only kept by the binary format
+	std::int64_t shares;     // Shares, or new shares of a modify
+	std::int64_t price;      // Limit price, or stop price of stop orders
+	std::int64_t auxiliary;  // Stop price of stop limit orders, peak shares of iceberg orders
+	std::int32_t orderId;
+	std::int32_t ownerId;
+	CommandType type;
+	bool buyOrSell;
+	std::uint8_t padding[6];
+};
+
+static_assert(sizeof(Command) == 48, "Binary command records have a fixed size");
+
+// Text is the line format read by OrderPipeline::processOrdersFromFile. Binary is a
+// header followed by fixed size little endian Command records, with timestamps.
+enum class CommandFormat {
+	Text,
+	Binary
+};
+
+// Longest line formatCommand can produce, newline included
+constexpr std::size_t maxFormattedCommandSize = 128;
+
+// Format a command as a text line at out and return the end of the line
+char* formatCommand(const Command& command, char* out);
+
+// Parse a text line as written by formatCommand, timestamps are left at 0
+bool parseCommand(const std::string& line, Command& command);
+
+// Read a whole command file in either format, binary files are recognised by their header
+bool readCommandFile(const std::string& filePath, std::vector<Command>& commands);
+
+class CommandWriter {
+private:
+	std::ofstream file;
+	CommandFormat format;
+
+public:
+	bool open(const std::string& filePath, CommandFormat format);
+	void write(const Command& command);
+	// Bytes already in the format of the file, e.g. commands formatted or copied in bulk
+	void writeRaw(const char* data, std::size_t size);
+	void close();
+};
+
+class CommandReader {
+private:
+	std::ifstream file;
+	std::uint64_t records = 0;
+	bool invalid = false;
+
+public:
+	// Fails if the file is missing or isn't a binary command file
+	bool open(const std::string& filePath);
+	// False at the end of the file, and at a record that is cut short or has an unknown
+	// type, which also sets failed
+	bool read(Command& command);
+	bool failed() const;
+};
+
+#endif
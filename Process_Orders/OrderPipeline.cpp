@@ -12,6 +12,9 @@ OrderPipeline::OrderPipeline(Book* book) : book(book) {
         {"Market", &OrderPipeline::processMarketOrder},
         {"AddLimit", &OrderPipeline::processAddLimitOrder},
         {"AddMarketLimit", &OrderPipeline::processAddLimitOrder},
+        {"AddLimitIOC", &OrderPipeline::processAddIOCLimitOrder},
+        {"AddLimitFOK", &OrderPipeline::processAddFOKLimitOrder},
+        {"AddIceberg", &OrderPipeline::processAddIcebergOrder},
         {"CancelLimit", &OrderPipeline::processCancelLimitOrder},
         {"ModifyLimit", &OrderPipeline::processModifyLimitOrder},
         {"AddStop", &OrderPipeline::processAddStopOrder},
@@ -52,13 +55,7 @@ void OrderPipeline::processOrdersFromFile(const std::string& filename)
             auto end = std::chrono::steady_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
 
-            if (orderType == "AddLimit")
-            {
-                csvFile << orderType << "," << duration.count() << "," << 0 << "," << book->AVLTreeBalanceCount << std::endl;
-            }
-            else {
-                csvFile << orderType << "," << duration.count() << "," << book->executedOrdersCount << "," << book->AVLTreeBalanceCount << std::endl;
-            }
+            writeProcessingTime(csvFile, orderType.c_str(), duration.count());
 
         }
         else {
@@ -69,18 +66,140 @@ void OrderPipeline::processOrdersFromFile(const std::string& filename)
     csvFile.close();
 }
 
+// Replay a binary command file written by CommandWriter
+void OrderPipeline::processOrdersFromBinaryFile(const std::string& filename)
+{
+    CommandReader reader;
+    if (!reader.open(filename)) {
+        std::cerr << "Error opening binary command file: " << filename << std::endl;
+        return;
+    }
+
+    std::ofstream csvFile("order_processing_times.csv", std::ios::trunc);
+    if (!csvFile.is_open()) {
+        std::cerr << "Error opening CSV file for writing." << std::endl;
+        return;
+    }
+
+    Command command;
+    while (reader.read(command)) {
+        auto start = std::chrono::steady_clock::now();
+
+        processCommand(command);
+
+        auto end = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        writeProcessingTime(csvFile, commandName(command.type), duration.count());
+    }
+    if (reader.failed()) {
+        std::cerr << "Stopped at an invalid record of " << filename << std::endl;
+    }
+    csvFile.close();
+}
+
+void OrderPipeline::writeProcessingTime(std::ofstream& csvFile, const char* orderType, long long nanoseconds) const
+{
+    if (std::string_view(orderType) == "AddLimit")
+    {
+        csvFile << orderType << "," << nanoseconds << "," << 0 << "," << book->AVLTreeBalanceCount << std::endl;
+    }
+    else {
+        csvFile << orderType << "," << nanoseconds << "," << book->executedOrdersCount << "," << book->AVLTreeBalanceCount << std::endl;
+    }
+}
+
+// Apply a parsed command to the book
+void OrderPipeline::processCommand(const Command& command)
+{
+    Book::Quantity shares = static_cast<Book::Quantity>(command.shares);
+    Book::Price price = static_cast<Book::Price>(command.price);
+    switch (command.type)
+    {
+    case CommandType::Market:
+        book->marketOrder(command.orderId, command.buyOrSell, shares, command.ownerId);
+        break;
+    case CommandType::AddLimit:
+    case CommandType::AddMarketLimit:
+        book->addLimitOrder(command.orderId, command.buyOrSell, shares, price, TimeInForce::GoodTillCancel, command.ownerId);
+        break;
+    case CommandType::AddLimitIOC:
+        book->addLimitOrder(command.orderId, command.buyOrSell, shares, price, TimeInForce::ImmediateOrCancel, command.ownerId);
+        break;
+    case CommandType::AddLimitFOK:
+        book->addLimitOrder(command.orderId, command.buyOrSell, shares, price, TimeInForce::FillOrKill, command.ownerId);
+        break;
+    case CommandType::AddIceberg:
+        book->addIcebergOrder(command.orderId, command.buyOrSell, shares, price, static_cast<Book::Quantity>(command.auxiliary), command.ownerId);
+        break;
+    case CommandType::CancelLimit:
+        book->cancelLimitOrder(command.orderId);
+        break;
+    case CommandType::ModifyLimit:
+        book->modifyLimitOrder(command.orderId, shares, price);
+        break;
+    case CommandType::AddStop:
+        book->addStopOrder(command.orderId, command.buyOrSell, shares, price, command.ownerId);
+        break;
+    case CommandType::CancelStop:
+        book->cancelStopOrder(command.orderId);
+        break;
+    case CommandType::ModifyStop:
+        book->modifyStopOrder(command.orderId, shares, price);
+        break;
+    case CommandType::AddStopLimit:
+        book->addStopLimitOrder(command.orderId, command.buyOrSell, shares, price, static_cast<Book::Price>(command.auxiliary), command.ownerId);
+        break;
+    case CommandType::CancelStopLimit:
+        book->cancelStopLimitOrder(command.orderId);
+        break;
+    case CommandType::ModifyStopLimit:
+        book->modifyStopLimitOrder(command.orderId, shares, price, static_cast<Book::Price>(command.auxiliary));
+        break;
+    }
+}
+
 void OrderPipeline::processMarketOrder(std::istringstream& iss) {
-    int orderId, shares;
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares;
     bool buyOrSell;
-    iss >> orderId >> buyOrSell >> shares;
-    book->marketOrder(orderId, buyOrSell, shares);
+    iss >> orderId >> buyOrSell >> shares >> ownerId;
+    book->marketOrder(orderId, buyOrSell, shares, ownerId);
 }
 
 void OrderPipeline::processAddLimitOrder(std::istringstream& iss) {
-    int orderId, shares, limitPrice;
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares;
+    Book::Price limitPrice;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> ownerId;
+    book->addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::GoodTillCancel, ownerId);
+}
+
+void OrderPipeline::processAddIOCLimitOrder(std::istringstream& iss) {
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares;
+    Book::Price limitPrice;
     bool buyOrSell;
-    iss >> orderId >> buyOrSell >> shares >> limitPrice;
-    book->addLimitOrder(orderId, buyOrSell, shares, limitPrice);
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> ownerId;
+    book->addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::ImmediateOrCancel, ownerId);
+}
+
+void OrderPipeline::processAddFOKLimitOrder(std::istringstream& iss) {
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares;
+    Book::Price limitPrice;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> ownerId;
+    book->addLimitOrder(orderId, buyOrSell, shares, limitPrice, TimeInForce::FillOrKill, ownerId);
+}
+
+void OrderPipeline::processAddIcebergOrder(std::istringstream& iss) {
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares, peakShares;
+    Book::Price limitPrice;
+    bool buyOrSell;
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> peakShares >> ownerId;
+    book->addIcebergOrder(orderId, buyOrSell, shares, limitPrice, peakShares, ownerId);
 }
 
 void OrderPipeline::processCancelLimitOrder(std::istringstream& iss) {
@@ -90,16 +209,20 @@ void OrderPipeline::processCancelLimitOrder(std::istringstream& iss) {
 }
 
 void OrderPipeline::processModifyLimitOrder(std::istringstream& iss) {
-    int orderId, newShares, newLimit;
+    int orderId;
+    Book::Quantity newShares;
+    Book::Price newLimit;
     iss >> orderId >> newShares >> newLimit;
     book->modifyLimitOrder(orderId, newShares, newLimit);
 }
 
 void OrderPipeline::processAddStopOrder(std::istringstream& iss) {
-    int orderId, shares, stopPrice;
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares;
+    Book::Price stopPrice;
     bool buyOrSell;
-    iss >> orderId >> buyOrSell >> shares >> stopPrice;
-    book->addStopOrder(orderId, buyOrSell, shares, stopPrice);
+    iss >> orderId >> buyOrSell >> shares >> stopPrice >> ownerId;
+    book->addStopOrder(orderId, buyOrSell, shares, stopPrice, ownerId);
 }
 
 void OrderPipeline::processCancelStopOrder(std::istringstream& iss) {
@@ -109,16 +232,20 @@ void OrderPipeline::processCancelStopOrder(std::istringstream& iss) {
 }
 
 void OrderPipeline::processModifyStopOrder(std::istringstream& iss) {
-    int orderId, newShares, newStopPrice;
+    int orderId;
+    Book::Quantity newShares;
+    Book::Price newStopPrice;
     iss >> orderId >> newShares >> newStopPrice;
     book->modifyStopOrder(orderId, newShares, newStopPrice);
 }
 
 void OrderPipeline::processAddStopLimitOrder(std::istringstream& iss) {
-    int orderId, shares, limitPrice, stopPrice;
+    int orderId, ownerId = noOwner;
+    Book::Quantity shares;
+    Book::Price limitPrice, stopPrice;
     bool buyOrSell;
-    iss >> orderId >> buyOrSell >> shares >> limitPrice >> stopPrice;
-    book->addStopLimitOrder(orderId, buyOrSell, shares, limitPrice, stopPrice);
+    iss >> orderId >> buyOrSell >> shares >> limitPrice >> stopPrice >> ownerId;
+    book->addStopLimitOrder(orderId, buyOrSell, shares, limitPrice, stopPrice, ownerId);
 }
 
 void OrderPipeline::processCancelStopLimitOrder(std::istringstream& iss) {
@@ -128,7 +255,9 @@ void OrderPipeline::processCancelStopLimitOrder(std::istringstream& iss) {
 }
 
 void OrderPipeline::processModifyStopLimitOrder(std::istringstream& iss) {
-    int orderId, newShares, newLimitPrice, newStopPrice;
+    int orderId;
+    Book::Quantity newShares;
+    Book::Price newLimitPrice, newStopPrice;
     iss >> orderId >> newShares >> newLimitPrice >> newStopPrice;
     book->modifyStopLimitOrder(orderId, newShares, newLimitPrice, newStopPrice);
 }
\ No newline at end of file
@@ -6,7 +6,8 @@
 #include <string_view>
 #include <sstream>
 
-class Book;
+#include "../Order_Book/BookConfig.hpp"
+#include "Command.hpp"
 
 class OrderPipeline {
 private:
@@ -17,6 +18,9 @@ private:
 
 	void processMarketOrder(std::istringstream& iss);
 	void processAddLimitOrder(std::istringstream& iss);
+	void processAddIOCLimitOrder(std::istringstream& iss);
+	void processAddFOKLimitOrder(std::istringstream& iss);
+	void processAddIcebergOrder(std::istringstream& iss);
 	void processCancelLimitOrder(std::istringstream& iss);
 	void processModifyLimitOrder(std::istringstream& iss);
 	void processAddStopOrder(std::istringstream& iss);
@@ -25,10 +29,13 @@ private:
 	void processAddStopLimitOrder(std::istringstream& iss);
 	void processCancelStopLimitOrder(std::istringstream& iss);
 	void processModifyStopLimitOrder(std::istringstream& iss);
+	void writeProcessingTime(std::ofstream& csvFile, const char* orderType, long long nanoseconds) const;
 	
 public:
 	OrderPipeline(Book* book);
 	void processOrdersFromFile(const std::string& filename);
+	void processOrdersFromBinaryFile(const std::string& filename);
+	void processCommand(const Command& command);
 };
 
 #endif
\ No newline at end of file
@@ -11,8 +11,6 @@
 #include <string_view>
 #include <unordered_map>
 
-class Book;
-
 class OrderExecutor {
 private:
     Book* book;
@@ -51,7 +51,7 @@ void OrderGenerator::cancelLimitOrder() {
         createLimitOrder();
     }
     else {
-        int orderId = order->getOrderId();
+        int orderId = order->getOrderId(book->getPools());
         file << "CancelLimit " << orderId << std::endl;
         book->cancelLimitOrder(orderId);
     }
@@ -98,8 +98,8 @@ void OrderGenerator::modifyLimitOrder() {
         return;
     }
 
-    int orderId = order->getOrderId();
-    bool buyOrSell = order->getBuyOrSell();
+    int orderId = order->getOrderId(book->getPools());
+    bool buyOrSell = order->getBuyOrSell(book->getPools());
     int limitPrice;
 
     if (buyOrSell) { // Buy order
@@ -14,10 +14,6 @@
 #include <sstream>
 #include <string>
 
-class Book;
-
-class Book;
-
 class OrderGenerator {
 
 private:
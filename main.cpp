@@ -60,8 +60,12 @@ int main() {
             return 1;
         }
 
+        // Sobol paths reach a standard error of a basis point of the spot price after a
+        // fraction of the full run, stop there rather than simulating every path
         Forecaster forecaster;
         forecaster.setSpotPrice(spotPrice);
+        forecaster.setVarianceReduction(VarianceReduction::Sobol);
+        forecaster.setTolerance(spotPrice * 1e-4f);
 
         if (!forecaster.forecast(dataPath)) {
             std::cerr << "Forecasting failed!" << std::endl;
@@ -0,0 +1,349 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../Forecaster/Forecaster.hpp"
+
+namespace {
+
+// History alternating between two prices, every bar has a log return of +-barReturn
+std::string writeHistory(const std::string& name, float barReturn) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream file(path);
+    for (int i = 0; i < 200; i++) {
+        file << (i % 2 ? 100.0f * std::exp(barReturn) : 100.0f) << (i + 1 < 200 ? "," : "\n");
+    }
+    return path;
+}
+
+std::string writeFile(const std::string& name, const std::string& contents) {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path;
+}
+
+// Prices whose log returns are the given ones, from 100
+std::vector<float> pricesOf(const std::vector<double>& returns) {
+    std::vector<float> prices = { 100.0f };
+    for (double logReturn : returns) {
+        prices.push_back(static_cast<float>(prices.back() * std::exp(logReturn)));
+    }
+    return prices;
+}
+
+// Log returns of the last count returns of prices, newest first
+std::vector<double> lastReturns(const std::vector<float>& prices, size_t count) {
+    std::vector<double> returns;
+    for (size_t i = prices.size() - 1; i > 0 && returns.size() < count; i--) {
+        returns.push_back(std::log(static_cast<double>(prices[i]) / prices[i - 1]));
+    }
+    return returns;
+}
+
+void setSmall(Forecaster& forecaster, VarianceReduction mode) {
+    forecaster.setSpotPrice(100.0f);
+    forecaster.setVarianceReduction(mode);
+    forecaster.setLoops(64, 64);
+    forecaster.setOutputPath("");
+}
+
+// The standard error a forecast reports should be the spread of its mean over seeds
+void expectErrorMatchesSpread(VarianceReduction mode) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    Forecaster forecaster(4);
+    setSmall(forecaster, mode);
+    constexpr int seeds = 40;
+    const std::vector<int> steps = { 90, 179 };
+    std::vector<double> sums(steps.size()), squares(steps.size()), errors(steps.size());
+    for (int seed = 0; seed < seeds; seed++) {
+        forecaster.setSeed(1000 + seed);
+        ASSERT_TRUE(forecaster.forecast(history));
+        for (size_t i = 0; i < steps.size(); i++) {
+            const double mean = forecaster.means()[steps[i]];
+            sums[i] += mean;
+            squares[i] += mean * mean;
+            errors[i] += forecaster.standardErrors()[steps[i]];
+        }
+    }
+    for (size_t i = 0; i < steps.size(); i++) {
+        const double average = sums[i] / seeds;
+        const double spread = std::sqrt((squares[i] - seeds * average * average) / (seeds - 1));
+        // 40 seeds pin the spread down to about 11%
+        EXPECT_GT(errors[i] / seeds, 0.6 * spread) << "step " << steps[i];
+        EXPECT_LT(errors[i] / seeds, 1.5 * spread) << "step " << steps[i];
+    }
+}
+
+}
+
+TEST(ForecasterTests, StandardErrorMatchesSpreadOverSeeds) {
+    expectErrorMatchesSpread(VarianceReduction::None);
+}
+
+TEST(ForecasterTests, AntitheticStandardErrorMatchesSpreadOverSeeds) {
+    expectErrorMatchesSpread(VarianceReduction::Antithetic);
+}
+
+TEST(ForecasterTests, ControlVariateStandardErrorMatchesSpreadOverSeeds) {
+    expectErrorMatchesSpread(VarianceReduction::ControlVariate);
+}
+
+TEST(ForecasterTests, SobolStandardErrorMatchesSpreadOverSeeds) {
+    expectErrorMatchesSpread(VarianceReduction::Sobol);
+}
+
+TEST(ForecasterTests, LowVolatilityKeepsStandardErrors) {
+    const std::string history = writeHistory("forecaster_tests_low.csv", 0.0002f);
+    for (VarianceReduction mode : { VarianceReduction::Antithetic, VarianceReduction::ControlVariate }) {
+        Forecaster forecaster(4);
+        setSmall(forecaster, mode);
+        ASSERT_TRUE(forecaster.forecast(history));
+        for (size_t k = 1; k < forecaster.standardErrors().size(); k++) {
+            EXPECT_GT(forecaster.standardErrors()[k], 0.0f) << "step " << k;
+        }
+    }
+}
+
+// The Sobol error is the spread of the replicate means, which takes two of them
+TEST(ForecasterTests, SobolNeedsTwoReplicates) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    Forecaster forecaster(4);
+    setSmall(forecaster, VarianceReduction::Sobol);
+    forecaster.setLoops(64, 1);
+    EXPECT_FALSE(forecaster.forecast(history));
+
+    forecaster.setLoops(64, 2);
+    ASSERT_TRUE(forecaster.forecast(history));
+    for (size_t k = 1; k < forecaster.standardErrors().size(); k++) {
+        EXPECT_TRUE(std::isfinite(forecaster.standardErrors()[k])) << "step " << k;
+        EXPECT_GT(forecaster.standardErrors()[k], 0.0f) << "step " << k;
+    }
+}
+
+TEST(ForecasterTests, RejectsTooFewSamplesAndBadSpotPrices) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    Forecaster forecaster(2);
+    setSmall(forecaster, VarianceReduction::ControlVariate);
+    forecaster.setLoops(2, 1);
+    EXPECT_FALSE(forecaster.forecast(history));
+    forecaster.setLoops(3, 1);
+    EXPECT_TRUE(forecaster.forecast(history));
+
+    forecaster.setVarianceReduction(VarianceReduction::Antithetic);
+    forecaster.setLoops(4, 1);
+    EXPECT_FALSE(forecaster.forecast(history));
+    forecaster.setLoops(6, 1);
+    EXPECT_TRUE(forecaster.forecast(history));
+
+    forecaster.setSpotPrice(0.0f);
+    EXPECT_FALSE(forecaster.forecast(history));
+    EXPECT_FALSE(forecaster.reforecast(-1.0f));
+    std::vector<SymbolForecast> results;
+    EXPECT_FALSE(forecaster.forecastBatch({ { "A", 100.0f, history }, { "B", -5.0f, history } }, results));
+}
+
+// A run stopped at its tolerance is the run of as many outer loops without one
+TEST(ForecasterTests, ToleranceStopsAtABatchBoundary) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    const std::vector<ForecastInput> inputs = { { "A", 100.0f, history } };
+    Forecaster forecaster(4);
+    setSmall(forecaster, VarianceReduction::None);
+    forecaster.setLoops(64, 4096);
+    forecaster.setTolerance(0.04f);
+    std::vector<SymbolForecast> stopped;
+    ASSERT_TRUE(forecaster.forecastBatch(inputs, stopped));
+    EXPECT_TRUE(stopped[0].converged);
+    EXPECT_LT(stopped[0].paths, 64 * 4096);
+    EXPECT_EQ(stopped[0].paths % (64 * 512), 0);
+    EXPECT_LE(*std::max_element(stopped[0].standardErrors.begin(), stopped[0].standardErrors.end()), 0.04f);
+
+    forecaster.setLoops(64, static_cast<int32_t>(stopped[0].paths / 64));
+    forecaster.setTolerance(0.0f);
+    std::vector<SymbolForecast> full;
+    ASSERT_TRUE(forecaster.forecastBatch(inputs, full));
+    EXPECT_FALSE(full[0].converged);
+    EXPECT_EQ(full[0].paths, stopped[0].paths);
+    EXPECT_EQ(full[0].mean, stopped[0].mean);
+    EXPECT_EQ(full[0].standardErrors, stopped[0].standardErrors);
+    EXPECT_EQ(full[0].bands, stopped[0].bands);
+}
+
+// A symbol packed into the lanes of a batch is forecast exactly as it is alone
+TEST(ForecasterTests, PackedSymbolMatchesSoloForecast) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    const std::string calm = writeHistory("forecaster_tests_low.csv", 0.0002f);
+    const std::vector<ForecastInput> inputs = { { "A", 100.0f, history }, { "B", 50.0f, calm }, { "C", 120.0f, history } };
+    for (VarianceReduction mode : { VarianceReduction::None, VarianceReduction::Antithetic, VarianceReduction::ControlVariate, VarianceReduction::Sobol }) {
+        Forecaster forecaster(4);
+        setSmall(forecaster, mode);
+        forecaster.setLoops(64, 48);    // 3072 samples, packed
+        std::vector<SymbolForecast> results;
+        ASSERT_TRUE(forecaster.forecastBatch(inputs, results));
+        for (size_t s = 0; s < inputs.size(); s++) {
+            forecaster.setSpotPrice(inputs[s].spotPrice);
+            ASSERT_TRUE(forecaster.forecast(inputs[s].dataPath));
+            EXPECT_EQ(results[s].mean, forecaster.means()) << inputs[s].symbol;
+            EXPECT_EQ(results[s].standardErrors, forecaster.standardErrors()) << inputs[s].symbol;
+            EXPECT_EQ(results[s].bands, forecaster.quantileBands()) << inputs[s].symbol;
+        }
+    }
+}
+
+// Rescaling the last forecast to a new spot price gives the forecast simulated at it
+TEST(ForecasterTests, ReforecastMatchesFreshForecast) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    for (VarianceReduction mode : { VarianceReduction::None, VarianceReduction::Antithetic, VarianceReduction::ControlVariate, VarianceReduction::Sobol }) {
+        Forecaster forecaster(4);
+        setSmall(forecaster, mode);
+        ASSERT_TRUE(forecaster.forecast(history));
+        ASSERT_TRUE(forecaster.reforecast(80.0f));
+
+        Forecaster fresh(2);
+        setSmall(fresh, mode);
+        fresh.setSpotPrice(80.0f);
+        ASSERT_TRUE(fresh.forecast(history));
+        EXPECT_EQ(forecaster.means(), fresh.means());
+        EXPECT_EQ(forecaster.standardErrors(), fresh.standardErrors());
+        EXPECT_EQ(forecaster.quantileBands(), fresh.quantileBands());
+
+        // The cached paths are only reused with the settings they were simulated with
+        forecaster.setSeed(7);
+        EXPECT_FALSE(forecaster.reforecast(90.0f));
+    }
+}
+
+// The bands of geometric Brownian motion are the lognormal quantiles
+// S0 * exp(drift * k + diffusion * sqrt(k) * z) of the 5%, 25%, 50%, 75% and 95% points z
+TEST(ForecasterTests, BandsMatchLognormalQuantiles) {
+    const std::string history = writeHistory("forecaster_tests_history.csv", 0.004f);
+    const double z[] = { -1.6448536, -0.6744898, 0.0, 0.6744898, 1.6448536 };
+    constexpr double riskRate = 0.001;    // The forecaster's, per forecast horizon
+    constexpr int32_t timeSteps = 180;
+    for (VarianceReduction mode : { VarianceReduction::None, VarianceReduction::Antithetic, VarianceReduction::Sobol }) {
+        Forecaster forecaster(4);
+        setSmall(forecaster, mode);
+        forecaster.setLoops(64, 512);
+        forecaster.setTimeSteps(timeSteps);
+        std::vector<SymbolForecast> results;
+        ASSERT_TRUE(forecaster.forecastBatch({ { "A", 100.0f, history } }, results));
+
+        const double volatility = results[0].volatility;
+        const double drift = (riskRate - volatility * volatility / 2.0) / timeSteps;
+        const double diffusion = volatility / std::sqrt(static_cast<double>(timeSteps));
+        for (int32_t k : { 1, 30, 90, 179 }) {
+            const double deviation = diffusion * std::sqrt(static_cast<double>(k));
+            for (int32_t band = 0; band < 5; band++) {
+                const double expected = 100.0 * std::exp(drift * k + deviation * z[band]);
+                // 32768 paths put the 5% quantile within about 0.012 standard deviations
+                EXPECT_NEAR(std::log(results[0].bands[static_cast<size_t>(k) * 5 + band] / expected), 0.0, 0.05 * deviation)
+                    << "step " << k << " band " << band;
+            }
+        }
+    }
+}
+
+TEST(ForecasterTests, LoadPricesReadsCommasLinesAndCrlf) {
+    std::vector<float> prices = { 1.0f };
+    ASSERT_TRUE(history::loadPrices(writeFile("forecaster_tests_prices.csv", "100,101.5\r\n102\r\n\r\n 103\t104\n"), prices));
+    EXPECT_EQ(prices, (std::vector<float>{ 100.0f, 101.5f, 102.0f, 103.0f, 104.0f }));
+
+    ASSERT_TRUE(history::loadPrices(writeFile("forecaster_tests_prices.csv", ""), prices));
+    EXPECT_TRUE(prices.empty());
+}
+
+TEST(ForecasterTests, LoadPricesRejectsBadTokens) {
+    std::vector<float> prices;
+    for (const char* contents : { "100,abc,102", "100,12x\n", "100;101", "100,-5", "100,0\r\n", "100,,nan" }) {
+        EXPECT_FALSE(history::loadPrices(writeFile("forecaster_tests_prices.csv", contents), prices)) << contents;
+    }
+    EXPECT_FALSE(history::loadPrices(writeFile("forecaster_tests_prices.csv", "") + ".missing", prices));
+}
+
+// Sample standard deviations of the log returns over trailing windows, including a window
+// longer than the history and 0 for all of it
+TEST(ForecasterTests, WindowVolatilitiesOfKnownReturns) {
+    const std::vector<float> prices = pricesOf({ 0.01, -0.02, 0.03, 0.01, -0.01, 0.02, -0.03 });
+    const int32_t windows[] = { 2, 0, 5, 100 };
+    float volatilities[4];
+    history::windowVolatilities(prices.data(), prices.size(), windows, 4, volatilities);
+    for (int32_t w = 0; w < 4; w++) {
+        const std::vector<double> returns = lastReturns(prices, windows[w] > 0 ? windows[w] : prices.size());
+        double mean = 0.0, variance = 0.0;
+        for (double logReturn : returns) {
+            mean += logReturn / returns.size();
+        }
+        for (double logReturn : returns) {
+            variance += (logReturn - mean) * (logReturn - mean) / (returns.size() - 1);
+        }
+        EXPECT_NEAR(volatilities[w], std::sqrt(variance), 1e-6) << "window " << windows[w];
+    }
+
+    // A single return has no spread
+    const int32_t one = 1;
+    history::windowVolatilities(prices.data(), prices.size(), &one, 1, volatilities);
+    EXPECT_EQ(volatilities[0], 0.0f);
+}
+
+// Weighted around zero with weight decay^age, over more returns than a register holds
+TEST(ForecasterTests, EwmaVolatilityOfKnownReturns) {
+    std::vector<double> generated;
+    for (int i = 0; i < 50; i++) {
+        generated.push_back(0.001 * ((i * 7) % 11) - 0.005);
+    }
+    const std::vector<float> prices = pricesOf(generated);
+    for (float decay : { 0.5f, 0.9f, 0.97f }) {
+        const std::vector<double> returns = lastReturns(prices, prices.size());
+        double weighted = 0.0, weights = 0.0, weight = 1.0;
+        for (double logReturn : returns) {
+            weighted += weight * logReturn * logReturn;
+            weights += weight;
+            weight *= decay;
+        }
+        EXPECT_NEAR(history::ewmaVolatility(prices.data(), prices.size(), decay), std::sqrt(weighted / weights), 1e-6) << "decay " << decay;
+    }
+    EXPECT_EQ(history::ewmaVolatility(prices.data(), 1, 0.9f), 0.0f);
+}
+
+TEST(ForecasterTests, SobolInverseNormalMatchesKnownQuantiles) {
+    EXPECT_NEAR(sobol::inverseNormal(0.5f), 0.0f, 1e-6f);
+    EXPECT_NEAR(sobol::inverseNormal(0.975f), 1.959964f, 2e-6f);
+    EXPECT_NEAR(sobol::inverseNormal(0.025f), -1.959964f, 2e-6f);
+    EXPECT_NEAR(sobol::inverseNormal(0.2f), -0.8416212f, 2e-6f);
+    EXPECT_NEAR(sobol::inverseNormal(1e-6f), -4.753424f, 2e-5f);
+    EXPECT_NEAR(sobol::inverseNormal(1.0f - 1.0f / 1024), 3.0972639f, 2e-5f);
+}
+
+// Stepping through consecutive points gives the points built from scratch in any order
+TEST(ForecasterTests, SobolGrayCodeStepsMatchDirectPoints) {
+    constexpr int32_t dimensions = 37;
+    const sobol::Directions directions(dimensions);
+    const sobol::BrownianBridge bridge(dimensions);
+    const std::vector<uint32_t> shift(dimensions, 0x9E3779B9u);
+    const uint32_t* shifts[simdLanes];
+    std::fill(shifts, shifts + simdLanes, shift.data());
+
+    sobol::PathGenerator stepped(directions, bridge);
+    sobol::PathGenerator direct(directions, bridge);
+    std::vector<float> steppedNormals(static_cast<size_t>(dimensions) * simdLanes), directNormals(steppedNormals.size());
+    for (uint64_t block = 0; block < 3; block++) {
+        uint64_t points[simdLanes], reversed[simdLanes];
+        for (int32_t lane = 0; lane < simdLanes; lane++) {
+            points[lane] = 1000 + block * simdLanes + lane;
+            reversed[lane] = 1000 + block * simdLanes + simdLanes - 1 - lane;
+        }
+        stepped.fillNormals(shifts, points, steppedNormals.data());
+        direct.fillNormals(shifts, reversed, directNormals.data());
+        for (int32_t k = 0; k < dimensions; k++) {
+            for (int32_t lane = 0; lane < simdLanes; lane++) {
+                EXPECT_EQ(steppedNormals[static_cast<size_t>(k) * simdLanes + lane], directNormals[static_cast<size_t>(k) * simdLanes + simdLanes - 1 - lane])
+                    << "block " << block << " step " << k << " lane " << lane;
+            }
+        }
+    }
+}
@@ -0,0 +1,350 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include "../Order_Book/Book.hpp"
+#include "../Order_Book/Limit.hpp"
+#include "../Order_Book/Order.hpp"
+
+namespace {
+
+using RecordingBook = PolicyBook<AVLPriceIndex, UnorderedMapOrderStore, IndexPoolAllocator, RecordingEventSink>;
+
+// Shares displayed by a resting order, 0 once it left the book
+template <typename BookT>
+typename BookT::Quantity restingShares(const BookT& book, int orderId) {
+    const typename BookT::Order* order = book.searchOrderMap(orderId);
+    return order != nullptr ? order->getShares() : 0;
+}
+
+}
+
+TEST(OrderBookTests, DuplicateIdIsRejectedBeforeTrading) {
+    RecordingBook book;
+    book.addLimitOrder(1, false, 50, 100);
+    book.addLimitOrder(2, true, 20, 90);
+
+    for (TimeInForce timeInForce : { TimeInForce::GoodTillCancel, TimeInForce::ImmediateOrCancel, TimeInForce::FillOrKill }) {
+        const RecordingBook::OrderResult result = book.addLimitOrder(2, true, 30, 100, timeInForce);
+        EXPECT_EQ(result.status, OrderStatus::DuplicateId);
+        EXPECT_EQ(result.filledShares, 0);
+        EXPECT_EQ(result.remainingShares, 30);
+        EXPECT_FALSE(result.resting);
+    }
+    EXPECT_EQ(book.addIcebergOrder(1, true, 30, 100, 10).status, OrderStatus::DuplicateId);
+    EXPECT_EQ(book.addStopOrder(1, true, 30, 100).status, OrderStatus::DuplicateId);
+    EXPECT_EQ(book.addStopLimitOrder(2, true, 30, 100, 100).status, OrderStatus::DuplicateId);
+
+    EXPECT_TRUE(book.getEventSink().trades.empty());
+    EXPECT_EQ(restingShares(book, 1), 50);
+    EXPECT_EQ(restingShares(book, 2), 20);
+}
+
+TEST(OrderBookTests, IdOfAFilledOrderCanBeReused) {
+    RecordingBook book;
+    book.addLimitOrder(1, false, 50, 100);
+    book.marketOrder(2, true, 50);
+
+    const RecordingBook::OrderResult result = book.addLimitOrder(1, true, 10, 90);
+    EXPECT_EQ(result.status, OrderStatus::Ok);
+    EXPECT_TRUE(result.resting);
+}
+
+namespace {
+
+// 100 shares of another owner ahead of 50 shares of owner 1 on the sell side at 100
+void addSelfTradeOrders(RecordingBook& book, SelfTradePrevention mode) {
+    book.setSelfTradePrevention(mode);
+    book.addLimitOrder(1, false, 100, 100, TimeInForce::GoodTillCancel, 2);
+    book.addLimitOrder(2, false, 50, 100, TimeInForce::GoodTillCancel, 1);
+}
+
+void expectSharesAccounted(const RecordingBook::OrderResult& result, RecordingBook::Quantity shares) {
+    EXPECT_EQ(result.filledShares + result.remainingShares + result.cancelledShares, shares);
+}
+
+}
+
+TEST(OrderBookTests, FillOrKillIgnoresOwnVolumeWithCancelOldest) {
+    RecordingBook book;
+    addSelfTradeOrders(book, SelfTradePrevention::CancelOldest);
+    const RecordingBook::OrderResult killed = book.addLimitOrder(3, true, 150, 100, TimeInForce::FillOrKill, 1);
+    EXPECT_EQ(killed.status, OrderStatus::Killed);
+    EXPECT_EQ(killed.remainingShares, 150);
+    EXPECT_TRUE(book.getEventSink().trades.empty());
+    EXPECT_TRUE(book.getEventSink().cancels.empty());
+
+    const RecordingBook::OrderResult filled = book.addLimitOrder(3, true, 100, 100, TimeInForce::FillOrKill, 1);
+    EXPECT_EQ(filled.status, OrderStatus::Ok);
+    EXPECT_EQ(filled.filledShares, 100);
+    expectSharesAccounted(filled, 100);
+}
+
+TEST(OrderBookTests, FillOrKillStopsAtOwnOrderWithCancelNewest) {
+    RecordingBook book;
+    addSelfTradeOrders(book, SelfTradePrevention::CancelNewest);
+    EXPECT_EQ(book.addLimitOrder(3, true, 150, 100, TimeInForce::FillOrKill, 1).status, OrderStatus::Killed);
+    EXPECT_EQ(book.addLimitOrder(4, true, 101, 100, TimeInForce::FillOrKill, 1).status, OrderStatus::Killed);
+    EXPECT_TRUE(book.getEventSink().trades.empty());
+    EXPECT_EQ(restingShares(book, 1), 100);
+
+    const RecordingBook::OrderResult filled = book.addLimitOrder(5, true, 100, 100, TimeInForce::FillOrKill, 1);
+    EXPECT_EQ(filled.status, OrderStatus::Ok);
+    EXPECT_EQ(filled.filledShares, 100);
+    EXPECT_EQ(restingShares(book, 2), 50);
+}
+
+TEST(OrderBookTests, FillOrKillStopsAtOwnOrderWithDecrementBoth) {
+    RecordingBook book;
+    addSelfTradeOrders(book, SelfTradePrevention::DecrementBoth);
+    EXPECT_EQ(book.addLimitOrder(3, true, 150, 100, TimeInForce::FillOrKill, 1).status, OrderStatus::Killed);
+    EXPECT_TRUE(book.getEventSink().trades.empty());
+    EXPECT_EQ(restingShares(book, 2), 50);
+}
+
+TEST(OrderBookTests, CancelNewestReportsCancelledShares) {
+    RecordingBook book;
+    addSelfTradeOrders(book, SelfTradePrevention::CancelNewest);
+    const RecordingBook::OrderResult result = book.addLimitOrder(3, true, 150, 100, TimeInForce::GoodTillCancel, 1);
+    EXPECT_EQ(result.status, OrderStatus::SelfTradeCancelled);
+    EXPECT_EQ(result.filledShares, 100);
+    EXPECT_EQ(result.remainingShares, 0);
+    EXPECT_EQ(result.cancelledShares, 50);
+    EXPECT_FALSE(result.resting);
+    EXPECT_EQ(restingShares(book, 2), 50);
+}
+
+TEST(OrderBookTests, DecrementBothReportsCancelledShares) {
+    RecordingBook book;
+    addSelfTradeOrders(book, SelfTradePrevention::DecrementBoth);
+    const RecordingBook::OrderResult result = book.marketOrder(3, true, 170, 1);
+    EXPECT_EQ(result.status, OrderStatus::SelfTradeCancelled);
+    EXPECT_EQ(result.filledShares, 100);
+    EXPECT_EQ(result.cancelledShares, 50);
+    expectSharesAccounted(result, 170);
+    EXPECT_EQ(book.searchOrderMap(2), nullptr);
+}
+
+TEST(OrderBookTests, ProRataFillOrKillIsKilledByOwnOrderInLevel) {
+    BasicBook<ProRataBookConfig> book;
+    book.setSelfTradePrevention(SelfTradePrevention::CancelNewest);
+    book.addLimitOrder(1, false, 50, 100, TimeInForce::GoodTillCancel, 1);
+    book.addLimitOrder(2, false, 100, 100, TimeInForce::GoodTillCancel, 2);
+    EXPECT_EQ(book.addLimitOrder(3, true, 10, 100, TimeInForce::FillOrKill, 1).status, OrderStatus::Killed);
+    EXPECT_EQ(restingShares(book, 2), 100);
+}
+
+TEST(OrderBookTests, ProRataRoundsDownAndHandsLeftoversToOldest) {
+    BasicBook<ProRataBookConfig> book;
+    book.addLimitOrder(1, false, 30, 100);
+    book.addLimitOrder(2, false, 30, 100);
+    book.addLimitOrder(3, false, 40, 100);
+
+    // Floors of 3.3, 3.3 and 4.4 leave one share for the oldest order
+    const BasicBook<ProRataBookConfig>::OrderResult result = book.addLimitOrder(4, true, 11, 100);
+    EXPECT_EQ(result.filledShares, 11);
+    EXPECT_FALSE(result.resting);
+    EXPECT_EQ(restingShares(book, 1), 26);
+    EXPECT_EQ(restingShares(book, 2), 27);
+    EXPECT_EQ(restingShares(book, 3), 36);
+}
+
+TEST(OrderBookTests, ProRataSweepsLevelsInPriceOrder) {
+    BasicBook<ProRataBookConfig> book;
+    book.addLimitOrder(1, false, 10, 100);
+    book.addLimitOrder(2, false, 30, 101);
+    book.addLimitOrder(3, false, 10, 101);
+
+    const BasicBook<ProRataBookConfig>::OrderResult result = book.addLimitOrder(4, true, 30, 101);
+    EXPECT_EQ(result.filledShares, 30);
+    EXPECT_EQ(book.searchOrderMap(1), nullptr);
+    EXPECT_EQ(restingShares(book, 2), 15);
+    EXPECT_EQ(restingShares(book, 3), 5);
+}
+
+TEST(OrderBookTests, FifoProRataFillsTopOrderFirst) {
+    BasicBook<FifoProRataBookConfig> book;
+    book.addLimitOrder(1, false, 20, 100);
+    book.addLimitOrder(2, false, 30, 100);
+    book.addLimitOrder(3, false, 50, 100);
+
+    // The head takes its 20 shares, 7.5 and 12.5 of the other 20 round down with the leftover to order 2
+    const BasicBook<FifoProRataBookConfig>::OrderResult result = book.marketOrder(4, true, 40);
+    EXPECT_EQ(result.filledShares, 40);
+    EXPECT_EQ(book.searchOrderMap(1), nullptr);
+    EXPECT_EQ(restingShares(book, 2), 22);
+    EXPECT_EQ(restingShares(book, 3), 38);
+}
+
+TEST(OrderBookTests, FifoProRataSmallOrderOnlyFillsTopOrder) {
+    BasicBook<FifoProRataBookConfig> book;
+    book.addLimitOrder(1, false, 20, 100);
+    book.addLimitOrder(2, false, 30, 100);
+
+    book.marketOrder(3, true, 15);
+    EXPECT_EQ(restingShares(book, 1), 5);
+    EXPECT_EQ(restingShares(book, 2), 30);
+}
+
+TEST(OrderBookTests, ProRataAllocatesIcebergsByDisplayedShares) {
+    BasicBook<ProRataBookConfig> book;
+    book.addIcebergOrder(1, false, 100, 100, 10);
+    book.addLimitOrder(2, false, 30, 100);
+
+    book.marketOrder(3, true, 20);
+    EXPECT_EQ(restingShares(book, 1), 5);
+    EXPECT_EQ(book.searchOrderMap(1)->getHiddenShares(book.getPools()), 90);
+    EXPECT_EQ(restingShares(book, 2), 15);
+}
+
+TEST(OrderBookTests, ProRataRefillsIcebergsUntilTheOrderIsFilled) {
+    BasicBook<ProRataBookConfig> book;
+    book.addIcebergOrder(1, false, 100, 100, 10);
+    book.addLimitOrder(2, false, 10, 100);
+
+    // Both displayed parts fill, then the refilled iceberg takes the rest alone
+    const BasicBook<ProRataBookConfig>::OrderResult result = book.marketOrder(3, true, 30);
+    EXPECT_EQ(result.filledShares, 30);
+    EXPECT_EQ(book.searchOrderMap(2), nullptr);
+    EXPECT_EQ(restingShares(book, 1), 10);
+    EXPECT_EQ(book.searchOrderMap(1)->getHiddenShares(book.getPools()), 70);
+}
+
+TEST(OrderBookTests, ImmediateOrCancelNeverRests) {
+    RecordingBook book;
+    book.addLimitOrder(1, false, 30, 100);
+
+    const RecordingBook::OrderResult result = book.addLimitOrder(2, true, 50, 101, TimeInForce::ImmediateOrCancel);
+    EXPECT_EQ(result.status, OrderStatus::Ok);
+    EXPECT_EQ(result.filledShares, 30);
+    EXPECT_EQ(result.remainingShares, 20);
+    EXPECT_FALSE(result.resting);
+    EXPECT_EQ(book.getHighestBuy(), nullptr);
+    EXPECT_EQ(book.searchOrderMap(2), nullptr);
+}
+
+TEST(OrderBookTests, FillOrKillOnlyFillsCompletely) {
+    RecordingBook book;
+    book.addLimitOrder(1, false, 30, 100);
+    book.addLimitOrder(2, false, 20, 102);
+
+    const RecordingBook::OrderResult killed = book.addLimitOrder(3, true, 40, 101, TimeInForce::FillOrKill);
+    EXPECT_EQ(killed.status, OrderStatus::Killed);
+    EXPECT_EQ(killed.filledShares, 0);
+    EXPECT_EQ(killed.remainingShares, 40);
+    EXPECT_TRUE(book.getEventSink().trades.empty());
+    EXPECT_EQ(restingShares(book, 1), 30);
+
+    const RecordingBook::OrderResult filled = book.addLimitOrder(4, true, 50, 102, TimeInForce::FillOrKill);
+    EXPECT_EQ(filled.status, OrderStatus::Ok);
+    EXPECT_EQ(filled.filledShares, 50);
+    EXPECT_EQ(filled.remainingShares, 0);
+    EXPECT_EQ(book.getLowestSell(), nullptr);
+}
+
+TEST(OrderBookTests, FillOrKillCountsIcebergReserve) {
+    RecordingBook book;
+    book.addIcebergOrder(1, false, 100, 100, 10);
+
+    EXPECT_EQ(book.addLimitOrder(2, true, 101, 100, TimeInForce::FillOrKill).status, OrderStatus::Killed);
+    const RecordingBook::OrderResult result = book.addLimitOrder(3, true, 100, 100, TimeInForce::FillOrKill);
+    EXPECT_EQ(result.status, OrderStatus::Ok);
+    EXPECT_EQ(result.filledShares, 100);
+}
+
+TEST(OrderBookTests, IcebergDisplaysOnlyItsPeak) {
+    RecordingBook book;
+    const RecordingBook::OrderResult result = book.addIcebergOrder(1, false, 100, 100, 10);
+    EXPECT_EQ(result.status, OrderStatus::Ok);
+    EXPECT_EQ(result.remainingShares, 100);
+    EXPECT_TRUE(result.resting);
+
+    const RecordingBook::Limit* level = book.searchLimitMaps(100, false);
+    ASSERT_NE(level, nullptr);
+    EXPECT_EQ(level->getTotalVolume(), 10);
+    EXPECT_EQ(level->getHiddenVolume(book.getPools()), 90);
+}
+
+TEST(OrderBookTests, IcebergRefillsAtTheBackOfItsLevel) {
+    RecordingBook book;
+    book.addIcebergOrder(1, false, 100, 100, 10);
+    book.addLimitOrder(2, false, 10, 100);
+
+    book.marketOrder(3, true, 10);
+    EXPECT_EQ(restingShares(book, 1), 10);
+    EXPECT_EQ(book.searchOrderMap(1)->getHiddenShares(book.getPools()), 80);
+    EXPECT_EQ(book.searchLimitMaps(100, false)->getHeadOrder(book.getPools())->getOrderId(book.getPools()), 2);
+
+    // The refilled iceberg lost its time priority to order 2
+    book.marketOrder(4, true, 5);
+    const std::vector<RecordingEventSink::Trade>& trades = book.getEventSink().trades;
+    ASSERT_EQ(trades.size(), 2u);
+    EXPECT_EQ(trades[1].restingOrderId, 2);
+    EXPECT_EQ(trades[1].shares, 5);
+}
+
+TEST(OrderBookTests, IcebergTradesItsReserveInOneOrder) {
+    RecordingBook book;
+    book.addIcebergOrder(1, false, 35, 100, 10);
+
+    const RecordingBook::OrderResult result = book.marketOrder(2, true, 40);
+    EXPECT_EQ(result.filledShares, 35);
+    EXPECT_EQ(result.remainingShares, 5);
+    EXPECT_EQ(book.getEventSink().trades.size(), 4u);
+    EXPECT_EQ(book.searchOrderMap(1), nullptr);
+    EXPECT_EQ(book.getLowestSell(), nullptr);
+}
+
+TEST(OrderBookTests, IncomingIcebergRestsItsRemainder) {
+    RecordingBook book;
+    book.addLimitOrder(1, false, 15, 100);
+
+    const RecordingBook::OrderResult result = book.addIcebergOrder(2, true, 50, 100, 20);
+    EXPECT_EQ(result.filledShares, 15);
+    EXPECT_EQ(result.remainingShares, 35);
+    EXPECT_TRUE(result.resting);
+    EXPECT_EQ(restingShares(book, 2), 20);
+    EXPECT_EQ(book.searchOrderMap(2)->getHiddenShares(book.getPools()), 15);
+}
+
+TEST(OrderBookTests, RandomOrderOnlySamplesLiveOrders) {
+    // getRandomOrder keeps 10000 limit orders and 500 stop orders in the book
+    constexpr int limitOrders = 10100;
+    constexpr int stopOrders = 600;
+    Book book;
+    for (int orderId = 1; orderId <= limitOrders; orderId++) {
+        book.addLimitOrder(orderId, orderId % 2 == 0, 10, orderId % 2 == 0 ? 1000 + orderId % 500 : 2000 + orderId % 500);
+    }
+    for (int orderId = limitOrders + 1; orderId <= limitOrders + stopOrders; orderId++) {
+        book.addStopOrder(orderId, true, 10, 5000);
+    }
+
+    std::set<int> gone;
+    for (int orderId = 2; orderId <= 100; orderId += 2) {
+        book.cancelLimitOrder(orderId);
+        gone.insert(orderId);
+    }
+    // Fills the 21 sells at 2001
+    book.marketOrder(0, true, 210);
+    for (int orderId = 1; orderId <= limitOrders; orderId += 500) {
+        gone.insert(orderId);
+    }
+    EXPECT_EQ(book.searchLimitMaps(2001, false), nullptr);
+
+    std::mt19937 gen(7);
+    const Book::Pools& pools = book.getPools();
+    for (int draw = 0; draw < 5000; draw++) {
+        const Book::Order* limitOrder = book.getRandomOrder(0, gen);
+        ASSERT_NE(limitOrder, nullptr);
+        EXPECT_EQ(gone.count(limitOrder->getOrderId(pools)), 0u);
+        EXPECT_EQ(book.searchOrderMap(limitOrder->getOrderId(pools)), limitOrder);
+
+        const Book::Order* stopOrder = book.getRandomOrder(1, gen);
+        ASSERT_NE(stopOrder, nullptr);
+        EXPECT_GT(stopOrder->getOrderId(pools), limitOrders);
+    }
+    // Too few stop limit orders to sample from
+    EXPECT_EQ(book.getRandomOrder(2, gen), nullptr);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../Process_Orders/Command.hpp"
+
+namespace {
+
+Command limitCommand(std::int32_t orderId) {
+    Command command = {};
+    command.type = CommandType::AddLimit;
+    command.orderId = orderId;
+    command.shares = 100;
+    command.price = 250 + orderId;
+    command.buyOrSell = orderId % 2 == 0;
+    return command;
+}
+
+// A binary command file of count limit orders followed by the raw bytes of tail
+std::string writeBinary(const std::string& name, int count, const std::string& tail = "") {
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    CommandWriter writer;
+    EXPECT_TRUE(writer.open(path, CommandFormat::Binary));
+    for (int i = 1; i <= count; i++) {
+        writer.write(limitCommand(i));
+    }
+    writer.writeRaw(tail.data(), tail.size());
+    writer.close();
+    return path;
+}
+
+}
+
+TEST(OrdersTests, BinaryCommandsRoundTrip) {
+    std::vector<Command> commands;
+    ASSERT_TRUE(readCommandFile(writeBinary("orders_tests_commands.bin", 3), commands));
+    ASSERT_EQ(commands.size(), 3u);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(commands[i].type, CommandType::AddLimit);
+        EXPECT_EQ(commands[i].orderId, i + 1);
+        EXPECT_EQ(commands[i].price, 251 + i);
+        EXPECT_EQ(commands[i].buyOrSell, (i + 1) % 2 == 0);
+    }
+}
+
+TEST(OrdersTests, TruncatedFinalRecordIsAnError) {
+    const Command command = limitCommand(4);
+    const std::string partial(reinterpret_cast<const char*>(&command), sizeof(Command) - 5);
+    const std::string path = writeBinary("orders_tests_commands.bin", 2, partial);
+
+    CommandReader reader;
+    ASSERT_TRUE(reader.open(path));
+    Command read;
+    EXPECT_TRUE(reader.read(read));
+    EXPECT_TRUE(reader.read(read));
+    EXPECT_FALSE(reader.read(read));
+    EXPECT_TRUE(reader.failed());
+
+    std::vector<Command> commands;
+    EXPECT_FALSE(readCommandFile(path, commands));
+}
+
+TEST(OrdersTests, UnknownCommandTypeIsAnError) {
+    Command command = limitCommand(3);
+    command.type = static_cast<CommandType>(commandTypeCount);
+    const std::string record(reinterpret_cast<const char*>(&command), sizeof(Command));
+    std::vector<Command> commands;
+    EXPECT_FALSE(readCommandFile(writeBinary("orders_tests_commands.bin", 2, record), commands));
+
+    // A clean end of file isn't an error
+    CommandReader reader;
+    ASSERT_TRUE(reader.open(writeBinary("orders_tests_commands.bin", 1)));
+    Command read;
+    EXPECT_TRUE(reader.read(read));
+    EXPECT_FALSE(reader.read(read));
+    EXPECT_FALSE(reader.failed());
+}
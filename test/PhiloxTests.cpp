@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "../Forecaster/Philox.hpp"
+
+namespace {
+
+// Counter words, key words and output of the philox4x32_10 known answer tests of Random123
+struct KnownAnswer {
+    uint32_t counter[4];
+    uint32_t key[2];
+    uint32_t output[4];
+};
+
+const KnownAnswer knownAnswers[] = {
+    { { 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u }, { 0x00000000u, 0x00000000u },
+        { 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u } },
+    { { 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu }, { 0xffffffffu, 0xffffffffu },
+        { 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu } },
+    { { 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u }, { 0xa4093822u, 0x299f31d0u },
+        { 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u } },
+};
+
+}
+
+TEST(PhiloxTests, MatchesRandom123KnownAnswers) {
+    for (const KnownAnswer& answer : knownAnswers) {
+        const uint64_t seed = answer.key[0] | static_cast<uint64_t>(answer.key[1]) << 32;
+        const philox::Output output = philox::generate({ answer.counter[0], answer.counter[1], answer.counter[2], answer.counter[3] }, seed);
+        for (int word = 0; word < 4; word++) {
+            EXPECT_EQ(output.word[word], answer.output[word]) << "word " << word;
+        }
+    }
+}
+
+// The vectorized loop over lanes gives every lane the draws of its own path
+TEST(PhiloxTests, FillNormalsMatchesScalarDraws) {
+    constexpr uint64_t seed = 0x5EEDF0CA57ull;
+    constexpr uint32_t stream = 0;
+    constexpr int32_t steps = 8;
+    uint64_t paths[simdLanes];
+    for (int lane = 0; lane < simdLanes; lane++) {
+        paths[lane] = 0x100000000ull * lane + 3 * lane + 1;
+    }
+    std::vector<float> normals(static_cast<size_t>(steps) * simdLanes);
+    philox::fillNormals(seed, paths, stream, steps, normals.data());
+
+    for (int lane = 0; lane < simdLanes; lane++) {
+        for (int32_t group = 0; group < steps / 4; group++) {
+            const philox::Output output = philox::generate({ static_cast<uint32_t>(group), static_cast<uint32_t>(paths[lane]),
+                static_cast<uint32_t>(paths[lane] >> 32), stream }, seed);
+            float draws[4];
+            philox::boxMuller(output.word[0], output.word[1], draws[0], draws[1]);
+            philox::boxMuller(output.word[2], output.word[3], draws[2], draws[3]);
+            for (int step = 0; step < 4; step++) {
+                EXPECT_FLOAT_EQ(normals[static_cast<size_t>(group * 4 + step) * simdLanes + lane], draws[step]) << "lane " << lane << " step " << group * 4 + step;
+            }
+        }
+    }
+}